@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <esp_heap_caps.h>
 #include <esp_log.h>
 #include "ai_app.h"
@@ -213,14 +214,20 @@ char *BaseAIModel::BaseAIModel_GetImgName() {
 }
 
 BaseAIModelConfig_t* BaseAIModel::BaseAIModel_SdcardReadAIModelConfig() {
-    uint8_t *sdcard_buffer = (uint8_t *)malloc(1024);
+    /*config.txt 中还有 render 等配置,按文件实际大小申请*/
+    struct stat st;
+    if (stat("/sdcard/06_user_foundation_img/config.txt", &st) != 0 || st.st_size <= 0) {
+        return NULL;
+    }
+    uint8_t *sdcard_buffer = (uint8_t *)calloc(1, st.st_size + 1);
     assert(sdcard_buffer);
-    if(SDPort_->SDPort_ReadFile("/sdcard/06_user_foundation_img/config.txt", sdcard_buffer, NULL) != ESP_OK) {
+    size_t sdcard_len = 0;
+    if(SDPort_->SDPort_ReadFile("/sdcard/06_user_foundation_img/config.txt", sdcard_buffer, &sdcard_len) != ESP_OK || sdcard_len > (size_t) st.st_size) {
         free(sdcard_buffer);
         sdcard_buffer = NULL;
         return NULL;
     }
-    DeserializationError error = deserializeJson(doc, sdcard_buffer);
+    DeserializationError error = deserializeJson(doc, (const char *) sdcard_buffer, sdcard_len);
     free(sdcard_buffer);
     sdcard_buffer = NULL;
     if (error) {
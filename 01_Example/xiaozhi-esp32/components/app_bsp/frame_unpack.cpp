@@ -0,0 +1,122 @@
+#include <string.h>
+#include "frame_unpack.h"
+
+FrameUnpacker::FrameUnpacker(uint8_t *dst, size_t len, FrameUpFormat format) :
+dst_(dst),
+len_(len),
+format_(format) {
+}
+
+/*重叠复制(offset 小于长度)时必须逐字节,重复的是刚写出的数据*/
+bool FrameUnpacker::FrameUnpacker_Match() {
+    if (offset_ == 0 || offset_ > out_ || match_ > len_ - out_) {
+        return false;
+    }
+    const uint8_t *src = dst_ + out_ - offset_;
+    uint8_t       *dst = dst_ + out_;
+    if (offset_ >= match_) {
+        memcpy(dst, src, match_);
+    } else {
+        for (size_t i = 0; i < match_; i++) {
+            dst[i] = src[i];
+        }
+    }
+    out_ += match_;
+    return true;
+}
+
+bool FrameUnpacker::FrameUnpacker_Feed(const uint8_t *data, size_t len) {
+    if (state_ == StateError) {
+        return false;
+    }
+    if (format_ == FrameUpRaw) {
+        if (len > len_ - out_) {
+            state_ = StateError;
+            return false;
+        }
+        memcpy(dst_ + out_, data, len);
+        out_ += len;
+        return true;
+    }
+    size_t pos = 0;
+    while (pos < len) {
+        switch (state_) {
+        case StateToken:
+            token_   = data[pos++];
+            literal_ = token_ >> 4;
+            state_   = (literal_ == 15) ? StateLiteralLen : (literal_ ? StateLiterals : StateOffsetLo);
+            break;
+        case StateLiteralLen: {
+            uint8_t b = data[pos++];
+            literal_ += b;
+            if (b != 255) {
+                state_ = StateLiterals;
+            }
+            break;
+        }
+        case StateLiterals: {
+            size_t n = len - pos < literal_ ? len - pos : literal_;
+            if (n > len_ - out_) {
+                state_ = StateError;
+                return false;
+            }
+            memcpy(dst_ + out_, data + pos, n);
+            out_     += n;
+            pos      += n;
+            literal_ -= n;
+            if (literal_ == 0) {
+                state_ = StateOffsetLo;
+            }
+            break;
+        }
+        case StateOffsetLo:
+            offset_ = data[pos++];
+            state_  = StateOffsetHi;
+            break;
+        case StateOffsetHi:
+            offset_ |= (size_t) data[pos++] << 8;
+            match_   = (token_ & 0x0F) + 4;
+            if ((token_ & 0x0F) == 15) {
+                state_ = StateMatchLen;
+            } else if (FrameUnpacker_Match()) {
+                state_ = StateToken;
+            } else {
+                state_ = StateError;
+                return false;
+            }
+            break;
+        case StateMatchLen: {
+            uint8_t b = data[pos++];
+            match_ += b;
+            if (b != 255) {
+                if (!FrameUnpacker_Match()) {
+                    state_ = StateError;
+                    return false;
+                }
+                state_ = StateToken;
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FrameUnpacker::FrameUnpacker_Commit(size_t len) {
+    if (format_ != FrameUpRaw || state_ == StateError || len > len_ - out_) {
+        state_ = StateError;
+        return false;
+    }
+    out_ += len;
+    return true;
+}
+
+/*LZ4 块以只有字面量的序列结束,写满时应停在等待偏移量的位置*/
+bool FrameUnpacker::FrameUnpacker_Done() {
+    if (out_ != len_) {
+        return false;
+    }
+    return format_ == FrameUpRaw || state_ == StateOffsetLo || state_ == StateToken;
+}
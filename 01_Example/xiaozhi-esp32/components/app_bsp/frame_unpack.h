@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FRAME_UP_MAGIC 0x34425046      /*"PFB4"*/
+
+enum FrameUpFormat {
+    FrameUpRaw = 0,     /*未压缩的 4bpp 面板帧*/
+    FrameUpLz4,         /*LZ4 块格式(不带帧头),解压后为 4bpp 面板帧*/
+};
+
+/*/frameUP 请求体开头的头部,小端*/
+typedef struct {
+    uint32_t magic;
+    uint8_t  format;        /*FrameUpFormat*/
+    uint8_t  rotation;      /*同 Set_Rotation,0 为面板原生方向*/
+    uint16_t reserved;
+    uint32_t rawLen;        /*解压后的长度,必须等于面板帧大小*/
+} __attribute__((packed)) FrameUpHeader_t;
+
+/*
+ * 把分段到达的帧数据直接写进目标缓冲区,raw 为拷贝,LZ4 为流式解压
+ * LZ4 的回溯引用直接从目标缓冲区中已解出的数据复制,不需要额外窗口
+ */
+class FrameUnpacker
+{
+private:
+    enum State {
+        StateToken = 0,
+        StateLiteralLen,
+        StateLiterals,
+        StateOffsetLo,
+        StateOffsetHi,
+        StateMatchLen,
+        StateError,
+    };
+
+    uint8_t      *dst_;
+    size_t        len_;
+    size_t        out_      = 0;
+    FrameUpFormat format_;
+    State         state_    = StateToken;
+    uint8_t       token_    = 0;
+    size_t        literal_  = 0;        /*本段剩余的字面量字节数*/
+    size_t        match_    = 0;
+    size_t        offset_   = 0;
+
+    bool FrameUnpacker_Match();
+
+public:
+    FrameUnpacker(uint8_t *dst, size_t len, FrameUpFormat format);
+
+    bool FrameUnpacker_Feed(const uint8_t *data, size_t len);     /*数据损坏或超出目标长度时返回false*/
+    bool FrameUnpacker_Commit(size_t len);                       /*raw:调用者已直接收到 dst + Out() 处的字节*/
+    bool FrameUnpacker_Done();                                   /*目标缓冲区已写满且压缩流在序列边界结束*/
+    size_t FrameUnpacker_Out() { return out_; }
+};
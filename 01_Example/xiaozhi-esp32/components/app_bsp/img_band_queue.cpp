@@ -0,0 +1,48 @@
+#include <esp_log.h>
+#include "img_band_queue.h"
+
+ImgBandQueue::~ImgBandQueue() {
+    if (freeQ_ != NULL) {
+        vQueueDelete(freeQ_);
+    }
+    if (fullQ_ != NULL) {
+        vQueueDelete(fullQ_);
+    }
+}
+
+size_t ImgBandQueue::ImgBandQueue_MemSize(size_t row_bytes, int band_rows, int bands) {
+    return row_bytes * band_rows * bands;
+}
+
+bool ImgBandQueue::ImgBandQueue_Init(uint8_t *mem, size_t row_bytes, int band_rows, int bands) {
+    freeQ_ = xQueueCreate(bands, sizeof(uint8_t *));
+    fullQ_ = xQueueCreate(bands + 1, sizeof(ImgBand_t));
+    if (freeQ_ == NULL || fullQ_ == NULL) {
+        ESP_LOGE(TAG, "queue create fill");
+        return false;
+    }
+    bandRows_ = band_rows;
+    for (int i = 0; i < bands; i++) {
+        uint8_t *rows = mem + row_bytes * band_rows * i;
+        xQueueSend(freeQ_, &rows, 0);
+    }
+    return true;
+}
+
+uint8_t *ImgBandQueue::ImgBandQueue_Acquire() {
+    uint8_t *rows = NULL;
+    xQueueReceive(freeQ_, &rows, portMAX_DELAY);
+    return rows;
+}
+
+void ImgBandQueue::ImgBandQueue_Submit(const ImgBand_t *band) {
+    xQueueSend(fullQ_, band, portMAX_DELAY);
+}
+
+void ImgBandQueue::ImgBandQueue_Receive(ImgBand_t *band) {
+    xQueueReceive(fullQ_, band, portMAX_DELAY);
+}
+
+void ImgBandQueue::ImgBandQueue_Release(uint8_t *rows) {
+    xQueueSend(freeQ_, &rows, portMAX_DELAY);
+}
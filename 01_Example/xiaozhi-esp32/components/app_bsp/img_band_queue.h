@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+/*一个行带:rows 指向 band 缓冲区,count 为0表示生产者已结束*/
+typedef struct {
+    uint8_t *rows;
+    int      y;         /*第一行的行号*/
+    int      count;
+} ImgBand_t;
+
+/*
+ * 生产者/消费者之间的有界行带队列:固定数量的 band 缓冲区在两个队列之间循环
+ * 空闲队列为空时生产者阻塞,所以生产者最多领先消费者 bands 个行带,内存不随图片大小增长
+ * 缓冲区内存由调用者提供(一般来自渲染内存池),大小见 ImgBandQueue_MemSize
+ */
+class ImgBandQueue
+{
+private:
+    const char   *TAG      = "ImgBandQueue";
+    QueueHandle_t freeQ_   = NULL;     /*空闲的 band 缓冲区指针*/
+    QueueHandle_t fullQ_   = NULL;     /*已填充的 ImgBand_t,多留一项给结束标记*/
+    int           bandRows_ = 0;
+
+public:
+    ~ImgBandQueue();
+
+    static size_t ImgBandQueue_MemSize(size_t row_bytes, int band_rows, int bands);
+    bool          ImgBandQueue_Init(uint8_t *mem, size_t row_bytes, int band_rows, int bands);
+    int           ImgBandQueue_BandRows() { return bandRows_; }
+
+    uint8_t *ImgBandQueue_Acquire();                    /*生产者:取一个空闲缓冲区,没有时阻塞*/
+    void     ImgBandQueue_Submit(const ImgBand_t *band); /*生产者:交给消费者,count为0表示结束*/
+    void     ImgBandQueue_Receive(ImgBand_t *band);      /*消费者:取下一个行带,没有时阻塞*/
+    void     ImgBandQueue_Release(uint8_t *rows);        /*消费者:用完后归还缓冲区*/
+};
@@ -0,0 +1,110 @@
+#include <math.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "img_palette.h"
+
+#define IMG_PALETTE_LUT_SIZE 32768
+
+static const ImgPaletteProfile_t PaletteProfiles[] = {
+    /*理想的sRGB原色*/
+    {"ideal", {{0, 0, 0}, {255, 255, 255}, {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}}},
+    /*Spectra 6 面板实测颜色*/
+    {"spectra6", {{25, 30, 33}, {232, 232, 232}, {178, 19, 24}, {18, 95, 32}, {33, 87, 186}, {239, 222, 68}}},
+};
+
+typedef struct {
+    float L;
+    float a;
+    float b;
+} OkLab_t;
+
+static float ImgPalette_SrgbToLinear(float c) {
+    c /= 255.0f;
+    return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static OkLab_t ImgPalette_LinearToOkLab(float r, float g, float b) {
+    float   l  = cbrtf(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float   m  = cbrtf(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float   s  = cbrtf(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+    OkLab_t lab;
+    lab.L = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    lab.a = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    lab.b = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+    return lab;
+}
+
+ImgPalette::ImgPalette() :
+profile_(&PaletteProfiles[0]) {
+}
+
+ImgPalette::~ImgPalette() {
+    if (lut_ != NULL) {
+        heap_caps_free(lut_);
+        lut_ = NULL;
+    }
+}
+
+bool ImgPalette::ImgPalette_Select(const char *name) {
+    for (size_t i = 0; i < sizeof(PaletteProfiles) / sizeof(PaletteProfiles[0]); i++) {
+        if (!strcmp(PaletteProfiles[i].name, name)) {
+            if (profile_ != &PaletteProfiles[i]) {
+                profile_ = &PaletteProfiles[i];
+                dirty_   = true;
+            }
+            return true;
+        }
+    }
+    ESP_LOGW(TAG, "unknown palette:%s", name);
+    return false;
+}
+
+const char *ImgPalette::ImgPalette_GetName() {
+    return profile_->name;
+}
+
+void ImgPalette::ImgPalette_BuildLut() {
+    OkLab_t ink[IMG_PALETTE_COLORS];
+    float   lin[32];
+    for (int i = 0; i < IMG_PALETTE_COLORS; i++) {
+        ink[i] = ImgPalette_LinearToOkLab(ImgPalette_SrgbToLinear(profile_->ink[i][0]), ImgPalette_SrgbToLinear(profile_->ink[i][1]),
+                                          ImgPalette_SrgbToLinear(profile_->ink[i][2]));
+    }
+    for (int i = 0; i < 32; i++) {
+        lin[i] = ImgPalette_SrgbToLinear((float) (i * 8 + 4));  /*取每个5bit区间的中点*/
+    }
+    for (int idx = 0; idx < IMG_PALETTE_LUT_SIZE; idx++) {
+        OkLab_t c         = ImgPalette_LinearToOkLab(lin[idx >> 10], lin[(idx >> 5) & 31], lin[idx & 31]);
+        int     best      = 0;
+        float   best_dist = 1e9f;
+        for (int i = 0; i < IMG_PALETTE_COLORS; i++) {
+            float dL   = c.L - ink[i].L;
+            float da   = c.a - ink[i].a;
+            float db   = c.b - ink[i].b;
+            float dist = dL * dL + da * da + db * db;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best      = i;
+            }
+        }
+        lut_[idx] = (uint8_t) best;
+    }
+}
+
+bool ImgPalette::ImgPalette_Prepare() {
+    if (lut_ == NULL) {
+        lut_ = (uint8_t *) heap_caps_malloc(IMG_PALETTE_LUT_SIZE, MALLOC_CAP_SPIRAM);
+        if (lut_ == NULL) {
+            ESP_LOGE(TAG, "lut alloc fail");
+            return false;
+        }
+        dirty_ = true;
+    }
+    if (dirty_) {
+        ImgPalette_BuildLut();
+        dirty_ = false;
+        ESP_LOGI(TAG, "palette:%s", profile_->name);
+    }
+    return true;
+}
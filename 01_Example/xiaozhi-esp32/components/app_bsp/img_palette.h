@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+#define IMG_PALETTE_COLORS 6
+
+/*墨水屏实际能显示的颜色,顺序与抖动输出的 PALETTE 一致: Black, White, Red, Green, Blue, Yellow*/
+typedef struct {
+    const char *name;
+    uint8_t     ink[IMG_PALETTE_COLORS][3];
+} ImgPaletteProfile_t;
+
+/*
+ * 调色板配置:抖动时按实测墨水颜色计算误差,输出仍为 PALETTE 中的理想颜色(显示驱动按理想颜色识别)
+ * 最近颜色在 OKLab 空间中比较,切换配置时预先算好 RGB555 -> 颜色序号 的查找表,运行时只查表
+ */
+class ImgPalette
+{
+private:
+    const char                *TAG      = "ImgPalette";
+    const ImgPaletteProfile_t *profile_ = NULL;
+    uint8_t                   *lut_     = NULL;   /*32768项*/
+    bool                       dirty_   = true;
+
+    void ImgPalette_BuildLut();
+
+public:
+    ImgPalette();
+    ~ImgPalette();
+
+    bool        ImgPalette_Select(const char *name);   /*未知名称返回false,保持当前配置*/
+    const char *ImgPalette_GetName();
+    bool        ImgPalette_Prepare();                  /*需要时生成查找表,内存不足返回false*/
+
+    inline int ImgPalette_Nearest(uint8_t r, uint8_t g, uint8_t b) {
+        return lut_[((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)];
+    }
+    inline const uint8_t *ImgPalette_Ink(int index) {
+        return profile_->ink[index];
+    }
+};
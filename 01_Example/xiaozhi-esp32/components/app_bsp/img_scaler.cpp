@@ -0,0 +1,193 @@
+#include <string.h>
+#include "img_scaler.h"
+
+#define SCALER_AREA_RATIO_X2 3     /*源/目标 > 1.5 时使用区域平均,比较时两边都乘2*/
+#define SCALER_WEIGHT_ONE    256
+#define SCALER_ALIGN(x)      (((x) + 15) & ~(size_t) 15)
+
+/*一个目标像素最多覆盖的源像素数*/
+int ImgScaler::ImgScaler_Taps(int src, int dst) {
+    if (src * 2 > dst * SCALER_AREA_RATIO_X2) {
+        return (src + dst - 1) / dst + 1;
+    }
+    return 2;
+}
+
+/*
+ * 区域平均:目标像素 i 覆盖源区间 [i*src/dst, (i+1)*src/dst),权重为重叠长度
+ * 双线性:按像素中心对齐,取相邻两个源像素
+ * 权重量化到8位,误差补到最大的一个权重上,保证每组之和正好为256
+ */
+void ImgScaler::ImgScaler_BuildTaps(int src, int dst, int taps, int32_t *start, uint16_t *weight) {
+    bool area = src * 2 > dst * SCALER_AREA_RATIO_X2;
+    for (int i = 0; i < dst; i++) {
+        uint16_t *w = weight + i * taps;
+        memset(w, 0, taps * sizeof(uint16_t));
+        if (area) {
+            int64_t lo  = (int64_t) i * src;          /*以 1/dst 个源像素为单位*/
+            int64_t hi  = (int64_t) (i + 1) * src;
+            int     s   = (int) (lo / dst);
+            int     sum = 0;
+            int     big = 0;
+            start[i]    = s;
+            for (int k = 0; k < taps && s + k < src; k++) {
+                int64_t pl = (int64_t) (s + k) * dst;
+                int64_t ph = pl + dst;
+                int64_t ov = (ph < hi ? ph : hi) - (pl > lo ? pl : lo);
+                if (ov <= 0) {
+                    continue;
+                }
+                w[k] = (uint16_t) ((ov * SCALER_WEIGHT_ONE + src / 2) / src);
+                sum += w[k];
+                big = (w[k] > w[big]) ? k : big;
+            }
+            w[big] += SCALER_WEIGHT_ONE - sum;
+        } else {
+            /*中心对齐的源坐标,定点 1/256*/
+            int32_t pos = (int32_t) ((((int64_t) i * 2 + 1) * src * SCALER_WEIGHT_ONE / dst - SCALER_WEIGHT_ONE) / 2);
+            if (pos < 0) {
+                pos = 0;
+            }
+            int s = pos / SCALER_WEIGHT_ONE;
+            int f = pos % SCALER_WEIGHT_ONE;
+            if (s >= src - 1) {
+                s = src - 1;
+                f = 0;
+            }
+            start[i] = s;
+            w[0]     = (uint16_t) (SCALER_WEIGHT_ONE - f);
+            w[1]     = (uint16_t) f;
+        }
+    }
+}
+
+size_t ImgScaler::ImgScaler_WorkSize(int src_w, int src_h, int dst_w, int dst_h) {
+    int tx = ImgScaler_Taps(src_w, dst_w);
+    int ty = ImgScaler_Taps(src_h, dst_h);
+    return SCALER_ALIGN(dst_w * sizeof(int32_t)) + SCALER_ALIGN((size_t) dst_w * tx * sizeof(uint16_t)) +
+           SCALER_ALIGN(dst_h * sizeof(int32_t)) + SCALER_ALIGN((size_t) dst_h * ty * sizeof(uint16_t)) +
+           SCALER_ALIGN((size_t) ty * dst_w * 3 * sizeof(uint16_t)) + SCALER_ALIGN((size_t) dst_w * 3 * sizeof(uint32_t)) +
+           SCALER_ALIGN((size_t) dst_w * 3);
+}
+
+bool ImgScaler::ImgScaler_Begin(int src_w, int src_h, int dst_w, int dst_h, uint8_t *work, RowSink sink, void *ctx) {
+    if (work == NULL || sink == NULL || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) {
+        return false;
+    }
+    srcW_     = src_w;
+    srcH_     = src_h;
+    dstW_     = dst_w;
+    dstH_     = dst_h;
+    tapsX_    = ImgScaler_Taps(src_w, dst_w);
+    tapsY_    = ImgScaler_Taps(src_h, dst_h);
+    ringRows_ = tapsY_;
+    srcY_     = 0;
+    nextY_    = 0;
+    sink_     = sink;
+    ctx_      = ctx;
+
+    uint8_t *p = work;
+    startX_    = (int32_t *) p;
+    p += SCALER_ALIGN(dst_w * sizeof(int32_t));
+    weightX_ = (uint16_t *) p;
+    p += SCALER_ALIGN((size_t) dst_w * tapsX_ * sizeof(uint16_t));
+    startY_ = (int32_t *) p;
+    p += SCALER_ALIGN(dst_h * sizeof(int32_t));
+    weightY_ = (uint16_t *) p;
+    p += SCALER_ALIGN((size_t) dst_h * tapsY_ * sizeof(uint16_t));
+    ring_ = (uint16_t *) p;
+    p += SCALER_ALIGN((size_t) ringRows_ * dst_w * 3 * sizeof(uint16_t));
+    acc_ = (uint32_t *) p;
+    p += SCALER_ALIGN((size_t) dst_w * 3 * sizeof(uint32_t));
+    outRow_ = p;
+
+    ImgScaler_BuildTaps(src_w, dst_w, tapsX_, startX_, weightX_);
+    ImgScaler_BuildTaps(src_h, dst_h, tapsY_, startY_, weightY_);
+    return true;
+}
+
+void ImgScaler::ImgScaler_HorizontalRow(const uint8_t *rgb, uint16_t *out) {
+    if (tapsX_ == 2) {
+        for (int x = 0; x < dstW_; x++) {
+            const uint8_t  *s  = rgb + startX_[x] * 3;
+            const uint16_t *w  = weightX_ + x * 2;
+            uint32_t        w0 = w[0], w1 = w[1];
+            if (w1 == 0) {
+                out[0] = (uint16_t) (s[0] * w0);
+                out[1] = (uint16_t) (s[1] * w0);
+                out[2] = (uint16_t) (s[2] * w0);
+            } else {
+                out[0] = (uint16_t) (s[0] * w0 + s[3] * w1);
+                out[1] = (uint16_t) (s[1] * w0 + s[4] * w1);
+                out[2] = (uint16_t) (s[2] * w0 + s[5] * w1);
+            }
+            out += 3;
+        }
+        return;
+    }
+    for (int x = 0; x < dstW_; x++) {
+        const uint8_t  *s = rgb + startX_[x] * 3;
+        const uint16_t *w = weightX_ + x * tapsX_;
+        uint32_t        r = 0, g = 0, b = 0;
+        for (int k = 0; k < tapsX_; k++) {
+            if (w[k]) {
+                r += s[k * 3 + 0] * w[k];
+                g += s[k * 3 + 1] * w[k];
+                b += s[k * 3 + 2] * w[k];
+            }
+        }
+        out[0] = (uint16_t) r;
+        out[1] = (uint16_t) g;
+        out[2] = (uint16_t) b;
+        out += 3;
+    }
+}
+
+/*按源行累加,内层循环是连续内存,便于编译器向量化*/
+void ImgScaler::ImgScaler_EmitRow(int y) {
+    const uint16_t *w     = weightY_ + y * tapsY_;
+    int             start = startY_[y];
+    int             n     = dstW_ * 3;
+    memset(acc_, 0, n * sizeof(uint32_t));
+    for (int k = 0; k < tapsY_; k++) {
+        uint32_t wk = w[k];
+        if (wk == 0) {
+            continue;
+        }
+        const uint16_t *row = ring_ + ((start + k) % ringRows_) * n;
+        for (int x = 0; x < n; x++) {
+            acc_[x] += row[x] * wk;
+        }
+    }
+    for (int x = 0; x < n; x++) {
+        outRow_[x] = (uint8_t) ((acc_[x] + (1 << 15)) >> 16);
+    }
+    sink_(ctx_, y, outRow_);
+}
+
+int ImgScaler::ImgScaler_PushRow(const uint8_t *rgb) {
+    if (srcY_ >= srcH_) {
+        return 0;
+    }
+    ImgScaler_HorizontalRow(rgb, ring_ + (srcY_ % ringRows_) * dstW_ * 3);
+    int emitted = 0;
+    /*最后一个非零权重的源行已经到达的目标行都可以输出*/
+    while (nextY_ < dstH_) {
+        const uint16_t *w    = weightY_ + nextY_ * tapsY_;
+        int             last = tapsY_ - 1;
+        while (last > 0 && w[last] == 0) {
+            last--;
+        }
+        if (startY_[nextY_] + last > srcY_) {
+            break;
+        }
+        ImgScaler_EmitRow(nextY_++);
+        emitted++;
+    }
+    srcY_++;
+    return emitted;
+}
+
+bool ImgScaler::ImgScaler_IsDone() {
+    return nextY_ >= dstH_;
+}
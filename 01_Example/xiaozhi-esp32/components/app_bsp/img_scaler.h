@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 可分离的定点缩放器:源图按行输入,目标行一旦凑齐就通过回调输出
+ * 每个方向单独选择滤波器:缩小超过1.5倍用区域平均(抗混叠),否则用双线性
+ * 内部只保留滤波器覆盖范围内的若干行(水平滤波后的结果),不需要整帧源图
+ * 工作内存由调用者提供,大小见 ImgScaler_WorkSize
+ */
+class ImgScaler
+{
+public:
+    typedef void (*RowSink)(void *ctx, int y, const uint8_t *rgb);    /*rgb: 一行 dst_w 个RGB888像素*/
+
+private:
+    int       srcW_ = 0, srcH_ = 0;
+    int       dstW_ = 0, dstH_ = 0;
+    int       tapsX_ = 0, tapsY_ = 0;           /*每个目标像素/行最多用到的源像素/行数*/
+    int       ringRows_ = 0;
+    int       srcY_  = 0;                       /*下一行输入的源行号*/
+    int       nextY_ = 0;                       /*下一行要输出的目标行号*/
+    RowSink   sink_ = NULL;
+    void     *ctx_  = NULL;
+    int32_t  *startX_ = NULL;
+    uint16_t *weightX_ = NULL;                  /*[dstW_][tapsX_],每组之和为256*/
+    int32_t  *startY_ = NULL;
+    uint16_t *weightY_ = NULL;                  /*[dstH_][tapsY_]*/
+    uint16_t *ring_ = NULL;                     /*ringRows_ 行水平滤波结果,值为像素*256*/
+    uint32_t *acc_ = NULL;                      /*垂直方向累加*/
+    uint8_t  *outRow_ = NULL;
+
+    static int  ImgScaler_Taps(int src, int dst);
+    static void ImgScaler_BuildTaps(int src, int dst, int taps, int32_t *start, uint16_t *weight);
+    void        ImgScaler_HorizontalRow(const uint8_t *rgb, uint16_t *out);
+    void        ImgScaler_EmitRow(int y);
+
+public:
+    static size_t ImgScaler_WorkSize(int src_w, int src_h, int dst_w, int dst_h);
+    bool          ImgScaler_Begin(int src_w, int src_h, int dst_w, int dst_h, uint8_t *work, RowSink sink, void *ctx);
+    int           ImgScaler_PushRow(const uint8_t *rgb);       /*输入下一行源像素,返回本次输出的目标行数*/
+    bool          ImgScaler_IsDone();
+};
@@ -0,0 +1,114 @@
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "img_source.h"
+#include "render_arena.h"
+
+#define CLAMP(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+ImgDecoderRegistry imgDecoderRegistry;
+
+ImgRowSource::~ImgRowSource() {
+    for (int i = 0; i < heapCount_; i++) {
+        heap_caps_free(heap_[i]);
+    }
+    if (fp_ != NULL) {
+        fclose(fp_);
+        fp_ = NULL;
+    }
+}
+
+void ImgRowSource::ImgSource_Attach(FILE *fp, RenderArena *arena) {
+    fp_    = fp;
+    arena_ = arena;
+}
+
+void *ImgRowSource::ImgSource_Alloc(size_t size) {
+    if (arena_ != NULL && arena_->RenderArena_IsReserved()) {
+        void *buf = arena_->RenderArena_Alloc(size);
+        if (buf != NULL) {
+            return buf;
+        }
+    }
+    if (heapCount_ >= IMG_SOURCE_HEAP_MAX) {
+        ESP_LOGE(TAG, "too many buffers");
+        return NULL;
+    }
+    void *buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (buf != NULL) {
+        heap_[heapCount_++] = buf;
+    }
+    return buf;
+}
+
+ImgRect_t ImgRowSource::ImgSource_ClipRect(const ImgRect_t *crop, int width, int height) {
+    ImgRect_t rect = {0, 0, width, height};
+    if (crop != NULL) {
+        rect.x = CLAMP(crop->x, 0, width - 1);
+        rect.y = CLAMP(crop->y, 0, height - 1);
+        rect.w = CLAMP(crop->w, 1, width - rect.x);
+        rect.h = CLAMP(crop->h, 1, height - rect.y);
+    }
+    return rect;
+}
+
+ImgDecoderRegistry::ImgDecoderRegistry() {
+    ImgDecoderRegistry_Register(&ImgSourceJpgEntry);
+    ImgDecoderRegistry_Register(&ImgSourcePngEntry);
+    ImgDecoderRegistry_Register(&ImgSourceBmpEntry);
+}
+
+bool ImgDecoderRegistry::ImgDecoderRegistry_Register(const ImgDecoderEntry_t *entry) {
+    if (entry->create == NULL) {
+        ESP_LOGI(TAG, "%s decoder not built, skipped", entry->name);
+        return false;
+    }
+    if (count_ >= IMG_DECODER_MAX) {
+        ESP_LOGE(TAG, "registry full, drop:%s", entry->name);
+        return false;
+    }
+    entries_[count_++] = entry;
+    return true;
+}
+
+ImgRowSource *ImgDecoderRegistry::ImgDecoderRegistry_Open(const char *path, RenderArena *arena) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file: %s", path);
+        return NULL;
+    }
+    ImgRowSource *src = ImgDecoderRegistry_OpenFile(fp, arena);
+    if (src == NULL) {
+        ESP_LOGE(TAG, "unsupported image:%s", path);
+    }
+    return src;
+}
+
+const ImgDecoderEntry_t *ImgDecoderRegistry::ImgDecoderRegistry_Find(const uint8_t *head, size_t len) {
+    for (int i = 0; i < count_; i++) {
+        if (entries_[i]->sniff(head, len)) {
+            return entries_[i];
+        }
+    }
+    return NULL;
+}
+
+ImgRowSource *ImgDecoderRegistry::ImgDecoderRegistry_OpenFile(FILE *fp, RenderArena *arena) {
+    uint8_t head[IMG_SNIFF_BYTES];
+    size_t  len = fread(head, 1, sizeof(head), fp);
+    fseek(fp, 0, SEEK_SET);
+    const ImgDecoderEntry_t *entry = ImgDecoderRegistry_Find(head, len);
+    ImgRowSource            *src   = (entry != NULL) ? entry->create() : NULL;
+    if (src == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    src->ImgSource_Attach(fp, arena);
+    if (!src->ImgSource_Open()) {
+        ESP_LOGE(TAG, "%s header fill", entry->name);
+        delete src;
+        return NULL;
+    }
+    ESP_LOGI(TAG, "%s:(%d,%d)", entry->name, src->ImgSource_Width(), src->ImgSource_Height());
+    return src;
+}
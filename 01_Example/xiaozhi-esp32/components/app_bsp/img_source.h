@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "imgdecode_app.h"
+
+class RenderArena;
+
+#define IMG_SOURCE_HEAP_MAX 4
+#define IMG_DECODER_MAX     8
+#define IMG_SNIFF_BYTES     16
+
+/*
+ * 逐行输出RGB888的图片源,每种格式实现一个子类
+ * Open 只读文件头得到尺寸(JPG为EXIF方向校正后的尺寸),Begin 指定裁剪区域,之后每次 ReadRow 输出裁剪区域的一行
+ * 内部缓冲区用 ImgSource_Alloc 申请:内存池已申请时从内存池分配(由调用者回退),否则用堆内存,析构时释放
+ */
+class ImgRowSource
+{
+private:
+    RenderArena *arena_ = NULL;
+    void        *heap_[IMG_SOURCE_HEAP_MAX] = {};
+    int          heapCount_ = 0;
+
+protected:
+    const char *TAG    = "ImgSource";
+    FILE       *fp_    = NULL;
+    int         width_  = 0;
+    int         height_ = 0;
+    ImgRect_t   rect_   = {};       /*Begin 之后的输出区域*/
+    int         row_    = 0;        /*已输出的行数*/
+
+    void            *ImgSource_Alloc(size_t size);
+    static ImgRect_t ImgSource_ClipRect(const ImgRect_t *crop, int width, int height);
+
+public:
+    virtual ~ImgRowSource();
+
+    void ImgSource_Attach(FILE *fp, RenderArena *arena);        /*由注册表调用,接管fp*/
+    virtual bool ImgSource_Open() = 0;
+    virtual bool ImgSource_Begin(const ImgRect_t *crop) = 0;    /*crop为NULL时输出整张图片*/
+    virtual bool ImgSource_ReadRow(uint8_t *rgb) = 0;           /*输出 rect.w 个像素*/
+
+    int              ImgSource_Width() { return width_; }
+    int              ImgSource_Height() { return height_; }
+    const ImgRect_t *ImgSource_Rect() { return &rect_; }
+};
+
+/*sniff 检查文件开头的 IMG_SNIFF_BYTES 字节(不足时len更小);create 为NULL表示解码器没有编译进来*/
+typedef struct {
+    const char   *name;
+    bool          (*sniff)(const uint8_t *head, size_t len);
+    ImgRowSource *(*create)();
+} ImgDecoderEntry_t;
+
+/*
+ * 解码器注册表:按文件开头的特征字节选择解码器,与扩展名无关
+ * 新格式只需实现 ImgRowSource 并注册一个 ImgDecoderEntry_t,显示流程不用修改
+ */
+class ImgDecoderRegistry
+{
+private:
+    const char              *TAG = "ImgDecoder";
+    const ImgDecoderEntry_t *entries_[IMG_DECODER_MAX];
+    int                      count_ = 0;
+
+public:
+    ImgDecoderRegistry();
+
+    bool          ImgDecoderRegistry_Register(const ImgDecoderEntry_t *entry);
+    const ImgDecoderEntry_t *ImgDecoderRegistry_Find(const uint8_t *head, size_t len);     /*没有匹配的解码器时返回NULL*/
+    /*返回已 Open 的图片源,用完后 delete;失败返回NULL*/
+    ImgRowSource *ImgDecoderRegistry_Open(const char *path, RenderArena *arena = NULL);
+    ImgRowSource *ImgDecoderRegistry_OpenFile(FILE *fp, RenderArena *arena = NULL);  /*无论成功与否都接管fp*/
+};
+
+extern const ImgDecoderEntry_t ImgSourceJpgEntry;
+extern const ImgDecoderEntry_t ImgSourcePngEntry;
+extern const ImgDecoderEntry_t ImgSourceBmpEntry;
+
+extern ImgDecoderRegistry imgDecoderRegistry;
+
+/*带重启标记的JPG是否分成两半在两个核上解码,默认关闭,由 config.txt 的 render.jpeg_split 打开*/
+void ImgSourceJpg_SetParallel(bool enable);
@@ -0,0 +1,66 @@
+#include <stdlib.h>
+#include <esp_log.h>
+#include "img_source.h"
+
+/*24位不压缩BMP,每行按文件位置直接读取裁剪区域覆盖的列*/
+class ImgSourceBmp : public ImgRowSource
+{
+private:
+    BITMAPFILEHEADER fileHeader_;
+    int              rowBytes_   = 0;
+    bool             bottomUp_   = true;
+    uint8_t         *rowBuf_     = NULL;
+
+public:
+    bool ImgSource_Open() override {
+        BITMAPINFOHEADER info;
+        if (fread(&fileHeader_, sizeof(fileHeader_), 1, fp_) != 1 || fread(&info, sizeof(info), 1, fp_) != 1) {
+            return false;
+        }
+        if (info.biBitCount != 24 || info.biCompression != 0) {
+            ESP_LOGE(TAG, "Only 24-bit uncompressed BMP is supported! Current bit depth: %d, Compression method: %d",
+                     info.biBitCount, info.biCompression);
+            return false;
+        }
+        width_    = info.biWidth;
+        height_   = abs(info.biHeight);
+        bottomUp_ = (info.biHeight > 0);
+        rowBytes_ = (width_ * 3 + 3) & ~3;
+        return width_ > 0 && height_ > 0;
+    }
+
+    bool ImgSource_Begin(const ImgRect_t *crop) override {
+        rect_   = ImgSource_ClipRect(crop, width_, height_);
+        row_    = 0;
+        rowBuf_ = (uint8_t *) ImgSource_Alloc(rect_.w * 3);
+        return rowBuf_ != NULL;
+    }
+
+    bool ImgSource_ReadRow(uint8_t *rgb) override {
+        if (row_ >= rect_.h) {
+            return false;
+        }
+        int y        = rect_.y + row_++;
+        int file_row = bottomUp_ ? (height_ - 1 - y) : y;
+        fseek(fp_, fileHeader_.bfOffBits + (long) file_row * rowBytes_ + rect_.x * 3, SEEK_SET);
+        if (fread(rowBuf_, rect_.w * 3, 1, fp_) != 1) {
+            return false;
+        }
+        for (int x = 0; x < rect_.w; x++) {
+            rgb[x * 3 + 0] = rowBuf_[x * 3 + 2];
+            rgb[x * 3 + 1] = rowBuf_[x * 3 + 1];
+            rgb[x * 3 + 2] = rowBuf_[x * 3 + 0];
+        }
+        return true;
+    }
+};
+
+static bool ImgSourceBmp_Sniff(const uint8_t *head, size_t len) {
+    return len >= 2 && head[0] == 'B' && head[1] == 'M';
+}
+
+static ImgRowSource *ImgSourceBmp_Create() {
+    return new ImgSourceBmp();
+}
+
+const ImgDecoderEntry_t ImgSourceBmpEntry = {"bmp", ImgSourceBmp_Sniff, ImgSourceBmp_Create};
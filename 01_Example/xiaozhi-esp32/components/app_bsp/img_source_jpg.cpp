@@ -0,0 +1,381 @@
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include "img_source.h"
+#include "jpeg_restart.h"
+#include "test_decoder.h"
+
+#define IMG_JPG_PARALLEL_MIN_ROWS 64    /*需要解码的行数少于此值时不值得分割*/
+
+static bool ImgSourceJpgParallel = false;
+
+void ImgSourceJpg_SetParallel(bool enable) {
+    ImgSourceJpgParallel = enable;
+}
+
+/*APP1 段数据(从"Exif"开始)中 IFD0 的 Orientation(0x0112),没有时返回1*/
+static int ImgSourceJpg_ExifOrientation(const uint8_t *seg, size_t len) {
+    if (len < 14 || memcmp(seg, "Exif\0\0", 6) != 0) {
+        return 1;
+    }
+    const uint8_t *tiff = seg + 6;
+    size_t         tlen = len - 6;
+    bool           le   = (tiff[0] == 'I');
+    auto rd16 = [&](size_t o) -> uint32_t { return le ? (tiff[o] | (tiff[o + 1] << 8)) : ((tiff[o] << 8) | tiff[o + 1]); };
+    auto rd32 = [&](size_t o) -> uint32_t { return le ? (rd16(o) | (rd16(o + 2) << 16)) : ((rd16(o) << 16) | rd16(o + 2)); };
+    if ((tiff[0] != 'I' && tiff[0] != 'M') || rd16(2) != 42) {
+        return 1;
+    }
+    size_t ifd = rd32(4);
+    if (ifd + 2 > tlen) {
+        return 1;
+    }
+    int count = rd16(ifd);
+    for (int i = 0; i < count && ifd + 2 + (i + 1) * 12 <= tlen; i++) {
+        size_t e = ifd + 2 + i * 12;
+        if (rd16(e) == 0x0112) {
+            int o = rd16(e + 8);
+            return (o >= 1 && o <= 8) ? o : 1;
+        }
+    }
+    return 1;
+}
+
+/*EXIF 方向:源图(w x h)中的像素(sx,sy)在正确显示时的位置(dx,dy)*/
+static void ImgSourceJpg_OrientMap(int o, int w, int h, int sx, int sy, int *dx, int *dy) {
+    switch (o) {
+        case 2: *dx = w - 1 - sx; *dy = sy;         break;
+        case 3: *dx = w - 1 - sx; *dy = h - 1 - sy; break;
+        case 4: *dx = sx;         *dy = h - 1 - sy; break;
+        case 5: *dx = sy;         *dy = sx;         break;
+        case 6: *dx = h - 1 - sy; *dy = sx;         break;
+        case 7: *dx = h - 1 - sy; *dy = w - 1 - sx; break;
+        case 8: *dx = sy;         *dy = w - 1 - sx; break;
+        default: *dx = sx;        *dy = sy;         break;
+    }
+}
+
+/*ImgSourceJpg_OrientMap 的逆变换*/
+static void ImgSourceJpg_OrientUnmap(int o, int w, int h, int dx, int dy, int *sx, int *sy) {
+    switch (o) {
+        case 2: *sx = w - 1 - dx; *sy = dy;         break;
+        case 3: *sx = w - 1 - dx; *sy = h - 1 - dy; break;
+        case 4: *sx = dx;         *sy = h - 1 - dy; break;
+        case 5: *sx = dy;         *sy = dx;         break;
+        case 6: *sx = dy;         *sy = h - 1 - dx; break;
+        case 7: *sx = w - 1 - dy; *sy = h - 1 - dx; break;
+        case 8: *sx = w - 1 - dy; *sy = dx;         break;
+        default: *sx = dx;        *sy = dy;         break;
+    }
+}
+
+class ImgSourceJpg;
+
+typedef struct {
+    ImgSourceJpg     *self;
+    const uint8_t    *data;
+    size_t            len;
+    int               rowBase;      /*码流第一行在源图中的行号*/
+    bool              ok;
+    SemaphoreHandle_t done;
+} ImgSourceJpgHalf_t;
+
+/*
+ * 分块(MCU行)解码,裁剪区域以下的块不再解码
+ * 正常方向时每次 ReadRow 按需解码下一块,边解码边输出;
+ * 其他 EXIF 方向在 Begin 中把裁剪区域解码到旋转后的缓冲区,写入时直接换算地址
+ * 带 DRI 重启标记的文件在 Begin 中从中间的重启标记处分成两半,下半部分交给另一个任务解码到缓冲区;
+ * 正常方向时上半部分仍按块边解码边输出,读到下半部分时才等待,缓冲区只有下半部分大小
+ */
+class ImgSourceJpg : public ImgRowSource
+{
+private:
+    int                    orient_   = 1;
+    int                    srcW_     = 0;
+    int                    srcH_     = 0;
+    ImgRect_t              srect_    = {};        /*源图坐标下的裁剪区域*/
+    jpeg_dec_handle_t      dec_      = NULL;
+    jpeg_dec_io_t          io_       = {};
+    uint8_t               *block_    = NULL;
+    int                    blocks_   = 0;         /*剩余块数*/
+    int                    blockY_   = 0;         /*当前块第一行的源图行号*/
+    int                    blockRows_ = 0;
+    uint8_t               *oriented_ = NULL;      /*旋转后的裁剪区域;正常方向分割解码时只保存下半部分*/
+    int                    outRow0_  = 0;         /*oriented_ 第一行对应的裁剪区域(源图坐标)行号*/
+    int                    splitRow_ = 0;         /*下半部分第一行的源图行号,0 表示没有分割*/
+    bool                   halfDone_ = false;
+    ImgSourceJpgHalf_t     half_     = {};
+
+    bool ImgSourceJpg_NextBlock() {
+        if (blocks_ <= 0 || jpeg_dec_process(dec_, &io_) != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "JPG Decode fill");
+            return false;
+        }
+        blocks_--;
+        blockY_    += blockRows_;
+        blockRows_  = io_.out_size / (srcW_ * 3);
+        return true;
+    }
+
+    /*把源图第y行(已解码在当前块中)写入旋转后的缓冲区*/
+    void ImgSourceJpg_Scatter(int y, const uint8_t *src) {
+        if (orient_ == 1) {
+            memcpy(oriented_ + (size_t) (y - srect_.y - outRow0_) * rect_.w * 3, src, (size_t) rect_.w * 3);
+            return;
+        }
+        int dx0, dy0, dx1, dy1;
+        ImgSourceJpg_OrientMap(orient_, srect_.w, srect_.h, 0, y - srect_.y, &dx0, &dy0);
+        ImgSourceJpg_OrientMap(orient_, srect_.w, srect_.h, 1, y - srect_.y, &dx1, &dy1);
+        uint8_t  *dst  = oriented_ + ((ptrdiff_t) dy0 * rect_.w + dx0) * 3;
+        ptrdiff_t step = ((ptrdiff_t) (dy1 - dy0) * rect_.w + (dx1 - dx0)) * 3;
+        for (int x = 0; x < srect_.w; x++, src += 3, dst += step) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+
+    /*解码一个完整的JPG码流(row_base为其第一行在源图中的行号),裁剪区域内的行写入旋转后的缓冲区*/
+    bool ImgSourceJpg_DecodeRows(const uint8_t *data, size_t len, int row_base) {
+        jpeg_dec_handle_t      dec    = NULL;
+        jpeg_dec_io_t          io     = {};
+        jpeg_dec_header_info_t info   = {};
+        jpeg_dec_config_t      config = DEFAULT_JPEG_DEC_CONFIG();
+        config.output_type            = JPEG_PIXEL_FORMAT_RGB888;
+        config.block_enable           = true;
+        uint8_t *block                = NULL;
+        int      block_len            = 0;
+        int      blocks               = 0;
+        int      y                    = row_base;
+        bool     ok                   = false;
+        io.inbuf                      = (uint8_t *) data;
+        io.inbuf_len                  = len;
+        if (jpeg_dec_open(&config, &dec) != JPEG_ERR_OK || jpeg_dec_parse_header(dec, &io, &info) != JPEG_ERR_OK ||
+            jpeg_dec_get_outbuf_len(dec, &block_len) != JPEG_ERR_OK || block_len == 0 ||
+            jpeg_dec_get_process_count(dec, &blocks) != JPEG_ERR_OK ||
+            (block = (uint8_t *) jpeg_calloc_align(block_len, 16)) == NULL) {
+            ESP_LOGE(TAG, "JPG header fill");
+            goto clean_up;
+        }
+        io.outbuf = block;
+        for (int i = 0; i < blocks && y < srect_.y + srect_.h; i++) {
+            if (jpeg_dec_process(dec, &io) != JPEG_ERR_OK) {
+                ESP_LOGE(TAG, "JPG Decode fill");
+                goto clean_up;
+            }
+            int rows = io.out_size / (srcW_ * 3);
+            for (int r = 0; r < rows; r++, y++) {
+                if (y >= srect_.y && y < srect_.y + srect_.h) {
+                    ImgSourceJpg_Scatter(y, block + ((size_t) r * srcW_ + srect_.x) * 3);
+                }
+            }
+        }
+        ok = true;
+
+    clean_up:
+        if (block != NULL) {
+            jpeg_free_align(block);
+        }
+        if (dec != NULL) {
+            jpeg_dec_close(dec);
+        }
+        return ok;
+    }
+
+    static void ImgSourceJpg_HalfTask(void *arg) {
+        ImgSourceJpgHalf_t *half = (ImgSourceJpgHalf_t *) arg;
+        half->ok                 = half->self->ImgSourceJpg_DecodeRows(half->data, half->len, half->rowBase);
+        xSemaphoreGive(half->done);
+        vTaskDelete(NULL);
+    }
+
+    bool ImgSourceJpg_WaitHalf() {
+        if (!halfDone_) {
+            xSemaphoreTake(half_.done, portMAX_DELAY);
+            halfDone_ = true;
+        }
+        return half_.ok;
+    }
+
+    /*按块解码一个码流,expect_h 为码流中的图片高度(上半部分的高度已被修改)*/
+    bool ImgSourceJpg_OpenStream(uint8_t *data, size_t len, int expect_h) {
+        jpeg_dec_header_info_t info   = {};
+        jpeg_dec_config_t      config = DEFAULT_JPEG_DEC_CONFIG();
+        config.output_type            = JPEG_PIXEL_FORMAT_RGB888;
+        config.block_enable           = true;
+        int block_len                 = 0;
+        io_.inbuf                     = data;
+        io_.inbuf_len                 = len;
+        if (jpeg_dec_open(&config, &dec_) != JPEG_ERR_OK || jpeg_dec_parse_header(dec_, &io_, &info) != JPEG_ERR_OK ||
+            info.width != srcW_ || info.height != expect_h ||
+            jpeg_dec_get_outbuf_len(dec_, &block_len) != JPEG_ERR_OK || block_len == 0 ||
+            jpeg_dec_get_process_count(dec_, &blocks_) != JPEG_ERR_OK || blocks_ == 0) {
+            ESP_LOGE(TAG, "JPG header fill");
+            return false;
+        }
+        block_     = (uint8_t *) jpeg_calloc_align(block_len, 16);
+        io_.outbuf = block_;
+        if (block_ == NULL) {
+            ESP_LOGE(TAG, "JPG buffer alloc fail");
+            return false;
+        }
+        return true;
+    }
+
+    /*只有找到合适的重启标记并且缓冲区申请成功时才分割,否则返回false,文件内容不变*/
+    bool ImgSourceJpg_DecodeParallel(uint8_t *file, size_t len, bool *ok) {
+        JpegRestartPlan_t plan;
+        int               need = srect_.y + srect_.h;
+        if (!ImgSourceJpgParallel || need < IMG_JPG_PARALLEL_MIN_ROWS || !JpegRestart_Plan(file, len, need / 2, &plan) ||
+            plan.topRows >= need || plan.topRows <= srect_.y) {
+            return false;
+        }
+        /*正常方向只缓存裁剪区域中属于下半部分的行*/
+        int      keep       = (orient_ == 1) ? need - plan.topRows : rect_.h;
+        size_t   bottom_len = JpegRestart_BottomLen(len, &plan);
+        uint8_t *bottom     = (uint8_t *) ImgSource_Alloc(bottom_len);
+        uint8_t *out        = (uint8_t *) ImgSource_Alloc((size_t) rect_.w * keep * 3);
+        if (bottom == NULL || out == NULL || (half_.done = xSemaphoreCreateBinary()) == NULL) {
+            return false;
+        }
+        oriented_      = out;
+        outRow0_       = (orient_ == 1) ? plan.topRows - srect_.y : 0;
+        splitRow_      = plan.topRows;
+        size_t top_len = JpegRestart_Split(file, len, &plan, bottom);
+        half_.self     = this;
+        half_.data     = bottom;
+        half_.len      = bottom_len;
+        half_.rowBase  = plan.topRows;
+        ESP_LOGI(TAG, "parallel decode, split at row %d", plan.topRows);
+        /*不绑定核:流水线中当前核之外还有抖动任务,由调度器放到空闲的核上*/
+        if (xTaskCreatePinnedToCore(ImgSourceJpg_HalfTask, "jpg_half", 4 * 1024, &half_, 5, NULL, tskNO_AFFINITY) != pdPASS) {
+            half_.ok = ImgSourceJpg_DecodeRows(bottom, bottom_len, plan.topRows);
+            xSemaphoreGive(half_.done);
+        }
+        if (orient_ != 1) {
+            bool top_ok = ImgSourceJpg_DecodeRows(file, top_len, 0);
+            *ok         = ImgSourceJpg_WaitHalf() && top_ok;
+            return true;
+        }
+        *ok = ImgSourceJpg_OpenStream(file, top_len, plan.topRows);
+        return true;
+    }
+
+public:
+    ~ImgSourceJpg() override {
+        if (half_.done != NULL) {       /*缓冲区由基类释放,先等下半部分解码结束*/
+            ImgSourceJpg_WaitHalf();
+            vSemaphoreDelete(half_.done);
+        }
+        if (block_ != NULL) {
+            jpeg_free_align(block_);
+        }
+        if (dec_ != NULL) {
+            jpeg_dec_close(dec_);
+        }
+    }
+
+    /*跳过各段直到 SOFn,途中读取 APP1 里的 EXIF 方向*/
+    bool ImgSource_Open() override {
+        long    pos = 2;
+        uint8_t seg[9];
+        while (fseek(fp_, pos, SEEK_SET) == 0 && fread(seg, 1, 4, fp_) == 4 && seg[0] == 0xFF) {
+            uint8_t marker = seg[1];
+            if (marker == 0xFF) {
+                pos++;
+                continue;
+            }
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                if (fread(seg + 4, 1, 5, fp_) != 5) {
+                    return false;
+                }
+                srcH_ = (seg[5] << 8) | seg[6];
+                srcW_ = (seg[7] << 8) | seg[8];
+                break;
+            }
+            size_t seglen = (seg[2] << 8) | seg[3];
+            if (marker == 0xE1 && orient_ == 1) {       /*IFD0 一般紧跟在 TIFF 头后面,只读开头部分*/
+                uint8_t exif[512];
+                size_t  n = fread(exif, 1, (seglen - 2) < sizeof(exif) ? (seglen - 2) : sizeof(exif), fp_);
+                orient_   = ImgSourceJpg_ExifOrientation(exif, n);
+            }
+            pos += 2 + seglen;
+        }
+        width_  = (orient_ >= 5) ? srcH_ : srcW_;
+        height_ = (orient_ >= 5) ? srcW_ : srcH_;
+        if (orient_ != 1) {
+            ESP_LOGI(TAG, "EXIF orientation:%d", orient_);
+        }
+        return srcW_ > 0 && srcH_ > 0;
+    }
+
+    bool ImgSource_Begin(const ImgRect_t *crop) override {
+        rect_ = ImgSource_ClipRect(crop, width_, height_);
+        row_  = 0;
+        int x0, y0, x1, y1;
+        ImgSourceJpg_OrientUnmap(orient_, srcW_, srcH_, rect_.x, rect_.y, &x0, &y0);
+        ImgSourceJpg_OrientUnmap(orient_, srcW_, srcH_, rect_.x + rect_.w - 1, rect_.y + rect_.h - 1, &x1, &y1);
+        srect_ = {x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, abs(x1 - x0) + 1, abs(y1 - y0) + 1};
+
+        fseek(fp_, 0, SEEK_END);
+        long file_size = ftell(fp_);
+        fseek(fp_, 0, SEEK_SET);
+        uint8_t *file = (file_size > 0) ? (uint8_t *) ImgSource_Alloc(file_size) : NULL;
+        if (file == NULL || fread(file, 1, file_size, fp_) != (size_t) file_size) {
+            ESP_LOGE(TAG, "jpg file buffer alloc fail:%ld", file_size);
+            return false;
+        }
+        bool ok = false;
+        if (ImgSourceJpg_DecodeParallel(file, file_size, &ok)) {
+            return ok;
+        }
+        if (orient_ != 1) {
+            oriented_ = (uint8_t *) ImgSource_Alloc((size_t) rect_.w * rect_.h * 3);
+            if (oriented_ == NULL) {
+                ESP_LOGE(TAG, "JPG buffer alloc fail");
+                return false;
+            }
+            return ImgSourceJpg_DecodeRows(file, file_size, 0);
+        }
+        return ImgSourceJpg_OpenStream(file, file_size, srcH_);
+    }
+
+    bool ImgSource_ReadRow(uint8_t *rgb) override {
+        if (row_ >= rect_.h) {
+            return false;
+        }
+        if (dec_ == NULL) {
+            memcpy(rgb, oriented_ + (size_t) row_++ * rect_.w * 3, rect_.w * 3);
+            return true;
+        }
+        int y = srect_.y + row_++;
+        if (splitRow_ > 0 && y >= splitRow_) {
+            if (!ImgSourceJpg_WaitHalf()) {
+                ESP_LOGE(TAG, "JPG Decode fill");
+                return false;
+            }
+            memcpy(rgb, oriented_ + (size_t) (y - srect_.y - outRow0_) * rect_.w * 3, rect_.w * 3);
+            return true;
+        }
+        while (y >= blockY_ + blockRows_) {
+            if (!ImgSourceJpg_NextBlock()) {
+                return false;
+            }
+        }
+        memcpy(rgb, block_ + ((size_t) (y - blockY_) * srcW_ + srect_.x) * 3, rect_.w * 3);
+        return true;
+    }
+};
+
+static bool ImgSourceJpg_Sniff(const uint8_t *head, size_t len) {
+    return len >= 3 && head[0] == 0xFF && head[1] == 0xD8 && head[2] == 0xFF;
+}
+
+static ImgRowSource *ImgSourceJpg_Create() {
+    return new ImgSourceJpg();
+}
+
+const ImgDecoderEntry_t ImgSourceJpgEntry = {"jpg", ImgSourceJpg_Sniff, ImgSourceJpg_Create};
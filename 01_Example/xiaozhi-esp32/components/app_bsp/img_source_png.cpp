@@ -0,0 +1,112 @@
+#include <string.h>
+#include <esp_log.h>
+#include "png.h"
+#include "img_source.h"
+
+/*PNG无法跳行,裁剪区域以上的行解码后丢弃,以下的行不再解码*/
+class ImgSourcePng : public ImgRowSource
+{
+private:
+    png_structp png_  = NULL;
+    png_infop   info_ = NULL;
+    png_bytep   row_buf_ = NULL;
+
+    static void ImgSourcePng_Read(png_structp png_ptr, png_bytep data, png_size_t length) {
+        FILE *fp = (FILE *) png_get_io_ptr(png_ptr);
+        if (fread(data, 1, length, fp) != length) {
+            png_error(png_ptr, "read fail");
+        }
+    }
+
+public:
+    ~ImgSourcePng() override {
+        if (png_ != NULL) {
+            png_destroy_read_struct(&png_, &info_, NULL);
+        }
+    }
+
+    bool ImgSource_Open() override {
+        png_ = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        if (png_ == NULL) {
+            ESP_LOGE(TAG, "Failed to create png_struct");
+            return false;
+        }
+        info_ = png_create_info_struct(png_);
+        if (info_ == NULL) {
+            ESP_LOGE(TAG, "Failed to create png_info");
+            return false;
+        }
+        if (setjmp(png_jmpbuf(png_))) {
+            ESP_LOGE(TAG, "Error occurred during PNG decoding process");
+            return false;
+        }
+        png_set_read_fn(png_, fp_, ImgSourcePng_Read);
+        png_read_info(png_, info_);
+        width_             = png_get_image_width(png_, info_);
+        height_            = png_get_image_height(png_, info_);
+        png_byte bit_depth  = png_get_bit_depth(png_, info_);
+        png_byte color_type = png_get_color_type(png_, info_);
+        ESP_LOGI(TAG, "PNG information: %dx%d, bit depth: %d, color type: %d", width_, height_, bit_depth, color_type);
+
+        if (color_type == PNG_COLOR_TYPE_PALETTE) {
+            png_set_palette_to_rgb(png_);
+        }
+        if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
+            png_set_expand_gray_1_2_4_to_8(png_);
+        }
+        if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+            png_set_gray_to_rgb(png_);
+        }
+        if (png_get_valid(png_, info_, PNG_INFO_tRNS)) {
+            png_set_tRNS_to_alpha(png_);
+        }
+        if (bit_depth == 16) {
+            png_set_strip_16(png_);
+        }
+        png_set_strip_alpha(png_);       /*统一输出RGB888*/
+        png_read_update_info(png_, info_);
+        return width_ > 0 && height_ > 0;
+    }
+
+    bool ImgSource_Begin(const ImgRect_t *crop) override {
+        rect_    = ImgSource_ClipRect(crop, width_, height_);
+        row_     = 0;
+        row_buf_ = (png_bytep) ImgSource_Alloc(png_get_rowbytes(png_, info_));
+        if (row_buf_ == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate memory for row data");
+            return false;
+        }
+        if (setjmp(png_jmpbuf(png_))) {
+            ESP_LOGE(TAG, "Error occurred during PNG decoding process");
+            return false;
+        }
+        for (int y = 0; y < rect_.y; y++) {
+            png_read_row(png_, row_buf_, NULL);
+        }
+        return true;
+    }
+
+    bool ImgSource_ReadRow(uint8_t *rgb) override {
+        if (row_ >= rect_.h) {
+            return false;
+        }
+        if (setjmp(png_jmpbuf(png_))) {
+            ESP_LOGE(TAG, "Error occurred during PNG decoding process");
+            return false;
+        }
+        png_read_row(png_, row_buf_, NULL);
+        memcpy(rgb, row_buf_ + rect_.x * 3, rect_.w * 3);
+        row_++;
+        return true;
+    }
+};
+
+static bool ImgSourcePng_Sniff(const uint8_t *head, size_t len) {
+    return len >= 8 && png_sig_cmp(head, 0, 8) == 0;
+}
+
+static ImgRowSource *ImgSourcePng_Create() {
+    return new ImgSourcePng();
+}
+
+const ImgDecoderEntry_t ImgSourcePngEntry = {"png", ImgSourcePng_Sniff, ImgSourcePng_Create};
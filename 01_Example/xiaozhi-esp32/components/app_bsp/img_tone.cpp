@@ -0,0 +1,80 @@
+#include <math.h>
+#include <string.h>
+#include "img_tone.h"
+
+ImgTone::ImgTone() {
+    ImgTone_HistReset();
+    for (int i = 0; i < 256; i++) {
+        lut_[i] = (uint8_t) i;
+    }
+}
+
+void ImgTone::ImgTone_SetParams(const ImgToneParams_t *params) {
+    params_ = *params;
+}
+
+void ImgTone::ImgTone_HistReset() {
+    memset(hist_, 0, sizeof(hist_));
+    histCount_ = 0;
+}
+
+void ImgTone::ImgTone_Reset() {
+    ImgToneParams_t identity = IMG_TONE_DEFAULT_PARAMS;
+    params_                  = identity;
+    ImgTone_HistReset();
+}
+
+void ImgTone::ImgTone_HistRow(const uint8_t *rgb, int w) {
+    if (!params_.auto_levels) {
+        return;
+    }
+    for (int x = 0; x < w; x++, rgb += 3) {
+        hist_[(77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2]) >> 8]++;
+    }
+    histCount_ += w;
+}
+
+bool ImgTone::ImgTone_Prepare() {
+    int lo = 0;
+    int hi = 255;
+    /*没有直方图(如内存中的图片)时不做黑白场拉伸*/
+    if (params_.auto_levels && histCount_ > 0) {
+        uint32_t clip = (uint32_t) (histCount_ * params_.clip / 100.0f);
+        uint32_t sum  = 0;
+        for (lo = 0; lo < 255; lo++) {
+            sum += hist_[lo];
+            if (sum > clip) {
+                break;
+            }
+        }
+        sum = 0;
+        for (hi = 255; hi > 0; hi--) {
+            sum += hist_[hi];
+            if (sum > clip) {
+                break;
+            }
+        }
+        if (hi - lo < 16) {     /*几乎纯色的图片不拉伸,避免放大噪声*/
+            lo = 0;
+            hi = 255;
+        }
+    }
+    float gamma    = params_.gamma > 0.05f ? params_.gamma : 1.0f;
+    float contrast = params_.contrast > 0.0f ? params_.contrast : 1.0f;
+    lutIdentity_   = true;
+    for (int i = 0; i < 256; i++) {
+        float v = (float) (i - lo) / (float) (hi - lo);
+        v       = (v - 0.5f) * contrast + 0.5f;
+        v       = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        v       = powf(v, 1.0f / gamma);
+        lut_[i] = (uint8_t) (v * 255.0f + 0.5f);
+        if (lut_[i] != i) {
+            lutIdentity_ = false;
+        }
+    }
+    sat_ = (int32_t) (params_.saturation * 256.0f + 0.5f);
+    if (sat_ < 0) {
+        sat_ = 0;
+    }
+    return !(lutIdentity_ && sat_ == 256);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    float gamma;       /*1.0不变,大于1提亮暗部*/
+    float contrast;    /*1.0不变,以128为中心拉伸*/
+    float saturation;  /*1.0不变,0为灰度*/
+    bool  auto_levels; /*按解码时统计的亮度直方图拉伸黑白场;需要整图直方图,开启后只能走顺序流程*/
+    float clip;        /*auto_levels 两端各忽略的像素百分比*/
+} ImgToneParams_t;
+
+#define IMG_TONE_DEFAULT_PARAMS {1.0f, 1.0f, 1.0f, false, 0.5f}
+
+/*
+ * 色调处理:黑白场 + 对比度 + gamma 合成一张256项查找表,三个通道共用(不改变色相)
+ * 饱和度按亮度定点插值,不需要浮点
+ * 直方图在解码器写出每行时统计,查找表在抖动读取输入时应用,不额外遍历整帧
+ */
+class ImgTone
+{
+private:
+    ImgToneParams_t params_   = IMG_TONE_DEFAULT_PARAMS;
+    uint32_t        hist_[256];
+    uint32_t        histCount_ = 0;
+    uint8_t         lut_[256];
+    int32_t         sat_       = 256;  /*饱和度*256*/
+    bool            lutIdentity_ = true;
+
+public:
+    ImgTone();
+
+    void ImgTone_SetParams(const ImgToneParams_t *params);
+    void ImgTone_HistReset();
+    void ImgTone_Reset();                              /*恢复恒等参数并清空直方图*/
+    void ImgTone_HistRow(const uint8_t *rgb, int w);   /*统计一行RGB888像素的亮度*/
+    bool ImgTone_Prepare();                            /*生成查找表,返回false表示参数为恒等变换,不需要处理*/
+    bool ImgTone_NeedsHistogram() { return params_.auto_levels; }    /*需要整张图的直方图才能开始抖动*/
+
+    inline void ImgTone_Apply(const uint8_t *in, uint8_t *out) {
+        int32_t r = lut_[in[0]];
+        int32_t g = lut_[in[1]];
+        int32_t b = lut_[in[2]];
+        if (sat_ != 256) {
+            int32_t y = (77 * r + 150 * g + 29 * b) >> 8;
+            r         = y + (((r - y) * sat_) >> 8);
+            g         = y + (((g - y) * sat_) >> 8);
+            b         = y + (((b - y) * sat_) >> 8);
+            r         = r < 0 ? 0 : (r > 255 ? 255 : r);
+            g         = g < 0 ? 0 : (g > 255 ? 255 : g);
+            b         = b < 0 ? 0 : (b > 255 ? 255 : b);
+        }
+        out[0] = (uint8_t) r;
+        out[1] = (uint8_t) g;
+        out[2] = (uint8_t) b;
+    }
+};
@@ -1,11 +1,42 @@
 #include <stdio.h>
 #include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <esp_heap_caps.h>
 #include <esp_log.h>
 #include "imgdecode_app.h"
 #include "test_decoder.h"
+#include "render_arena.h"
+#include "render_profiler.h"
+#include "img_scaler.h"
+#include "img_source.h"
+#include "img_band_queue.h"
 
+#define STAGE_FROM_HEAP ((size_t) -1)
 #define CLAMP(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+#define IMG_PIPELINE_BAND_ROWS 16
+#define IMG_PIPELINE_BANDS     3
+
+typedef struct {
+    uint8_t *dst;
+    size_t   stride;
+    size_t   len;
+} ImgScaleTarget_t;
+
+/*流水线渲染中解码任务的参数*/
+typedef struct {
+    ImgDecodeDither  *self;
+    ImgRowSource     *src;
+    ImgBandQueue     *queue;
+    const ImgRect_t  *dst;
+    const uint8_t    *background;   /*一整行背景色*/
+    size_t            rowBytes;
+    int               canvasH;
+    ImgBand_t         band;         /*正在填充的行带*/
+    esp_err_t         ret;
+    SemaphoreHandle_t done;
+} ImgPipelineJob_t;
 
 static const uint8_t PALETTE[6][3] = {
     {0, 0, 0},       // Black
@@ -16,17 +47,35 @@ static const uint8_t PALETTE[6][3] = {
     {255, 255, 0}    // Yellow
 };
 
-void ImgDecodeDither::png_read_callback(png_structp png_ptr, png_bytep data, png_size_t length) {
-    FILE *fp = (FILE *)png_get_io_ptr(png_ptr);
-    fread(data, 1, length, fp);
+ImgDecodeDither::ImgDecodeDither(RenderArena *arena) :
+arena_(arena) {
+
 }
 
-ImgDecodeDither::ImgDecodeDither() {
+ImgDecodeDither::~ImgDecodeDither() {
 
 }
 
-ImgDecodeDither::~ImgDecodeDither() {
+/*渲染过程中(内存池已申请)临时缓冲区从内存池分配,其他情况(如AI图片生成)仍使用malloc*/
+uint8_t *ImgDecodeDither::ImgDecode_StageAlloc(size_t size, size_t *mark) {
+    *mark = STAGE_FROM_HEAP;
+    if (arena_ != NULL && arena_->RenderArena_IsReserved()) {
+        size_t   m   = arena_->RenderArena_Mark();
+        uint8_t *buf = (uint8_t *) arena_->RenderArena_Alloc(size);
+        if (buf != NULL) {
+            *mark = m;
+            return buf;
+        }
+    }
+    return (uint8_t *) malloc(size);
+}
 
+void ImgDecodeDither::ImgDecode_StageFree(uint8_t *buffer, size_t mark) {
+    if (mark == STAGE_FROM_HEAP) {
+        free(buffer);
+    } else {
+        arena_->RenderArena_Rewind(mark);
+    }
 }
 
 esp_err_t ImgDecodeDither::ImgDecode_OneJPGPicture(uint8_t *inbuffer, int inlen, uint8_t **outbuffer, int *outlen) {
@@ -40,371 +89,353 @@ esp_err_t ImgDecodeDither::ImgDecode_OneJPGPicture(uint8_t *inbuffer, int inlen,
     return ESP_FAIL;
 }
 
-esp_err_t ImgDecodeDither::ImgDecode_TFOneJPGPicture(const char *path,uint8_t **outbuffer, int *outlen, int *s_width, int *s_height) {
-    FILE *f = fopen(path, "rb");
-    if (f == NULL) {
-        ESP_LOGE(TAG, "Failed to open file: %s", path);
-        return ESP_FAIL;
+esp_err_t ImgDecodeDither::ImgDecode_SourceBegin(ImgRowSource *src, const ImgRect_t *crop) {
+    tone_.ImgTone_HistReset();
+    return src->ImgSource_Begin(crop) ? ESP_OK : ESP_FAIL;
+}
+
+static void ImgDecode_RowToBuffer(void *ctx, int y, const uint8_t *rgb) {
+    ImgScaleTarget_t *t = (ImgScaleTarget_t *) ctx;
+    memcpy(t->dst + (size_t) y * t->stride, rgb, t->len);
+}
+
+/*尺寸相同时直接逐行读入目标缓冲区,否则逐行送入 ImgScaler,不需要整帧源图*/
+esp_err_t ImgDecodeDither::ImgDecode_SourceToRgb888(ImgRowSource *src, uint8_t *dst, int dst_w, int dst_h, int dst_stride) {
+    RENDER_PROFILE_SCOPE("decode", dst_w * dst_h * 3);
+    const ImgRect_t *rect   = src->ImgSource_Rect();
+    size_t           stride = dst_stride > 0 ? dst_stride : dst_w * 3;
+    if (rect->w == dst_w && rect->h == dst_h) {
+        for (int y = 0; y < dst_h; y++) {
+            uint8_t *row = dst + y * stride;
+            if (!src->ImgSource_ReadRow(row)) {
+                return ESP_FAIL;
+            }
+            tone_.ImgTone_HistRow(row, dst_w);
+        }
+        return ESP_OK;
     }
+    ImgScaleTarget_t target = {dst, stride, (size_t) dst_w * 3};
+    return ImgDecode_SourceToRows(src, dst_w, dst_h, ImgDecode_RowToBuffer, &target);
+}
 
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    if (file_size <= 0) {
-        ESP_LOGE(TAG, "Invalid file size");
-        fclose(f);
+esp_err_t ImgDecodeDither::ImgDecode_SourceToRows(ImgRowSource *src, int dst_w, int dst_h, ImgRowSink_t sink, void *ctx) {
+    const ImgRect_t *rect  = src->ImgSource_Rect();
+    bool             scale = rect->w != dst_w || rect->h != dst_h;
+    size_t           work_mark, row_mark;
+    uint8_t         *work  = NULL;
+    if (scale) {
+        work = ImgDecode_StageAlloc(ImgScaler::ImgScaler_WorkSize(rect->w, rect->h, dst_w, dst_h), &work_mark);
+        if (work == NULL) {
+            ESP_LOGE(TAG, "scale work alloc fail");
+            return ESP_FAIL;
+        }
+    }
+    uint8_t *row = ImgDecode_StageAlloc(rect->w * 3, &row_mark);
+    if (row == NULL) {
+        ESP_LOGE(TAG, "row alloc fail");
+        if (work != NULL) {
+            ImgDecode_StageFree(work, work_mark);
+        }
         return ESP_FAIL;
     }
-    fseek(f, 0, SEEK_SET);
-    uint8_t *buffer = (uint8_t *)malloc(480 * 800 * 3);
-    assert(buffer);
-    size_t bytes_read = fread(buffer, 1, file_size, f);
-    fclose(f);
-    if(bytes_read > 0) {
-        if (esp_jpeg_decode_one_picture(buffer, bytes_read, outbuffer, outlen,s_width,s_height) == JPEG_ERR_OK) {
-            free(buffer);
-            buffer = NULL;
-            return ESP_OK;
+    esp_err_t ret = ESP_OK;
+    ImgScaler scaler;
+    if (scale) {
+        scaler.ImgScaler_Begin(rect->w, rect->h, dst_w, dst_h, work, sink, ctx);
+    }
+    for (int y = 0; y < rect->h; y++) {
+        if (!src->ImgSource_ReadRow(row)) {
+            ret = ESP_FAIL;
+            break;
+        }
+        tone_.ImgTone_HistRow(row, rect->w);
+        if (scale) {
+            scaler.ImgScaler_PushRow(row);
         } else {
-            ESP_LOGE(TAG,"JPG Decode fill");
+            sink(ctx, y, row);
         }
     }
-    if(buffer) {
-        free(buffer);
-        buffer = NULL;
+    ImgDecode_StageFree(row, row_mark);
+    if (work != NULL) {
+        ImgDecode_StageFree(work, work_mark);
     }
-    return ESP_FAIL;
+    return ret;
 }
 
-esp_err_t ImgDecodeDither::ImgDecode_TFOnePNGPicture(const char *png_path, uint8_t **out_rgb888,int *out_width, int *out_height) {
-    FILE *fp = NULL;
-    png_structp png_ptr = NULL;
-    png_infop info_ptr = NULL;
-    png_byte bit_depth = 0;
-    png_byte color_type = 0;
-    const int block_rows = 128;
-    int total_rows = 0;
-    int remaining_rows = 0;
-    int current_y = 0;
-    png_size_t row_bytes = 0;
-    png_bytep *row_pointers = NULL;
-    *out_rgb888 = NULL;
-    *out_width = 0;
-    *out_height = 0;
-
-    fp = fopen(png_path, "rb");
-    if (!fp) {
-        ESP_LOGE(TAG, "Unable to open PNG file:%s", png_path);
-        return ESP_FAIL;
+/*写入画布第y行:rgb 为 dst 区域内的一行,NULL表示整行都是背景;凑满一个行带就交给消费者*/
+static void ImgDecode_PipelineEmit(ImgPipelineJob_t *job, int y, const uint8_t *rgb) {
+    if (job->band.rows == NULL) {
+        job->band.rows  = job->queue->ImgBandQueue_Acquire();
+        job->band.y     = y;
+        job->band.count = 0;
     }
-
-    uint8_t png_header[8];
-    fread(png_header, 1, 8, fp);
-    if (!png_check_sig(png_header, 8)) {
-        ESP_LOGE(TAG, "Not a valid PNG file:%s", png_path);
-        goto clean_up;
+    uint8_t *row = job->band.rows + job->band.count * job->rowBytes;
+    if (rgb == NULL || (size_t) job->dst->w * 3 != job->rowBytes) {
+        memcpy(row, job->background, job->rowBytes);
     }
-
-    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (!png_ptr) {
-        ESP_LOGE(TAG, "Failed to create png_struct");
-        goto clean_up;
+    if (rgb != NULL) {
+        memcpy(row + job->dst->x * 3, rgb, job->dst->w * 3);
     }
-
-    info_ptr = png_create_info_struct(png_ptr);
-    if (!info_ptr) {
-        ESP_LOGE(TAG, "Failed to create png_info");
-        goto clean_up;
-    }
-
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        ESP_LOGE(TAG, "Error occurred during PNG decoding process");
-        goto clean_up; 
+    if (++job->band.count == job->queue->ImgBandQueue_BandRows()) {
+        job->queue->ImgBandQueue_Submit(&job->band);
+        job->band.rows = NULL;
     }
+}
 
-    png_set_read_fn(png_ptr, fp, png_read_callback);
-    png_set_sig_bytes(png_ptr, 8); 
-
-    png_read_info(png_ptr, info_ptr);
-    *out_width = png_get_image_width(png_ptr, info_ptr);
-    *out_height = png_get_image_height(png_ptr, info_ptr);
-    bit_depth = png_get_bit_depth(png_ptr, info_ptr);
-    color_type = png_get_color_type(png_ptr, info_ptr);
-    ESP_LOGI(TAG, "PNG information: %dx%d, bit depth: %d, color type: %d",*out_width, *out_height, bit_depth, color_type);
+static void ImgDecode_PipelineSink(void *ctx, int y, const uint8_t *rgb) {
+    ImgPipelineJob_t *job = (ImgPipelineJob_t *) ctx;
+    ImgDecode_PipelineEmit(job, job->dst->y + y, rgb);
+}
 
-    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
-        png_set_expand_gray_1_2_4_to_8(png_ptr);
-    }
-    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
-        png_set_tRNS_to_alpha(png_ptr);
-    }
-    if (bit_depth == 16) {
-        png_set_strip_16(png_ptr);
+/*生产者:按画布行顺序输出上边距、解码(缩放)后的图片行、下边距,最后发送结束标记*/
+static void ImgDecode_PipelineTask(void *arg) {
+    ImgPipelineJob_t *job = (ImgPipelineJob_t *) arg;
+    {
+        RENDER_PROFILE_SCOPE("decode", job->dst->w * job->dst->h * 3);
+        for (int y = 0; y < job->dst->y; y++) {
+            ImgDecode_PipelineEmit(job, y, NULL);
+        }
+        job->ret = job->self->ImgDecode_SourceToRows(job->src, job->dst->w, job->dst->h, ImgDecode_PipelineSink, job);
+        for (int y = job->dst->y + job->dst->h; job->ret == ESP_OK && y < job->canvasH; y++) {
+            ImgDecode_PipelineEmit(job, y, NULL);
+        }
     }
-    if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_GRAY) {
-        png_set_add_alpha(png_ptr, 0xFF, PNG_FILLER_AFTER);
+    if (job->band.rows != NULL) {
+        job->queue->ImgBandQueue_Submit(&job->band);
     }
-    png_read_update_info(png_ptr, info_ptr);
+    ImgBand_t end = {NULL, 0, 0};
+    job->queue->ImgBandQueue_Submit(&end);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
 
-    *out_rgb888 = (uint8_t *)heap_caps_malloc(
-        *out_width * *out_height * 3, MALLOC_CAP_SPIRAM);
-    if (!*out_rgb888) {
-        ESP_LOGE(TAG, "Failed to allocate RGB888 cache");
+/*
+ * 消费者在当前任务中抖动,解码任务固定在另一个核上
+ * 内存池在两个任务间不加锁:所有缓冲区在创建任务前申请,解码任务自己的临时缓冲区在发送结束标记前释放,
+ * 消费者收到结束标记并等到任务结束后才释放抖动缓冲区,保持后进先出
+ */
+esp_err_t ImgDecodeDither::ImgDecode_SourceDitherPipelined(ImgRowSource *src, int canvas_w, int canvas_h, const ImgRect_t *dst,
+                                                           const uint8_t *background, ImgRowSink_t sink, void *ctx) {
+    if (!pipelined_ || tone_.ImgTone_NeedsHistogram()) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    size_t   rowBytes = (size_t) canvas_w * 3;
+    size_t   bandSize = ImgBandQueue::ImgBandQueue_MemSize(rowBytes, IMG_PIPELINE_BAND_ROWS, IMG_PIPELINE_BANDS);
+    size_t   mark;
+    uint8_t *bands = ImgDecode_StageAlloc(bandSize + rowBytes, &mark);
+    if (bands == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint8_t *bg = bands + bandSize;
+    for (int x = 0; x < canvas_w; x++) {
+        memcpy(bg + x * 3, background, 3);
+    }
+    ImgBandQueue     queue;
+    ImgPipelineJob_t job  = {this, src, &queue, dst, bg, rowBytes, canvas_h, {NULL, 0, 0}, ESP_OK, NULL};
+    esp_err_t        ret  = ESP_ERR_NOT_SUPPORTED;
+    int              rows = 0;
+    if (!queue.ImgBandQueue_Init(bands, rowBytes, IMG_PIPELINE_BAND_ROWS, IMG_PIPELINE_BANDS) ||
+        (job.done = xSemaphoreCreateBinary()) == NULL || ImgDecode_DitherBegin(canvas_w, sink, ctx) != ESP_OK) {
         goto clean_up;
     }
-
-    total_rows = *out_height;
-    remaining_rows = total_rows;
-    current_y = 0;
-    row_bytes = png_get_rowbytes(png_ptr, info_ptr);
-
-    row_pointers = (png_bytep *)heap_caps_malloc(block_rows * sizeof(png_bytep), MALLOC_CAP_SPIRAM);
-    if (!row_pointers) {
-        ESP_LOGE(TAG, "Allocation of pointer memory failed");
+    if (xTaskCreatePinnedToCore(ImgDecode_PipelineTask, "img_decode", 8 * 1024, &job, 5, NULL, xPortGetCoreID() ^ 1) != pdPASS) {
+        ESP_LOGE(TAG, "decode task create fill");
+        ImgDecode_DitherEnd();
         goto clean_up;
     }
-
-    for (int i = 0; i < block_rows; i++) {
-        row_pointers[i] = (png_bytep)heap_caps_malloc(row_bytes, MALLOC_CAP_SPIRAM);
-        if (!row_pointers[i]) {
-            ESP_LOGE(TAG, "Failed to allocate memory for row data (line %d)", i);
-            for (int j = 0; j < i; j++) {
-                heap_caps_free(row_pointers[j]);
+    {
+        RENDER_PROFILE_SCOPE("dither", canvas_w * canvas_h * 3);
+        for (;;) {
+            ImgBand_t band;
+            queue.ImgBandQueue_Receive(&band);
+            if (band.count == 0) {
+                break;
             }
-            heap_caps_free(row_pointers);
-            row_pointers = NULL;
-            goto clean_up;
-        }
-    }
-
-    while (remaining_rows > 0) {
-        int decode_rows = (remaining_rows >= block_rows) ? block_rows : remaining_rows;
-        png_read_rows(png_ptr, row_pointers, NULL, decode_rows);
-
-        for (int y = 0; y < decode_rows; y++) {
-            png_bytep rgba_row = row_pointers[y];
-            uint8_t *rgb888_row = *out_rgb888 + (current_y + y) * *out_width * 3;
-            for (int x = 0; x < *out_width; x++) {
-                uint8_t R = rgba_row[x*4 + 0];
-                uint8_t G = rgba_row[x*4 + 1];
-                uint8_t B = rgba_row[x*4 + 2];
-                rgb888_row[x*3 + 0] = R;
-                rgb888_row[x*3 + 1] = G;
-                rgb888_row[x*3 + 2] = B;
+            for (int r = 0; r < band.count; r++) {
+                ImgDecode_DitherPushRow(band.rows + r * rowBytes);
             }
+            rows += band.count;
+            queue.ImgBandQueue_Release(band.rows);
         }
-
-        remaining_rows -= decode_rows;
-        current_y += decode_rows;
+        xSemaphoreTake(job.done, portMAX_DELAY);
+        ImgDecode_DitherEnd();
     }
-
-    if (row_pointers != NULL) {
-        for (int i = 0; i < block_rows; i++) {
-            heap_caps_free(row_pointers[i]);
-        }
-        heap_caps_free(row_pointers);
-        row_pointers = NULL;
+    ret = (job.ret == ESP_OK && rows == canvas_h) ? ESP_OK : ESP_FAIL;
+    if (ret == ESP_OK) {
+        pipelineRuns_++;
     }
 
-    png_read_end(png_ptr, NULL);
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    fclose(fp);
-
-    ESP_LOGI(TAG, "PNG decoding has been completed to RGB888! Cache size: %dKB, peak PSRAM usage ≈ %dKB",
-             (*out_width * *out_height * 3) / 1024,
-             ((*out_width * *out_height * 3) + (block_rows * *out_width * 4)) / 1024);
-    return ESP_OK;
-
 clean_up:
-    if (row_pointers != NULL) {
-        for (int i = 0; i < block_rows; i++) {
-            if (row_pointers[i] != NULL) {
-                heap_caps_free(row_pointers[i]);
-            }
-        }
-        heap_caps_free(row_pointers);
-        row_pointers = NULL;
-    }
-
-    if (*out_rgb888 != NULL) {
-        heap_caps_free(*out_rgb888);
-        *out_rgb888 = NULL;
-    }
-
-    if (png_ptr != NULL) {
-        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    }
-
-    if (fp != NULL) {
-        fclose(fp);
+    if (job.done != NULL) {
+        vSemaphoreDelete(job.done);
     }
+    ImgDecode_StageFree(bands, mark);
+    return ret;
+}
 
-    ESP_LOGE(TAG, "PNG decoding failed. All caches have been cleared.");
-    return ESP_FAIL;
+void ImgDecodeDither::ImgDecode_SetPipelined(bool enable) {
+    pipelined_ = enable;
 }
 
-esp_err_t ImgDecodeDither::ImgDecodebmp_TFOneBMPPicture(const char *bmp_path, uint8_t **out_rgb888, int *out_width, int *out_height) {
-    FILE *fp = fopen(bmp_path, "rb");
-    if (!fp) {
-        ESP_LOGE(TAG, "Cannot open BMP file: %s", bmp_path);
+esp_err_t ImgDecodeDither::ImgDecode_TFOnePicture(const char *path, const ImgRect_t *crop, uint8_t **out_rgb888, int *out_width, int *out_height) {
+    *out_rgb888      = NULL;
+    ImgRowSource *src = imgDecoderRegistry.ImgDecoderRegistry_Open(path);
+    if (src == NULL) {
         return ESP_FAIL;
     }
-
-    BITMAPFILEHEADER file_header;
-    fread(&file_header, sizeof(BITMAPFILEHEADER), 1, fp);
-    
-    if (file_header.bfType != 0x4D42) {
-        ESP_LOGE(TAG, "Not a valid BMP file! The current bfType = 0x%04X (should be 0x4D42)", file_header.bfType);
-        fclose(fp);
-        return ESP_FAIL;
+    esp_err_t ret = ImgDecode_SourceBegin(src, crop);
+    if (ret == ESP_OK) {
+        const ImgRect_t *rect = src->ImgSource_Rect();
+        *out_width            = rect->w;
+        *out_height           = rect->h;
+        *out_rgb888           = (uint8_t *) heap_caps_malloc(rect->w * rect->h * 3, MALLOC_CAP_SPIRAM);
+        ret                   = (*out_rgb888 != NULL) ? ImgDecode_SourceToRgb888(src, *out_rgb888, rect->w, rect->h) : ESP_FAIL;
+    }
+    delete src;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "img decode fill:%s", path);
+        ImgDecode_PictureBufferFree(*out_rgb888);
+        *out_rgb888 = NULL;
     }
+    return ret;
+}
 
-    BITMAPINFOHEADER info_header;
-    fread(&info_header, sizeof(BITMAPINFOHEADER), 1, fp);
-    
-    if (info_header.biBitCount != 24 || info_header.biCompression != 0) {
-        ESP_LOGE(TAG, "Only 24-bit uncompressed BMP is supported! Current bit depth: %d, Compression method: %d",
-                 info_header.biBitCount, info_header.biCompression);
-        fclose(fp);
-        return ESP_FAIL;
+void ImgDecodeDither::ImgDecode_JPGBufferFree(uint8_t *buffer) {
+    if (buffer != NULL) {
+        jpeg_free_align(buffer);
+        buffer = NULL;
     }
+}
 
-    *out_width = info_header.biWidth;
-    *out_height = abs(info_header.biHeight);
-    bool is_row_reverse = (info_header.biHeight > 0); 
-    ESP_LOGI(TAG, "BMP information: %dx%d, row reversed: %s", *out_width, *out_height, is_row_reverse ? "Y" : "N");
-
-    int bmp_row_bytes = ((*out_width) * 3 + 3) & ~3; 
-    int rgb888_row_bytes = *out_width * 3;
-
-    *out_rgb888 = (uint8_t *)heap_caps_malloc(
-                    *out_width * *out_height * 3, MALLOC_CAP_SPIRAM);
-    if (!*out_rgb888) {
-        ESP_LOGE(TAG, "Failed to allocate RGB888 cache (PSRAM needs to be enabled)");
-        fclose(fp);
-        return ESP_FAIL;
+void ImgDecodeDither::ImgDecode_PictureBufferFree(uint8_t *buffer) {
+    if (buffer != NULL) {
+        heap_caps_free(buffer);
     }
+}
 
-    fseek(fp, file_header.bfOffBits, SEEK_SET);
+void ImgDecodeDither::ImgDecode_SetTone(const ImgToneParams_t *params) {
+    tone_.ImgTone_SetParams(params);
+}
 
-    uint8_t *bmp_row_buf = (uint8_t *)malloc(bmp_row_bytes); 
-    if (!bmp_row_buf) {
-        ESP_LOGE(TAG, "Failed to allocate BMP row cache");
-        heap_caps_free(*out_rgb888);
-        fclose(fp);
-        return ESP_FAIL;
+/*误差只扩散到当前行和下一行,工作区只保留两行;下一行在处理当前行之前读入,因此 in_img 可以等于 out_img*/
+void ImgDecodeDither::ImgDecode_DitherRgb888(uint8_t *in_img, uint8_t *out_img, int w, int h) {
+    RENDER_PROFILE_SCOPE("dither", w * h * 3);
+    size_t           stride = (size_t) w * 3;
+    ImgScaleTarget_t target = {out_img, stride, stride};
+    esp_err_t        ret    = ImgDecode_DitherBegin(w, ImgDecode_RowToBuffer, &target);
+    assert(ret == ESP_OK);
+    if (ret != ESP_OK)
+        return;
+    for (int y = 0; y < h; y++) {
+        ImgDecode_DitherPushRow(in_img + y * stride);
     }
+    ImgDecode_DitherEnd();
+}
 
-    for (int y = 0; y < *out_height; y++) {
-        fread(bmp_row_buf, bmp_row_bytes, 1, fp);
-
-        int rgb888_y = is_row_reverse ? (*out_height - 1 - y) : y;
-        uint8_t *rgb888_row = *out_rgb888 + rgb888_y * rgb888_row_bytes;
-
-        for (int x = 0; x < *out_width; x++) {
-            uint8_t B = bmp_row_buf[x*3 + 0]; // BMP的B通道
-            uint8_t G = bmp_row_buf[x*3 + 1]; // BMP的G通道
-            uint8_t R = bmp_row_buf[x*3 + 2]; // BMP的R通道
-
-            rgb888_row[x*3 + 0] = R;
-            rgb888_row[x*3 + 1] = G;
-            rgb888_row[x*3 + 2] = B;
-        }
+esp_err_t ImgDecodeDither::ImgDecode_DitherBegin(int w, ImgRowSink_t sink, void *ctx) {
+    ditherWork_ = ImgDecode_StageAlloc((size_t) w * 3 * 2, &ditherMark_);
+    if (ditherWork_ == NULL) {
+        ESP_LOGE(TAG, "dither work alloc fail");
+        return ESP_FAIL;
     }
-
-    free(bmp_row_buf);
-    fclose(fp);
-
-    ESP_LOGI(TAG, "BMP decoding completed to RGB888! Cache size: %dKB", (*out_width * *out_height * 3) / 1024);
+    ditherW_    = w;
+    ditherY_    = 0;
+    ditherSink_ = sink;
+    ditherCtx_  = ctx;
+    ditherTone_ = tone_.ImgTone_Prepare();    /*色调处理合并在读入每行时完成*/
+    ditherLut_  = palette_.ImgPalette_Prepare();
     return ESP_OK;
 }
 
-void ImgDecodeDither::ImgDecode_JPGBufferFree(uint8_t *buffer) {
-    if (buffer != NULL) {
-        jpeg_free_align(buffer);
-        buffer = NULL;
+void ImgDecodeDither::ImgDecode_DitherLoadRow(const uint8_t *src, uint8_t *dst) {
+    size_t stride = (size_t) ditherW_ * 3;
+    if (ditherTone_) {
+        for (size_t i = 0; i < stride; i += 3)
+            tone_.ImgTone_Apply(src + i, dst + i);
+    } else {
+        memcpy(dst, src, stride);
     }
 }
 
-void ImgDecodeDither::ImgDecode_PNGBufferFree(uint8_t *buffer) {
-    if (buffer != NULL) {
-        heap_caps_free(buffer);
-        buffer = NULL;
+void ImgDecodeDither::ImgDecode_DitherPushRow(const uint8_t *rgb) {
+    size_t   stride = (size_t) ditherW_ * 3;
+    uint8_t *next   = ditherWork_ + (ditherY_ & 1) * stride;
+    ImgDecode_DitherLoadRow(rgb, next);
+    if (ditherY_ > 0) {
+        uint8_t *cur = ditherWork_ + ((ditherY_ - 1) & 1) * stride;
+        ImgDecode_DitherRow(cur, next);
+        ditherSink_(ditherCtx_, ditherY_ - 1, cur);
     }
+    ditherY_++;
 }
 
-void  ImgDecodeDither::ImgDecode_BMPBufferFree(uint8_t *buffer) {
-    if (buffer != NULL) {
-        heap_caps_free(buffer);
-        buffer = NULL;
+/*没有输入任何行时视为没有抖动,色调参数保留给下一次*/
+void ImgDecodeDither::ImgDecode_DitherEnd() {
+    if (ditherY_ > 0) {
+        uint8_t *cur = ditherWork_ + ((ditherY_ - 1) & 1) * (size_t) ditherW_ * 3;
+        ImgDecode_DitherRow(cur, NULL);
+        ditherSink_(ditherCtx_, ditherY_ - 1, cur);
+        tone_.ImgTone_Reset();
     }
+    ImgDecode_StageFree(ditherWork_, ditherMark_);
+    ditherWork_ = NULL;
 }
 
-void ImgDecodeDither::ImgDecode_DitherRgb888(uint8_t *in_img, uint8_t *out_img, int w, int h) {
-    uint8_t *work = (uint8_t *) malloc(w * h * 3);
-    assert(work);
-    if (!work)
-        return;
-    for (int i = 0; i < w * h * 3; i++)
-        work[i] = in_img[i];
+/*抖动一行,结果(调色板RGB)原地写回cur;next为NULL表示最后一行*/
+void ImgDecodeDither::ImgDecode_DitherRow(uint8_t *cur, uint8_t *next) {
+    int w = ditherW_;
+    for (int x = 0; x < w; x++) {
+        int     idx = x * 3;
+        uint8_t r   = cur[idx + 0];
+        uint8_t g   = cur[idx + 1];
+        uint8_t b   = cur[idx + 2];
+
+        // Find the nearest color
+        int            ci  = ditherLut_ ? palette_.ImgPalette_Nearest(r, g, b) : ImgDecode_NearestColor(r, g, b);
+        const uint8_t *ink = palette_.ImgPalette_Ink(ci);
+
+        // Output result
+        cur[idx + 0] = PALETTE[ci][0];
+        cur[idx + 1] = PALETTE[ci][1];
+        cur[idx + 2] = PALETTE[ci][2];
+
+        // Error (against the color the panel actually shows)
+        int err_r = (int) r - ink[0];
+        int err_g = (int) g - ink[1];
+        int err_b = (int) b - ink[2];
+
+        // Floyd–Steinberg diffusion
+        //     *   7
+        // 3   5   1
+        if (x + 1 < w) {
+            int n      = idx + 3;
+            cur[n + 0] = CLAMP(cur[n + 0] + (err_r * 7) / 16, 0, 255);
+            cur[n + 1] = CLAMP(cur[n + 1] + (err_g * 7) / 16, 0, 255);
+            cur[n + 2] = CLAMP(cur[n + 2] + (err_b * 7) / 16, 0, 255);
+        }
+        if (next != NULL) {
+            if (x > 0) {
+                int n       = idx - 3;
+                next[n + 0] = CLAMP(next[n + 0] + (err_r * 3) / 16, 0, 255);
+                next[n + 1] = CLAMP(next[n + 1] + (err_g * 3) / 16, 0, 255);
+                next[n + 2] = CLAMP(next[n + 2] + (err_b * 3) / 16, 0, 255);
+            }
+            next[idx + 0] = CLAMP(next[idx + 0] + (err_r * 5) / 16, 0, 255);
+            next[idx + 1] = CLAMP(next[idx + 1] + (err_g * 5) / 16, 0, 255);
+            next[idx + 2] = CLAMP(next[idx + 2] + (err_b * 5) / 16, 0, 255);
 
-    for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            int     idx = (y * w + x) * 3;
-            uint8_t r   = work[idx + 0];
-            uint8_t g   = work[idx + 1];
-            uint8_t b   = work[idx + 2];
-
-            // Find the nearest color
-            int     ci = ImgDecode_NearestColor(r, g, b);
-            uint8_t rr = PALETTE[ci][0];
-            uint8_t gg = PALETTE[ci][1];
-            uint8_t bb = PALETTE[ci][2];
-
-            // Output result
-            out_img[idx + 0] = rr;
-            out_img[idx + 1] = gg;
-            out_img[idx + 2] = bb;
-
-            // Error
-            int err_r = (int) r - rr;
-            int err_g = (int) g - gg;
-            int err_b = (int) b - bb;
-
-            // Floyd–Steinberg diffusion
-            //     *   7
-            // 3   5   1
             if (x + 1 < w) {
-                int n       = idx + 3;
-                work[n + 0] = CLAMP(work[n + 0] + (err_r * 7) / 16, 0, 255);
-                work[n + 1] = CLAMP(work[n + 1] + (err_g * 7) / 16, 0, 255);
-                work[n + 2] = CLAMP(work[n + 2] + (err_b * 7) / 16, 0, 255);
-            }
-            if (y + 1 < h) {
-                if (x > 0) {
-                    int n       = ((y + 1) * w + (x - 1)) * 3;
-                    work[n + 0] = CLAMP(work[n + 0] + (err_r * 3) / 16, 0, 255);
-                    work[n + 1] = CLAMP(work[n + 1] + (err_g * 3) / 16, 0, 255);
-                    work[n + 2] = CLAMP(work[n + 2] + (err_b * 3) / 16, 0, 255);
-                }
-                int n       = ((y + 1) * w + x) * 3;
-                work[n + 0] = CLAMP(work[n + 0] + (err_r * 5) / 16, 0, 255);
-                work[n + 1] = CLAMP(work[n + 1] + (err_g * 5) / 16, 0, 255);
-                work[n + 2] = CLAMP(work[n + 2] + (err_b * 5) / 16, 0, 255);
-
-                if (x + 1 < w) {
-                    int n2       = ((y + 1) * w + (x + 1)) * 3;
-                    work[n2 + 0] = CLAMP(work[n2 + 0] + (err_r * 1) / 16, 0, 255);
-                    work[n2 + 1] = CLAMP(work[n2 + 1] + (err_g * 1) / 16, 0, 255);
-                    work[n2 + 2] = CLAMP(work[n2 + 2] + (err_b * 1) / 16, 0, 255);
-                }
+                int n2       = idx + 3;
+                next[n2 + 0] = CLAMP(next[n2 + 0] + (err_r * 1) / 16, 0, 255);
+                next[n2 + 1] = CLAMP(next[n2 + 1] + (err_g * 1) / 16, 0, 255);
+                next[n2 + 2] = CLAMP(next[n2 + 2] + (err_b * 1) / 16, 0, 255);
             }
         }
     }
-
-    free(work);
 }
 
 esp_err_t ImgDecodeDither::ImgDecode_EncodingBmpToSdcard(const char *filename, const uint8_t *inRgb, int width, int height) {
+    RENDER_PROFILE_SCOPE("bmp_write", width * height * 3);
     FILE *f = fopen(filename, "wb");
     if (!f) {
         perror("fopen");
@@ -467,15 +498,16 @@ esp_err_t ImgDecodeDither::ImgDecode_EncodingBmpToSdcard(const char *filename, c
     return ESP_OK;
 }
 
-// Find the closest color from the palette (RGB888)
+// Find the closest color from the palette (RGB888), used when the lookup table cannot be allocated
 int ImgDecodeDither::ImgDecode_NearestColor(uint8_t r, uint8_t g, uint8_t b) {
     int best      = 0;
     int best_dist = 999999;
 
     for (int i = 0; i < 6; i++) {
-        int dr   = (int) r - PALETTE[i][0];
-        int dg   = (int) g - PALETTE[i][1];
-        int db   = (int) b - PALETTE[i][2];
+        const uint8_t *ink = palette_.ImgPalette_Ink(i);
+        int dr   = (int) r - ink[0];
+        int dg   = (int) g - ink[1];
+        int db   = (int) b - ink[2];
         int dist = dr * dr + dg * dg + db * db;
         if (dist < best_dist) {
             best_dist = dist;
@@ -485,57 +517,27 @@ int ImgDecodeDither::ImgDecode_NearestColor(uint8_t r, uint8_t g, uint8_t b) {
     return best;
 }
 
-void ImgDecodeDither::ImgDecode_ScaleRgb888Nearest(const uint8_t *src, int src_w, int src_h, uint8_t *dst, int dst_w, int dst_h) {
-    // 定点数缩放比例（×1024，精度1/1024，平衡精度和速度）
-    const int32_t scale_x = (src_w * 1024) / dst_w;
-    const int32_t scale_y = (src_h * 1024) / dst_h;
-
-    for (int y = 0; y < dst_h; y++) {
-        for (int x = 0; x < dst_w; x++) {
-            // 目标像素对应原图像的定点数坐标（×1024）
-            int32_t fx = x * scale_x;
-            int32_t fy = y * scale_y;
-
-            // 取4个相邻像素的整数坐标
-            int x1 = fx / 1024;
-            int y1 = fy / 1024;
-            int x2 = x1 + 1;
-            int y2 = y1 + 1;
-
-            // 边界处理
-            x2 = (x2 >= src_w) ? (src_w - 1) : x2;
-            y2 = (y2 >= src_h) ? (src_h - 1) : y2;
-
-            // 计算权重（0~1024，替代浮点0~1）
-            int wx = fx - x1 * 1024; // 权重x = fx - floor(fx)
-            int wy = fy - y1 * 1024; // 权重y = fy - floor(fy)
-            int wx1 = 1024 - wx;
-            int wy1 = 1024 - wy;
-
-            // 计算4个相邻像素的偏移
-            int off1 = (y1 * src_w + x1) * 3; // 左上
-            int off2 = (y1 * src_w + x2) * 3; // 右上
-            int off3 = (y2 * src_w + x1) * 3; // 左下
-            int off4 = (y2 * src_w + x2) * 3; // 右下
-
-            // 加权计算R/G/B通道（定点数运算，最后÷1024²=1048576）
-            int r = (src[off1] * wx1 * wy1 + src[off2] * wx * wy1 +
-                     src[off3] * wx1 * wy + src[off4] * wx * wy) / 1048576;
-            int g = (src[off1+1] * wx1 * wy1 + src[off2+1] * wx * wy1 +
-                     src[off3+1] * wx1 * wy + src[off4+1] * wx * wy) / 1048576;
-            int b = (src[off1+2] * wx1 * wy1 + src[off2+2] * wx * wy1 +
-                     src[off3+2] * wx1 * wy + src[off4+2] * wx * wy) / 1048576;
-
-            // 限制取值范围0~255，防止溢出
-            r = (r < 0) ? 0 : (r > 255) ? 255 : r;
-            g = (g < 0) ? 0 : (g > 255) ? 255 : g;
-            b = (b < 0) ? 0 : (b > 255) ? 255 : b;
-
-            // 写入目标像素
-            int dst_off = (y * dst_w + x) * 3;
-            dst[dst_off] = r;
-            dst[dst_off+1] = g;
-            dst[dst_off+2] = b;
-        }
+void ImgDecodeDither::ImgDecode_SetPalette(const char *name) {
+    palette_.ImgPalette_Select(name);
+}
+
+const char *ImgDecodeDither::ImgDecode_GetPalette() {
+    return palette_.ImgPalette_GetName();
+}
+
+/*源图逐行送入 ImgScaler,大比例缩小时使用区域平均,避免只采样4个像素造成的混叠*/
+void ImgDecodeDither::ImgDecode_ScaleRgb888(const uint8_t *src, int src_w, int src_h, uint8_t *dst, int dst_w, int dst_h, int dst_stride) {
+    RENDER_PROFILE_SCOPE("scale", dst_w * dst_h * 3);
+    size_t   mark;
+    uint8_t *work = ImgDecode_StageAlloc(ImgScaler::ImgScaler_WorkSize(src_w, src_h, dst_w, dst_h), &mark);
+    assert(work);
+    if (!work)
+        return;
+    ImgScaler        scaler;
+    ImgScaleTarget_t target = {dst, (size_t) (dst_stride > 0 ? dst_stride : dst_w * 3), (size_t) dst_w * 3};
+    scaler.ImgScaler_Begin(src_w, src_h, dst_w, dst_h, work, ImgDecode_RowToBuffer, &target);
+    for (int y = 0; y < src_h; y++) {
+        scaler.ImgScaler_PushRow(src + (size_t) y * src_w * 3);
     }
+    ImgDecode_StageFree(work, mark);
 }
@@ -1,6 +1,9 @@
 #pragma once
 
-#include "png.h"
+#include <stdint.h>
+#include <esp_err.h>
+#include "img_tone.h"
+#include "img_palette.h"
 
 #pragma pack(push, 1) // Ensure that the structure is aligned at 1 byte intervals.
 
@@ -35,26 +38,83 @@ typedef struct {
     uint8_t b;
 } RGB888_Pixel;
 
+/*源图中的矩形区域(像素)*/
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} ImgRect_t;
+
+/*逐行输出回调,rgb 为一行RGB888像素*/
+typedef void (*ImgRowSink_t)(void *ctx, int y, const uint8_t *rgb);
+
+class RenderArena;
+class ImgRowSource;
+
 class ImgDecodeDither
 {
 private:
     const char *TAG = "ImgDecode";
+    RenderArena *arena_ = NULL;          /*为NULL时使用malloc*/
+    ImgTone tone_;
+    ImgPalette palette_;
+    bool pipelined_ = true;
+    uint32_t pipelineRuns_ = 0;          /*流水线完整执行的次数*/
+    /*流式抖动的状态*/
+    uint8_t     *ditherWork_ = NULL;     /*两行,按行号奇偶轮换*/
+    size_t       ditherMark_ = 0;
+    int          ditherW_    = 0;
+    int          ditherY_    = 0;        /*已输入的行数*/
+    bool         ditherTone_ = false;
+    bool         ditherLut_  = false;
+    ImgRowSink_t ditherSink_ = NULL;
+    void        *ditherCtx_  = NULL;
     
     int ImgDecode_NearestColor(uint8_t r, uint8_t g, uint8_t b);
-    static void png_read_callback(png_structp png_ptr, png_bytep data, png_size_t length);
+    void ImgDecode_DitherLoadRow(const uint8_t *src, uint8_t *dst);
+    void ImgDecode_DitherRow(uint8_t *cur, uint8_t *next);
+    uint8_t *ImgDecode_StageAlloc(size_t size, size_t *mark);
+    void ImgDecode_StageFree(uint8_t *buffer, size_t mark);
 public:
-    ImgDecodeDither();
+    ImgDecodeDither(RenderArena *arena = NULL);
     ~ImgDecodeDither();
 
     esp_err_t ImgDecode_OneJPGPicture(uint8_t *inbuffer, int inlen, uint8_t **outbuffer, int *outlen);
-    esp_err_t ImgDecode_TFOneJPGPicture(const char *path,uint8_t **outbuffer, int *outlen, int *s_width, int *s_height);
-    esp_err_t ImgDecode_TFOnePNGPicture(const char *png_path, uint8_t **out_rgb888,int *out_width, int *out_height);
-    esp_err_t ImgDecodebmp_TFOneBMPPicture(const char *bmp_path, uint8_t **out_rgb888, int *out_width, int *out_height);
+    /*开始读取图片源的 crop 区域(NULL为整张),同时清空色调直方图*/
+    esp_err_t ImgDecode_SourceBegin(ImgRowSource *src, const ImgRect_t *crop);
+    /*把 Begin 之后的全部行缩放到 dst_w x dst_h 写入dst,dst_stride为0表示dst_w*3;边读边统计色调直方图*/
+    esp_err_t ImgDecode_SourceToRgb888(ImgRowSource *src, uint8_t *dst, int dst_w, int dst_h, int dst_stride = 0);
+    /*同上,但每输出一行调用一次sink(y从0开始),不需要目标缓冲区*/
+    esp_err_t ImgDecode_SourceToRows(ImgRowSource *src, int dst_w, int dst_h, ImgRowSink_t sink, void *ctx);
+    /*
+     * 流水线渲染:解码和缩放在另一个核上的任务中进行,按行带经有界队列交给当前任务抖动,抖动后的画布行通过sink输出
+     * 画布中 dst 以外的部分填充 background(RGB);不需要整帧画布,总耗时接近最慢的一级而不是各级之和
+     * 未开启、色调需要整图直方图或任务创建失败时返回 ESP_ERR_NOT_SUPPORTED,此时图片源未被读取,可改用顺序流程
+     */
+    esp_err_t ImgDecode_SourceDitherPipelined(ImgRowSource *src, int canvas_w, int canvas_h, const ImgRect_t *dst,
+                                              const uint8_t *background, ImgRowSink_t sink, void *ctx);
+    void ImgDecode_SetPipelined(bool enable);
+    uint32_t ImgDecode_GetPipelineRuns() { return pipelineRuns_; }
+    /*按文件内容选择解码器,输出用 ImgDecode_PictureBufferFree 释放*/
+    esp_err_t ImgDecode_TFOnePicture(const char *path, const ImgRect_t *crop, uint8_t **out_rgb888, int *out_width, int *out_height);
     void ImgDecode_JPGBufferFree(uint8_t *buffer);
-    void ImgDecode_PNGBufferFree(uint8_t *buffer);
-    void ImgDecode_BMPBufferFree(uint8_t *buffer);
-    void ImgDecode_DitherRgb888(uint8_t *in_img, uint8_t *out_img, int w, int h);
+    void ImgDecode_PictureBufferFree(uint8_t *buffer);
+    /*色调参数只对下一次 ImgDecode_DitherRgb888 生效,直方图在 ImgDecode_SourceToRgb888 读取时统计*/
+    void ImgDecode_SetTone(const ImgToneParams_t *params);
+    /*切换调色板配置("ideal"/"spectra6"),对之后所有抖动生效*/
+    void ImgDecode_SetPalette(const char *name);
+    const char *ImgDecode_GetPalette();
+    void ImgDecode_DitherRgb888(uint8_t *in_img, uint8_t *out_img, int w, int h);    /*in_img 可以等于 out_img*/
+    /*
+     * 流式抖动:依次输入各行,误差要扩散到下一行,所以第y行在输入第y+1行(最后一行在 DitherEnd)时才通过sink输出
+     * sink 收到的行缓冲区在返回后会被复用
+     */
+    esp_err_t ImgDecode_DitherBegin(int w, ImgRowSink_t sink, void *ctx);
+    void ImgDecode_DitherPushRow(const uint8_t *rgb);
+    void ImgDecode_DitherEnd();
     esp_err_t ImgDecode_EncodingBmpToSdcard(const char *filename, const uint8_t *inRgb, int width, int height);
-    /*拉伸缩放算法*/
-    void ImgDecode_ScaleRgb888Nearest(const uint8_t *src, int src_w, int src_h, uint8_t *dst, int dst_w, int dst_h);
+    /*拉伸缩放算法,缩小超过1.5倍时为区域平均,否则为双线性*/
+    /*dst_stride为目标缓冲区每行字节数,0表示dst_w*3,用于缩放到画布中的一块区域*/
+    void ImgDecode_ScaleRgb888(const uint8_t *src, int src_w, int src_h, uint8_t *dst, int dst_w, int dst_h, int dst_stride = 0);
 };
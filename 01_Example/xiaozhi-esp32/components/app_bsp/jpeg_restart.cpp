@@ -0,0 +1,141 @@
+#include <string.h>
+#include "jpeg_restart.h"
+
+#define JPEG_BE16(p) (((p)[0] << 8) | (p)[1])
+
+bool JpegRestart_Plan(const uint8_t *buf, size_t len, int want_row, JpegRestartPlan_t *plan) {
+    int    restart = 0;
+    int    comps   = 0;
+    int    maxH    = 1;
+    int    maxV    = 1;
+    size_t pos     = 2;
+    memset(plan, 0, sizeof(*plan));
+    if (len < 4 || buf[0] != 0xFF || buf[1] != 0xD8) {
+        return false;
+    }
+    /*解析各段直到 SOS*/
+    while (pos + 4 <= len && buf[pos] == 0xFF) {
+        uint8_t marker = buf[pos + 1];
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        size_t seglen = JPEG_BE16(buf + pos + 2);
+        if (seglen < 2 || pos + 2 + seglen > len) {
+            return false;
+        }
+        const uint8_t *seg = buf + pos + 4;
+        if (marker == 0xC0 || marker == 0xC1) {
+            /*长度(2) 精度(1) 高宽(4) 分量数(1),之后每个分量3字节*/
+            if (seglen < 8 || seg[5] == 0 || seglen != 8 + (size_t) seg[5] * 3) {
+                return false;
+            }
+            plan->sofHeightPos = pos + 5;
+            plan->height       = JPEG_BE16(seg + 1);
+            plan->width        = JPEG_BE16(seg + 3);
+            comps              = seg[5];
+            for (int i = 0; i < comps; i++) {
+                int h = seg[6 + i * 3 + 1] >> 4;
+                int v = seg[6 + i * 3 + 1] & 0x0F;
+                maxH  = h > maxH ? h : maxH;
+                maxV  = v > maxV ? v : maxV;
+            }
+        } else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            return false;                                   /*渐进式/无损/算术编码*/
+        } else if (marker == 0xDD) {
+            if (seglen < 4) {
+                return false;
+            }
+            restart = JPEG_BE16(seg);
+        } else if (marker == 0xDA) {
+            if (seglen < 3 || seg[0] != comps) {
+                return false;                               /*分量分多次扫描*/
+            }
+            plan->headerLen = pos + 2 + seglen;
+            break;
+        }
+        pos += 2 + seglen;
+    }
+    if (plan->headerLen == 0 || restart == 0 || plan->height <= 0) {
+        return false;
+    }
+    if (comps == 1) {                                       /*单分量时MCU固定为8x8*/
+        maxH = maxV = 1;
+    }
+    int mcuW    = maxH * 8;
+    int mcuH    = maxV * 8;
+    int mcusRow = (plan->width + mcuW - 1) / mcuW;
+    int mcuRows = (plan->height + mcuH - 1) / mcuH;
+    /*从 want_row 所在的MCU行向两边找,分割点必须是重启间隔的整数倍*/
+    int want = want_row / mcuH;
+    int row  = 0;
+    for (int d = 0; d < mcuRows && row == 0; d++) {
+        int cand[2] = {want - d, want + d};
+        for (int c = 0; c < 2; c++) {
+            if (cand[c] >= 1 && cand[c] < mcuRows && ((long) cand[c] * mcusRow) % restart == 0) {
+                row = cand[c];
+                break;
+            }
+        }
+    }
+    if (row == 0) {
+        return false;
+    }
+    plan->topRows  = row * mcuH;
+    plan->rstIndex = (int) ((long) row * mcusRow / restart);
+
+    /*在熵编码数据中数 RSTn 标记,跳过填充字节 FF00*/
+    int count = 0;
+    for (size_t i = plan->headerLen; i + 1 < len;) {
+        const uint8_t *ff = (const uint8_t *) memchr(buf + i, 0xFF, len - 1 - i);
+        if (ff == NULL) {
+            break;
+        }
+        i              = ff - buf;
+        uint8_t marker = buf[i + 1];
+        if (marker == 0x00 || marker == 0xFF) {
+            i += (marker == 0x00) ? 2 : 1;
+        } else if (marker >= 0xD0 && marker <= 0xD7) {
+            if (++count == plan->rstIndex) {
+                plan->splitPos = i;
+                return true;
+            }
+            i += 2;
+        } else {
+            break;                                          /*EOI 或其他标记*/
+        }
+    }
+    return false;
+}
+
+size_t JpegRestart_BottomLen(size_t len, const JpegRestartPlan_t *plan) {
+    return plan->headerLen + (len - plan->splitPos - 2);
+}
+
+size_t JpegRestart_Split(uint8_t *buf, size_t len, const JpegRestartPlan_t *plan, uint8_t *bottom) {
+    int bottomRows = plan->height - plan->topRows;
+    memcpy(bottom, buf, plan->headerLen);
+    bottom[plan->sofHeightPos]     = bottomRows >> 8;
+    bottom[plan->sofHeightPos + 1] = bottomRows & 0xFF;
+    /*解码器要求重启标记从 RST0 开始依次编号*/
+    const uint8_t *src   = buf + plan->splitPos + 2;
+    uint8_t       *dst   = bottom + plan->headerLen;
+    size_t         n     = len - plan->splitPos - 2;
+    int            shift = plan->rstIndex & 7;
+    memcpy(dst, src, n);
+    for (size_t i = 0; i + 1 < n; i++) {
+        if (dst[i] == 0xFF) {
+            uint8_t marker = dst[i + 1];
+            if (marker >= 0xD0 && marker <= 0xD7) {
+                dst[i + 1] = 0xD0 | ((marker - 0xD0 - shift) & 7);
+                i++;
+            } else if (marker == 0x00) {
+                i++;
+            }
+        }
+    }
+    buf[plan->sofHeightPos]     = plan->topRows >> 8;
+    buf[plan->sofHeightPos + 1] = plan->topRows & 0xFF;
+    buf[plan->splitPos + 1]     = 0xD9;
+    return plan->splitPos + 2;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*在重启标记(RSTn)处把一个基线JPG分成上下两个可以独立解码的JPG*/
+typedef struct {
+    size_t headerLen;       /*SOS段结束(熵编码数据开始)的位置*/
+    size_t sofHeightPos;    /*SOF段中高度字段的位置*/
+    size_t splitPos;        /*分割处 RSTn 标记的位置*/
+    int    rstIndex;        /*分割处是第几个重启标记(从1开始)*/
+    int    width;
+    int    height;
+    int    topRows;         /*上半部分的行数,MCU行高的整数倍*/
+} JpegRestartPlan_t;
+
+/*
+ * 查找离 want_row 最近、并且正好落在MCU行边界上的重启标记
+ * 只支持单次扫描(基线/扩展顺序)并带 DRI 的文件,其他情况返回false,由调用者按单线程解码
+ */
+bool   JpegRestart_Plan(const uint8_t *buf, size_t len, int want_row, JpegRestartPlan_t *plan);
+size_t JpegRestart_BottomLen(size_t len, const JpegRestartPlan_t *plan);
+/*
+ * 把下半部分写入bottom(JpegRestart_BottomLen字节),重启标记重新从RST0编号;
+ * 然后原地把buf改成上半部分(修改高度并在分割处写入EOI),返回上半部分的长度
+ */
+size_t JpegRestart_Split(uint8_t *buf, size_t len, const JpegRestartPlan_t *plan, uint8_t *bottom);
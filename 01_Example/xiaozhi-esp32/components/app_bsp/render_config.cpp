@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "ArduinoJson.h"
+#include "render_config.h"
+#include "render_profiler.h"
+#include "img_source.h"
+
+RenderConfig renderConfig;
+
+static const ImgRenderOptions_t RenderDefaultOptions = {ImgFitStretch, {255, 255, 255}, 500, 500, IMG_TONE_DEFAULT_PARAMS};
+
+static int RenderConfig_Clamp(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+/*只覆盖 v 中出现的项,未出现的沿用 opts 原值(全局配置)*/
+static void RenderConfig_ParseOptions(JsonVariantConst v, ImgRenderOptions_t *opts) {
+    const char *mode = v["mode"];
+    if (mode != NULL) {
+        if (!strcmp(mode, "fit")) {
+            opts->mode = ImgFitFit;
+        } else if (!strcmp(mode, "fill")) {
+            opts->mode = ImgFitFill;
+        } else {
+            opts->mode = ImgFitStretch;
+        }
+    }
+    JsonVariantConst bg = v["background"];
+    if (bg.is<const char *>()) {
+        uint8_t c = strcmp(bg.as<const char *>(), "black") ? 255 : 0;
+        memset(opts->background, c, 3);
+    } else if (bg.is<JsonArrayConst>() && bg.size() == 3) {
+        for (int i = 0; i < 3; i++) {
+            opts->background[i] = RenderConfig_Clamp(bg[i].as<int>(), 0, 255);
+        }
+    }
+    JsonVariantConst focus = v["focus"];
+    if (focus.is<JsonArrayConst>() && focus.size() == 2) {
+        opts->focus_x = RenderConfig_Clamp((int) (focus[0].as<float>() * 1000 + 0.5f), 0, 1000);
+        opts->focus_y = RenderConfig_Clamp((int) (focus[1].as<float>() * 1000 + 0.5f), 0, 1000);
+    }
+    JsonVariantConst tone = v["tone"];
+    if (tone.is<JsonObjectConst>()) {
+        opts->tone.gamma       = tone["gamma"] | opts->tone.gamma;
+        opts->tone.contrast    = tone["contrast"] | opts->tone.contrast;
+        opts->tone.saturation  = tone["saturation"] | opts->tone.saturation;
+        opts->tone.auto_levels = tone["auto_levels"] | opts->tone.auto_levels;
+        opts->tone.clip        = tone["clip"] | opts->tone.clip;
+    }
+}
+
+RenderConfig::RenderConfig() :
+global_(RenderDefaultOptions) {
+    strcpy(palette_, "ideal");
+}
+
+bool RenderConfig::RenderConfig_Load(const char *path) {
+    global_     = RenderDefaultOptions;
+    imageCount_ = 0;
+    strcpy(palette_, "ideal");
+    loaded_     = false;        /*读取并解析成功后才置位,SD卡还没挂载时下次使用会重新读取*/
+    renderProfiler.RenderProfiler_SetVerbose(false);
+    ImgSourceJpg_SetParallel(false);
+    FILE *fp    = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    char  *buf = (char *) heap_caps_malloc(RENDER_CONFIG_FILE_MAX, MALLOC_CAP_SPIRAM);
+    size_t len = buf ? fread(buf, 1, RENDER_CONFIG_FILE_MAX, fp) : 0;
+    fclose(fp);
+    if (buf == NULL) {
+        return false;
+    }
+    JsonDocument         doc;
+    DeserializationError error = deserializeJson(doc, buf, len);
+    heap_caps_free(buf);
+    if (error) {
+        ESP_LOGE(TAG, "Parsing failed:%s", error.c_str());
+        return false;
+    }
+    loaded_                 = true;
+    JsonVariantConst render = doc["render"];
+    if (render.isNull()) {
+        return true;
+    }
+    RenderConfig_ParseOptions(render, &global_);
+    renderProfiler.RenderProfiler_SetVerbose(render["profile"] | false);
+    ImgSourceJpg_SetParallel(render["jpeg_split"] | false);
+    const char *palette = render["palette"];
+    if (palette != NULL) {
+        snprintf(palette_, sizeof(palette_), "%s", palette);
+    }
+    for (JsonPairConst kv : render["images"].as<JsonObjectConst>()) {
+        if (imageCount_ >= RENDER_CONFIG_IMAGE_MAX) {
+            ESP_LOGW(TAG, "too many images, max:%d", RENDER_CONFIG_IMAGE_MAX);
+            break;
+        }
+        ImgRenderOverride_t *img = &images_[imageCount_++];
+        snprintf(img->name, sizeof(img->name), "%s", kv.key().c_str());
+        img->opts = global_;
+        RenderConfig_ParseOptions(kv.value(), &img->opts);
+    }
+    ESP_LOGI(TAG, "mode:%d palette:%s images:%d", global_.mode, palette_, imageCount_);
+    return true;
+}
+
+void RenderConfig::RenderConfig_Get(const char *img_path, ImgRenderOptions_t *opts) {
+    if (!loaded_) {
+        RenderConfig_Load();
+    }
+    const char *name = strrchr(img_path, '/');
+    name             = name ? name + 1 : img_path;
+    for (int i = 0; i < imageCount_; i++) {
+        if (!strcasecmp(images_[i].name, name)) {
+            *opts = images_[i].opts;
+            return;
+        }
+    }
+    *opts = global_;
+}
+
+const char *RenderConfig::RenderConfig_GetPalette() {
+    if (!loaded_) {
+        RenderConfig_Load();
+    }
+    return palette_;
+}
+
+void RenderConfig::RenderConfig_Layout(int src_w, int src_h, int canvas_w, int canvas_h, const ImgRenderOptions_t *opts, ImgRect_t *crop, ImgRect_t *dst) {
+    *crop           = {0, 0, src_w, src_h};
+    *dst            = {0, 0, canvas_w, canvas_h};
+    bool src_wider  = (int64_t) src_w * canvas_h > (int64_t) src_h * canvas_w;
+    if (opts->mode == ImgFitFit) {
+        if (src_wider) {
+            dst->h = (int) (((int64_t) src_h * canvas_w + src_w / 2) / src_w);
+        } else {
+            dst->w = (int) (((int64_t) src_w * canvas_h + src_h / 2) / src_h);
+        }
+        dst->w = RenderConfig_Clamp(dst->w, 1, canvas_w);
+        dst->h = RenderConfig_Clamp(dst->h, 1, canvas_h);
+        dst->x = (canvas_w - dst->w) / 2;
+        dst->y = (canvas_h - dst->h) / 2;
+    } else if (opts->mode == ImgFitFill) {
+        if (src_wider) {
+            crop->w = (int) (((int64_t) src_h * canvas_w + canvas_h / 2) / canvas_h);
+        } else {
+            crop->h = (int) (((int64_t) src_w * canvas_h + canvas_w / 2) / canvas_w);
+        }
+        crop->w = RenderConfig_Clamp(crop->w, 1, src_w);
+        crop->h = RenderConfig_Clamp(crop->h, 1, src_h);
+        crop->x = RenderConfig_Clamp(src_w * opts->focus_x / 1000 - crop->w / 2, 0, src_w - crop->w);
+        crop->y = RenderConfig_Clamp(src_h * opts->focus_y / 1000 - crop->h / 2, 0, src_h - crop->h);
+    }
+}
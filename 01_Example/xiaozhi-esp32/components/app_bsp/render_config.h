@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include "imgdecode_app.h"
+#include "img_tone.h"
+
+#define RENDER_CONFIG_PATH      "/sdcard/06_user_foundation_img/config.txt"
+#define RENDER_CONFIG_IMAGE_MAX 16                /*config.txt 中可单独设置的图片数量*/
+#define RENDER_CONFIG_FILE_MAX  4096
+
+/*源图与屏幕宽高比不一致时的处理方式*/
+enum ImgFitMode {
+    ImgFitStretch = 0, /*拉伸到整屏,会变形*/
+    ImgFitFit,         /*等比缩放到屏幕内,四周留边*/
+    ImgFitFill,        /*等比缩放铺满屏幕,按焦点裁掉多出的部分*/
+};
+
+typedef struct {
+    ImgFitMode mode;
+    uint8_t    background[3]; /*fit 模式留边颜色 RGB*/
+    uint16_t   focus_x;       /*fill 模式裁剪焦点,千分比,500为居中*/
+    uint16_t   focus_y;
+    ImgToneParams_t tone;
+} ImgRenderOptions_t;
+
+/*
+ * config.txt 中的渲染配置,例:
+ * "render": {"mode": "fill", "background": "white", "focus": [0.5, 0.3], "palette": "spectra6", "profile": false,
+ *            "tone": {"gamma": 1.0, "contrast": 1.1, "saturation": 1.2, "auto_levels": true, "clip": 0.5},
+ *            "images": {"1200x675.jpg": {"mode": "fit"}}}
+ * profile 为 true 时渲染各阶段耗时逐条打印,并在每次刷新后写入 render_profile.json
+ * jpeg_split 为 true 时带重启标记的JPG分成两半并行解码
+ */
+class RenderConfig
+{
+private:
+    const char *TAG = "RenderConfig";
+    typedef struct {
+        char               name[64];
+        ImgRenderOptions_t opts;
+    } ImgRenderOverride_t;
+
+    ImgRenderOptions_t  global_;
+    ImgRenderOverride_t images_[RENDER_CONFIG_IMAGE_MAX];
+    int                 imageCount_ = 0;
+    char                palette_[16];
+    bool                loaded_     = false;
+
+public:
+    RenderConfig();
+
+    bool RenderConfig_Load(const char *path = RENDER_CONFIG_PATH); /*重新读取,文件不存在或无 render 项时为 stretch*/
+    void RenderConfig_Get(const char *img_path, ImgRenderOptions_t *opts);
+    const char *RenderConfig_GetPalette();               /*调色板配置名,全局生效*/
+    /*根据模式计算源图裁剪区域 crop 及其在 canvas_w x canvas_h 画布中的目标区域 dst*/
+    static void RenderConfig_Layout(int src_w, int src_h, int canvas_w, int canvas_h, const ImgRenderOptions_t *opts, ImgRect_t *crop, ImgRect_t *dst);
+};
+
+extern RenderConfig renderConfig;
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <ctype.h>
 #include <esp_check.h>
 #include <esp_http_server.h>
 #include <esp_log.h>
@@ -8,12 +9,20 @@
 #include "button_bsp.h"
 #include "mdns.h"
 #include "user_app.h"
+#include "render_profiler.h"
+#include "sd_benchmark.h"
+#include "web_asset_cache.h"
+#include "img_source.h"
+#include "frame_unpack.h"
+#include "sd_library.h"
 
 static const char *TAG = "server_bsp";
 
 #define ServerPort_MIN(x, y) ((x < y) ? (x) : (y))
 #define READ_LEN_MAX (10 * 1024) // Buffer area for receiving data
 #define SEND_LEN_MAX (5 * 1024)  // Data for sending response
+#define IMAGE_UP_LEN_MAX (2 * 1024 * 1024)              /*/imageUP 压缩图片的最大长度*/
+#define IMAGE_UP_KEEP_DIR "/sdcard/06_user_foundation_img"
 
 #define BSP_ESP_WIFI_SSID "esp_network"
 #define BSP_ESP_WIFI_PASS "1234567890"
@@ -23,12 +32,16 @@ static const char *TAG = "server_bsp";
 EventGroupHandle_t ServerPortGroups;
 static CustomSDPort *SDPort_ = NULL;
 static uint8_t netMode = 0;   //Default AP mode
+static WebAssetCache AssetCache;
+static QueueHandle_t ImageQueue = NULL;     /*ServerPortImage_t,等待显示任务取走*/
 const char staresp[] = "1";
 const char apresp[] = "0";
 
 /*callback fun*/
 esp_err_t static_resource_unified_handler(httpd_req_t *req);
 esp_err_t receive_data_redirect_handler(httpd_req_t *req);
+esp_err_t receive_image_handler(httpd_req_t *req);
+esp_err_t receive_frame_handler(httpd_req_t *req);
 esp_err_t unknown_uri_handler(httpd_req_t *req);
 void sta_wifi_event_callback(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
 void ap_wifi_event_callback(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
@@ -60,91 +73,91 @@ void sta_wifi_event_callback(void *arg, esp_event_base_t event_base, int32_t eve
     }
 }
 
+/*一个文件只打开一次,预读整块后按 SEND_LEN_MAX 分块发送;后台预读下一块,发送的同时读SD卡*/
+static void static_file_send(httpd_req_t *req, const char *path, const char *type) {
+    SDPortReader_t *reader   = SDPort_->SDPort_ReaderOpen(path, 0, true);
+    char           *resp_str = (char *) heap_caps_malloc(SEND_LEN_MAX, MALLOC_CAP_SPIRAM);
+    int             str_len  = 0;
+    httpd_resp_set_type(req, type);
+    if (reader == NULL || resp_str == NULL) {
+        ESP_LOGE(TAG, "static file open fill:%s", path);
+        if (reader != NULL) {
+            SDPort_->SDPort_ReaderClose(reader);
+        }
+        customfree(resp_str);
+        return;
+    }
+    while ((str_len = SDPort_->SDPort_ReaderRead(reader, resp_str, SEND_LEN_MAX)) > 0) {
+        if (httpd_resp_send_chunk(req, resp_str, str_len) != ESP_OK) {
+            break;
+        }
+    }
+    SDPort_->SDPort_ReaderClose(reader);
+    customfree(resp_str);
+}
+
+/*从内存发送缓存的网页文件;ETag 与 If-None-Match 相同时只回 304*/
+static esp_err_t static_asset_send(httpd_req_t *req, const WebAsset_t *asset) {
+    char inm[sizeof(asset->etag)];
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", WEB_ASSET_CACHE_CONTROL);
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) == ESP_OK && !strcmp(inm, asset->etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_type(req, asset->type);
+    if (asset->gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+    return httpd_resp_send(req, (const char *) asset->data, asset->len);
+}
+
+/*客户端是否接受 gzip,不接受时压缩过的缓存不能用*/
+static bool static_accept_gzip(httpd_req_t *req) {
+    char accept[64];
+    return httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept, sizeof(accept)) != ESP_ERR_NOT_FOUND && strstr(accept, "gzip") != NULL;
+}
+
 esp_err_t static_resource_unified_handler(httpd_req_t *req) {
     char  *resp_str      = NULL;
-    size_t str_respLen   = 0;
     size_t str_len       = 0;
     const char *uri = req->uri;                                     // The desired URI
     ESP_LOGI(TAG, "Return directly URL:%s",uri);
 
+    const WebAsset_t *asset = AssetCache.WebAssetCache_Find(uri);
+    if (asset != NULL && (!asset->gzip || static_accept_gzip(req))) {
+        return static_asset_send(req, asset);
+    }
     if(strstr(uri,"index.html")) { // /index.html
-        resp_str      = (char *) heap_caps_malloc(SEND_LEN_MAX + 1, MALLOC_CAP_SPIRAM);
-        httpd_resp_set_type(req, "text/html");
-        while(1) {
-            str_len = SDPort_->SDPort_ReadOffset("/sdcard/03_sys_ap_html/index.html",resp_str,SEND_LEN_MAX,str_respLen);
-            if (str_len) {
-                httpd_resp_send_chunk(req, resp_str, str_len); 
-                str_respLen += str_len;
-            } else {
-                break;
-            }
-        }
+        static_file_send(req, "/sdcard/03_sys_ap_html/index.html", "text/html");
     } else if(strstr(uri,"bootstrap.min.css")) { // /bootstrap.min.css
-        resp_str      = (char *) heap_caps_malloc(SEND_LEN_MAX + 1, MALLOC_CAP_SPIRAM);
-        httpd_resp_set_type(req, "text/css");
-        while(1) {
-            str_len = SDPort_->SDPort_ReadOffset("/sdcard/03_sys_ap_html/bootstrap.min.css",resp_str,SEND_LEN_MAX,str_respLen);
-            if (str_len) {
-                httpd_resp_send_chunk(req, resp_str, str_len); 
-                str_respLen += str_len;
-            } else {
-                break;
-            }
-        }
+        static_file_send(req, "/sdcard/03_sys_ap_html/bootstrap.min.css", "text/css");
     } else if(strstr(uri,"styles.min.css")) { // /styles.min.css
-        resp_str      = (char *) heap_caps_malloc(SEND_LEN_MAX + 1, MALLOC_CAP_SPIRAM);
-        httpd_resp_set_type(req, "text/css");
-        while(1) {
-            str_len = SDPort_->SDPort_ReadOffset("/sdcard/03_sys_ap_html/styles.min.css",resp_str,SEND_LEN_MAX,str_respLen);
-            if (str_len) {
-                httpd_resp_send_chunk(req, resp_str, str_len); 
-                str_respLen += str_len;
-            } else {
-                break;
-            }
-        }
+        static_file_send(req, "/sdcard/03_sys_ap_html/styles.min.css", "text/css");
     } else if(strstr(uri,"placeholder.svg")) { // /placeholder.svg
-        resp_str      = (char *) heap_caps_malloc(SEND_LEN_MAX + 1, MALLOC_CAP_SPIRAM);
-        httpd_resp_set_type(req, "image/svg+xml");
-        while(1) {
-            str_len = SDPort_->SDPort_ReadOffset("/sdcard/03_sys_ap_html/placeholder.svg",resp_str,SEND_LEN_MAX,str_respLen);
-            if (str_len) {
-                httpd_resp_send_chunk(req, resp_str, str_len); 
-                str_respLen += str_len;
-            } else {
-                break;
-            }
-        }
+        static_file_send(req, "/sdcard/03_sys_ap_html/placeholder.svg", "image/svg+xml");
     } else if(strstr(uri,"bootstrap.min.js")) { // /bootstrap.min.js
-        resp_str      = (char *) heap_caps_malloc(SEND_LEN_MAX + 1, MALLOC_CAP_SPIRAM);
-        httpd_resp_set_type(req, "text/javascript");
-        while(1) {
-            str_len = SDPort_->SDPort_ReadOffset("/sdcard/03_sys_ap_html/bootstrap.min.js",resp_str,SEND_LEN_MAX,str_respLen);
-            if (str_len) {
-                httpd_resp_send_chunk(req, resp_str, str_len); 
-                str_respLen += str_len;
-            } else {
-                break;
-            }
-        }
+        static_file_send(req, "/sdcard/03_sys_ap_html/bootstrap.min.js", "text/javascript");
     } else if(strstr(uri,"script.min.js")) { // /script.min.js
-        resp_str      = (char *) heap_caps_malloc(SEND_LEN_MAX + 1, MALLOC_CAP_SPIRAM);
-        httpd_resp_set_type(req, "text/javascript");
-        while(1) {
-            str_len = SDPort_->SDPort_ReadOffset("/sdcard/03_sys_ap_html/script.min.js",resp_str,SEND_LEN_MAX,str_respLen);
-            if (str_len) {
-                httpd_resp_send_chunk(req, resp_str, str_len); 
-                str_respLen += str_len;
-            } else {
-                break;
-            }
-        }
+        static_file_send(req, "/sdcard/03_sys_ap_html/script.min.js", "text/javascript");
+    } else if(strstr(uri,"/SDBenchmark")) {   /*上次存储性能测试的结果,JSON*/
+        static_file_send(req, SD_BENCHMARK_RESULT, "application/json");
     } else if(strstr(uri,"/NetWorkStatus")) {
         if(Get_CurrentlyNetworkMode()) {
             httpd_resp_send_chunk(req, staresp, HTTPD_RESP_USE_STRLEN);
         } else {
             httpd_resp_send_chunk(req, apresp, HTTPD_RESP_USE_STRLEN);
         }
+    } else if(strstr(uri,"/RenderProfile")) {   /*渲染各阶段耗时,JSON*/
+        size_t json_len = RENDER_PROFILER_RECORD_MAX * 160 + 64;
+        resp_str        = (char *) heap_caps_malloc(json_len, MALLOC_CAP_SPIRAM);
+        if (resp_str == NULL) {
+            return ESP_FAIL;
+        }
+        httpd_resp_set_type(req, "application/json");
+        str_len = renderProfiler.RenderProfiler_ToJson(resp_str, json_len);
+        httpd_resp_send_chunk(req, resp_str, str_len);
     } else {     /*留给unknown_uri_handler处理*/
         customfree(resp_str);
         return ESP_FAIL;
@@ -164,39 +177,51 @@ esp_err_t receive_data_redirect_handler(httpd_req_t *req) {
     bool        is_NetworkMode = 1;  /*Handling the flag bits for the ESP32 mode*/
     ESP_LOGW("TAG", "Receive url:%s,byte:%d", uri, remaining);
     xEventGroupSetBits(ServerPortGroups, (0x1UL << 0)); 
-    SDPort_->SDPort_WriteOffset("/sdcard/02_sys_ap_img/user_send.bmp", NULL, 0, 0);
+    /*整个上传只打开一次文件,先写临时文件,校验通过后才替换 user_send.bmp*/
+    SDPortWriter_t *writer = SDPort_->SDPort_WriterOpen("/sdcard/02_sys_ap_img/user_send.bmp");
+    if (writer == NULL) {
+        httpd_resp_send_500(req);
+        customfree(buf);
+        return ESP_FAIL;
+    }
     while (remaining > 0) {
         if ((ret = httpd_req_recv(req, buf, ServerPort_MIN(remaining, READ_LEN_MAX))) <= 0) {
             if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
                 timeoutive++;
                 if(timeoutive == 10) {
                     httpd_resp_send_408(req);
+                    SDPort_->SDPort_WriterAbort(writer);
                     customfree(buf);
                     return ESP_FAIL;
                 }
                 continue;
             }
+            SDPort_->SDPort_WriterAbort(writer);
             customfree(buf);
             return ESP_FAIL;
         }
-        size_t req_len = 0;
+        int req_len = 0;
         if(is_NetworkMode) {
             is_NetworkMode = 0;
             netMode = buf[0];
-            req_len = SDPort_->SDPort_WriteOffset("/sdcard/02_sys_ap_img/user_send.bmp", (buf + 1), (ret - 1), 1);
-            sdcard_len += req_len; // Final comparison result
-            remaining -= ret;      // Subtract the data that has already been received
+            req_len = SDPort_->SDPort_WriterWrite(writer, (buf + 1), (ret - 1));
         } else {
-            req_len = SDPort_->SDPort_WriteOffset("/sdcard/02_sys_ap_img/user_send.bmp", buf, ret, 1);
-            sdcard_len += req_len; // Final comparison result
-            remaining -= ret;      // Subtract the data that has already been received
+            req_len = SDPort_->SDPort_WriterWrite(writer, buf, ret);
+        }
+        if (req_len < 0) {
+            break;
         }
+        sdcard_len += req_len; // Final comparison result
+        remaining -= ret;      // Subtract the data that has already been received
     }
     xEventGroupSetBits(ServerPortGroups, (0x1UL << 1)); 
-    if ((sdcard_len + 1) == req->content_len) {
+    if ((sdcard_len + 1) == req->content_len && SDPort_->SDPort_WriterCommit(writer) == ESP_OK) {
         httpd_resp_send(req, "Data verification successful", strlen("Data verification successful"));
         xEventGroupSetBits(ServerPortGroups, (0x1UL << 2));
     } else {
+        if ((sdcard_len + 1) != req->content_len) {
+            SDPort_->SDPort_WriterAbort(writer);
+        }
         httpd_resp_send_408(req);
         xEventGroupSetBits(ServerPortGroups, (0x1UL << 3));
     } 
@@ -205,6 +230,187 @@ esp_err_t receive_data_redirect_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+/*保存原图时的文件名只允许字母数字和 ._-,不能以 . 开头*/
+static bool image_keep_name(httpd_req_t *req, char *name, size_t len) {
+    char query[96];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "keep", name, len) != ESP_OK || name[0] == '\0' || name[0] == '.') {
+        return false;
+    }
+    for (const char *p = name; *p; p++) {
+        if (!isalnum((unsigned char) *p) && *p != '.' && *p != '_' && *p != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * 接收已注册解码器能解的 JPG/PNG 等压缩图片,直接收进 PSRAM 交给显示任务解码抖动,不经过SD卡上的BMP
+ * ?keep=name.jpg 时同时把原图流式写入图库目录
+ */
+esp_err_t receive_image_handler(httpd_req_t *req) {
+    size_t          remaining  = req->content_len;
+    size_t          got        = 0;
+    uint8_t         timeoutive = 0;
+    SDPortWriter_t *writer     = NULL;
+    char            name[64];
+    char            path[128];
+    ESP_LOGW(TAG, "Receive image:%s,byte:%d", req->uri, remaining);
+    if (remaining == 0 || remaining > IMAGE_UP_LEN_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Image size not supported");
+        return ESP_OK;
+    }
+    uint8_t *image = (uint8_t *) heap_caps_malloc(remaining, MALLOC_CAP_SPIRAM);
+    if (image == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    if (image_keep_name(req, name, sizeof(name))) {
+        snprintf(path, sizeof(path), "%s/%s", IMAGE_UP_KEEP_DIR, name);
+        writer = SDPort_->SDPort_WriterOpen(path);
+    }
+    xEventGroupSetBits(ServerPortGroups, (0x1UL << 0));
+    while (remaining > 0) {
+        int ret = httpd_req_recv(req, (char *) image + got, ServerPort_MIN(remaining, READ_LEN_MAX));
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeoutive < 10) {
+                continue;
+            }
+            break;
+        }
+        if (writer != NULL && SDPort_->SDPort_WriterWrite(writer, image + got, ret) < 0) {
+            SDPort_->SDPort_WriterAbort(writer);      /*保存失败不影响显示*/
+            writer = NULL;
+        }
+        got       += ret;
+        remaining -= ret;
+    }
+    xEventGroupSetBits(ServerPortGroups, (0x1UL << 1));
+    if (remaining > 0 || imgDecoderRegistry.ImgDecoderRegistry_Find(image, ServerPort_MIN(got, (size_t) IMG_SNIFF_BYTES)) == NULL) {
+        if (writer != NULL) {
+            SDPort_->SDPort_WriterAbort(writer);
+        }
+        heap_caps_free(image);
+        if (remaining > 0) {
+            httpd_resp_send_408(req);
+        } else {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unsupported image format");
+        }
+        xEventGroupSetBits(ServerPortGroups, (0x1UL << 3));
+        return ESP_OK;
+    }
+    if (writer != NULL) {
+        if (SDPort_->SDPort_WriterCommit(writer) != ESP_OK) {
+            ESP_LOGE(TAG, "keep %s fail", path);
+        } else {
+            remove(IMAGE_UP_KEEP_DIR "/" SD_LIBRARY_INDEX_NAME);    /*可能覆盖了同名图片,下次打开图库时重建索引*/
+        }
+    }
+    ServerPortImage_t img = {image, got};
+    if (xQueueSend(ImageQueue, &img, 0) != pdTRUE) {       /*上一张还没显示完*/
+        heap_caps_free(image);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, "Busy", strlen("Busy"));
+        return ESP_OK;
+    }
+    httpd_resp_send(req, "Data verification successful", strlen("Data verification successful"));
+    xEventGroupSetBits(ServerPortGroups, GroupBit7);
+    return ESP_OK;
+}
+
+/*
+ * 接收已抖动好的 4bpp 面板帧(FrameUpHeader_t + raw 或 LZ4),边收边写进显示缓冲区
+ * 不写SD卡、不做颜色匹配;收完后由显示任务刷新
+ */
+esp_err_t receive_frame_handler(httpd_req_t *req) {
+    FrameUpHeader_t hdr;
+    size_t          remaining  = req->content_len;
+    size_t          got        = 0;
+    uint8_t         timeoutive = 0;
+    int             ret        = 0;
+    ESP_LOGW(TAG, "Receive frame:%s,byte:%d", req->uri, remaining);
+    if (remaining <= sizeof(hdr)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Frame header missing");
+        return ESP_OK;
+    }
+    while (got < sizeof(hdr)) {
+        ret = httpd_req_recv(req, (char *) &hdr + got, sizeof(hdr) - got);
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeoutive < 10) {
+                continue;
+            }
+            return ESP_FAIL;
+        }
+        got += ret;
+    }
+    remaining -= sizeof(hdr);
+    if (hdr.magic != FRAME_UP_MAGIC || hdr.format > FrameUpLz4 || hdr.rotation > 3 || hdr.rawLen != ePaperPort::Panel::FrameBytes ||
+        (hdr.format == FrameUpRaw && remaining != hdr.rawLen)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid frame header");
+        return ESP_OK;
+    }
+    if (pdTRUE != xSemaphoreTake(epaper_gui_semapHandle, pdMS_TO_TICKS(2000))) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, "Busy", strlen("Busy"));
+        return ESP_OK;
+    }
+    uint8_t *frame = ePaperDisplay.EPD_GetIMGBuffer();
+    char    *buf   = (hdr.format == FrameUpLz4) ? (char *) heap_caps_malloc(READ_LEN_MAX, MALLOC_CAP_SPIRAM) : NULL;
+    if (frame == NULL || (hdr.format == FrameUpLz4 && buf == NULL)) {
+        ePaperDisplay.EPD_FrameDiscard();
+        xSemaphoreGive(epaper_gui_semapHandle);
+        customfree(buf);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    FrameUnpacker unpack(frame, hdr.rawLen, (FrameUpFormat) hdr.format);
+    xEventGroupSetBits(ServerPortGroups, (0x1UL << 0));
+    timeoutive = 0;
+    while (remaining > 0) {
+        /*raw 直接收进显示缓冲区,LZ4 收进接收缓冲区后解压过去*/
+        if (hdr.format == FrameUpRaw) {
+            ret = httpd_req_recv(req, (char *) frame + unpack.FrameUnpacker_Out(), ServerPort_MIN(remaining, READ_LEN_MAX));
+        } else {
+            ret = httpd_req_recv(req, buf, ServerPort_MIN(remaining, READ_LEN_MAX));
+        }
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeoutive < 10) {
+                continue;
+            }
+            break;
+        }
+        bool ok = (hdr.format == FrameUpRaw) ? unpack.FrameUnpacker_Commit(ret)
+                                             : unpack.FrameUnpacker_Feed((const uint8_t *) buf, ret);
+        if (!ok) {
+            break;
+        }
+        remaining -= ret;
+    }
+    customfree(buf);
+    xEventGroupSetBits(ServerPortGroups, (0x1UL << 1));
+    if (remaining > 0 || !unpack.FrameUnpacker_Done()) {
+        ePaperDisplay.EPD_FrameDiscard();
+        xSemaphoreGive(epaper_gui_semapHandle);
+        if (ret <= 0) {
+            httpd_resp_send_408(req);
+        } else {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Corrupt frame data");
+        }
+        xEventGroupSetBits(ServerPortGroups, (0x1UL << 3));
+        return ESP_OK;
+    }
+    ePaperDisplay.Set_Rotation(hdr.rotation);
+    xSemaphoreGive(epaper_gui_semapHandle);
+    httpd_resp_send(req, "Data verification successful", strlen("Data verification successful"));
+    xEventGroupSetBits(ServerPortGroups, set_bit_button(8));
+    return ESP_OK;
+}
+
+bool ServerPort_TakeImage(ServerPortImage_t *img) {
+    return ImageQueue != NULL && xQueueReceive(ImageQueue, img, 0) == pdTRUE;
+}
+
 esp_err_t unknown_uri_handler(httpd_req_t *req) {
     const char *uri = req->uri; 
     httpd_method_t req_method = (httpd_method_t)req->method;
@@ -279,6 +485,13 @@ uint8_t ServerPort_NetworkSTAInit(wifi_credential_t creden) {
 void ServerPort_init(CustomSDPort *SDPort) {
     if(SDPort_ == NULL) {
         SDPort_ = SDPort;
+        AssetCache.WebAssetCache_Add("index.html", "text/html");
+        AssetCache.WebAssetCache_Add("bootstrap.min.css", "text/css");
+        AssetCache.WebAssetCache_Add("styles.min.css", "text/css");
+        AssetCache.WebAssetCache_Add("placeholder.svg", "image/svg+xml");
+        AssetCache.WebAssetCache_Add("bootstrap.min.js", "text/javascript");
+        AssetCache.WebAssetCache_Add("script.min.js", "text/javascript");
+        ImageQueue = xQueueCreate(1, sizeof(ServerPortImage_t));
     }
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
@@ -299,6 +512,18 @@ void ServerPort_init(CustomSDPort *SDPort) {
     uri_config.user_ctx    = NULL;
     httpd_register_uri_handler(server, &uri_config);
     
+    uri_config.uri         = "/imageUP";
+    uri_config.method      = HTTP_POST;
+    uri_config.handler     = receive_image_handler;
+    uri_config.user_ctx    = NULL;
+    httpd_register_uri_handler(server, &uri_config);
+
+    uri_config.uri         = "/frameUP";
+    uri_config.method      = HTTP_POST;
+    uri_config.handler     = receive_frame_handler;
+    uri_config.user_ctx    = NULL;
+    httpd_register_uri_handler(server, &uri_config);
+
     uri_config.uri         = "/*"; // Match all URLs that have not been handled by other handlers
     uri_config.method      = (httpd_method_t)(HTTP_GET | HTTP_POST);
     uri_config.handler     = unknown_uri_handler; // Callback for returning a 404 response
@@ -6,6 +6,12 @@
 
 extern EventGroupHandle_t ServerPortGroups;
 
+/*/imageUP 收到的压缩图片*/
+typedef struct {
+    uint8_t *data;      /*PSRAM,取走的一方用 heap_caps_free 释放*/
+    size_t   len;
+} ServerPortImage_t;
+
 
 /*Only one of them can be initialized.*/
 void ServerPort_NetworkAPInit(void);
@@ -13,6 +19,7 @@ uint8_t ServerPort_NetworkSTAInit(wifi_credential_t creden);
 
 void ServerPort_init(CustomSDPort *SDPort);
 void ServerPort_SetNetworkSleep(void);
+bool ServerPort_TakeImage(ServerPortImage_t *img);      /*GroupBit7 置位后由显示任务调用,没有图片时返回false*/
 
 uint8_t Get_NetworkMode(void);
 void Mdns_init_config(void);
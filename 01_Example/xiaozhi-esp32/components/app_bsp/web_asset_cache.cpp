@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "web_asset_cache.h"
+
+WebAssetCache::WebAssetCache(const char *dir) :
+dir_(dir) {
+    memset(assets_, 0, sizeof(assets_));
+}
+
+WebAssetCache::~WebAssetCache() {
+    WebAssetCache_Clear();
+}
+
+bool WebAssetCache::WebAssetCache_Add(const char *name, const char *type) {
+    if (count_ >= WEB_ASSET_MAX) {
+        ESP_LOGE(TAG, "too many assets, max:%d", WEB_ASSET_MAX);
+        return false;
+    }
+    WebAsset_t *asset = &assets_[count_++];
+    asset->name       = name;
+    asset->type       = type;
+    return true;
+}
+
+int WebAssetCache::WebAssetCache_Path(const WebAsset_t *asset, char *buf, size_t len) {
+    return snprintf(buf, len, "%s/%s", dir_, asset->name);
+}
+
+/*压缩版本不比原文件旧时优先使用;整个文件一次 fread 进 PSRAM*/
+bool WebAssetCache::WebAssetCache_Load(WebAsset_t *asset) {
+    char        path[128];
+    char        gz_path[132];
+    struct stat st;
+    struct stat gz_st;
+    WebAssetCache_Path(asset, path, sizeof(path));
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", path);
+    bool has_plain = stat(path, &st) == 0;
+    bool has_gz    = stat(gz_path, &gz_st) == 0;
+    if (has_gz && has_plain && gz_st.st_mtime < st.st_mtime) {
+        ESP_LOGW(TAG, "%s is older than %s, ignored", gz_path, asset->name);
+        has_gz = false;
+    }
+    if (!has_gz && !has_plain) {
+        return false;
+    }
+    const char *src  = has_gz ? gz_path : path;
+    size_t      size = has_gz ? gz_st.st_size : st.st_size;
+    if (size == 0 || size > WEB_ASSET_SIZE_MAX) {
+        ESP_LOGW(TAG, "%s size %u not cached", src, (unsigned) size);
+        return false;
+    }
+    uint8_t *data = (uint8_t *) heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    FILE    *fp   = fopen(src, "rb");
+    size_t   n    = 0;
+    if (data != NULL && fp != NULL) {
+        setvbuf(fp, NULL, _IONBF, 0);
+        n = fread(data, 1, size, fp);
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    if (n != size) {
+        ESP_LOGE(TAG, "read %s fail", src);
+        if (data != NULL) {
+            heap_caps_free(data);
+        }
+        return false;
+    }
+    uint32_t hash = 0x811C9DC5;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x01000193;
+    }
+    asset->data = data;
+    asset->len  = size;
+    asset->gzip = has_gz;
+    snprintf(asset->etag, sizeof(asset->etag), "\"%08lx-%lx\"", (unsigned long) hash, (unsigned long) size);
+    ESP_LOGI(TAG, "cached %s %u bytes%s", asset->name, (unsigned) size, has_gz ? " (gzip)" : "");
+    return true;
+}
+
+const WebAsset_t *WebAssetCache::WebAssetCache_Find(const char *uri) {
+    for (int i = 0; i < count_; i++) {
+        WebAsset_t *asset = &assets_[i];
+        if (strstr(uri, asset->name) == NULL) {
+            continue;
+        }
+        if (asset->data == NULL && !asset->failed) {
+            asset->failed = !WebAssetCache_Load(asset);
+        }
+        return asset->data ? asset : NULL;
+    }
+    return NULL;
+}
+
+void WebAssetCache::WebAssetCache_Clear() {
+    for (int i = 0; i < count_; i++) {
+        if (assets_[i].data != NULL) {
+            heap_caps_free(assets_[i].data);
+        }
+        assets_[i].data   = NULL;
+        assets_[i].len    = 0;
+        assets_[i].failed = false;
+    }
+}
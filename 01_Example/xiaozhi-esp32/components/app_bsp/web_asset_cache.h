@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WEB_ASSET_DIR       "/sdcard/03_sys_ap_html"
+#define WEB_ASSET_MAX       8
+#define WEB_ASSET_SIZE_MAX  (512 * 1024)       /*超过的文件不缓存,仍从SD卡流式发送*/
+#define WEB_ASSET_CACHE_CONTROL "public, max-age=86400"
+
+typedef struct {
+    const char *name;       /*文件名,也用于匹配 URI*/
+    const char *type;
+    uint8_t    *data;       /*PSRAM,NULL 表示还没读入*/
+    size_t      len;
+    bool        gzip;       /*data 为 name.gz 的内容*/
+    bool        failed;     /*读过但文件不存在或太大,之后不再重试*/
+    char        etag[24];   /*"内容哈希-长度",带引号*/
+} WebAsset_t;
+
+/*
+ * 网页静态文件缓存:每个文件第一次被请求时整个读入 PSRAM,之后直接从内存发送
+ * 目录中有 name.gz 且不比 name 旧时缓存压缩后的版本,以 Content-Encoding: gzip 发送
+ * 只在 httpd 任务中使用,内部不加锁
+ */
+class WebAssetCache
+{
+private:
+    const char *TAG = "WebAssetCache";
+    const char *dir_;
+    WebAsset_t  assets_[WEB_ASSET_MAX];
+    int         count_ = 0;
+
+    bool WebAssetCache_Load(WebAsset_t *asset);
+
+public:
+    WebAssetCache(const char *dir = WEB_ASSET_DIR);
+    ~WebAssetCache();
+
+    bool WebAssetCache_Add(const char *name, const char *type);
+    /*按文件名匹配 URI,返回已读入内存的文件;没有匹配或读取失败返回NULL*/
+    const WebAsset_t *WebAssetCache_Find(const char *uri);
+    int WebAssetCache_Path(const WebAsset_t *asset, char *buf, size_t len);     /*未压缩文件的完整路径*/
+    void WebAssetCache_Clear();                                                 /*网页文件更新后调用,下次请求重新读取*/
+};
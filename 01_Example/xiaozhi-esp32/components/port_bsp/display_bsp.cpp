@@ -1,32 +1,50 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <freertos/FreeRTOS.h>
 #include <esp_log.h>
 #include "display_bsp.h"
+#include "render_profiler.h"
+#include "render_config.h"
+#include "img_source.h"
+#ifdef ESP_PLATFORM
 #include "../pmicpower/power_bsp.h"
-
-ePaperPort::ePaperPort(ImgDecodeDither &dither,int mosi, int scl, int dc, int cs, int rst, int busy, uint16_t width, uint16_t height,uint16_t scale_MaxWidth, uint16_t scale_MaxHeight, spi_host_device_t spihost) : 
+#else
+#include "power_bsp.h"
+#endif
+
+/*面板六色的BGR值及对应的颜色编号*/
+static const uint8_t ePaperColorBGR[6][4] = {
+    {0x00, 0x00, 0x00, ColorBlack},
+    {0xFF, 0xFF, 0xFF, ColorWhite},
+    {0x00, 0xFF, 0xFF, ColorYellow},
+    {0x00, 0x00, 0xFF, ColorRed},
+    {0xFF, 0x00, 0x00, ColorBlue},
+    {0x00, 0xFF, 0x00, ColorGreen},
+};
+
+/*通道只有0x00/0xFF时按(b<<2)|(g<<1)|r索引,0xFF表示不在面板调色板内*/
+static const uint8_t SaturatedColorLUT[8] = {
+    ColorBlack,  ColorRed, ColorGreen, ColorYellow,
+    ColorBlue,   0xFF,     0xFF,       ColorWhite,
+};
+
+ePaperPort::ePaperPort(ImgDecodeDither &dither,RenderArena &arena,int mosi, int scl, int dc, int cs, int rst, int busy, uint16_t scale_MaxWidth, uint16_t scale_MaxHeight, spi_host_device_t spihost) : 
 dither_(dither),
+arena_(arena),
 mosi_(mosi), 
 scl_(scl), 
 dc_(dc), 
 cs_(cs), 
 rst_(rst), 
 busy_(busy), 
-width_(width), 
-height_(height),
 scale_MaxWidth_(scale_MaxWidth),
 scale_MaxHeight_(scale_MaxHeight) {
     esp_err_t        ret;
     spi_bus_config_t buscfg   = {};
     int              transfer = width_ * height_;
-    DisplayLen                = transfer / 2; //(1byte 2ipex)
-    DispBuffer                = (uint8_t *) heap_caps_malloc(DisplayLen, MALLOC_CAP_SPIRAM);
-    assert(DispBuffer);
-    RotationBuffer             = (uint8_t *) heap_caps_malloc(DisplayLen, MALLOC_CAP_SPIRAM);
-    assert(RotationBuffer);
-    BmpSrcBuffer              = (uint8_t *) heap_caps_malloc(width_ * height_ * 3, MALLOC_CAP_SPIRAM); 
-    assert(BmpSrcBuffer);
+    DisplayLen                = Panel::FrameBytes; //(1byte 2ipex)
+    /*显示缓冲区在第一次绘制时才从渲染内存池中分配,刷新完成后整体释放*/
     buscfg.miso_io_num                   = -1;
     buscfg.mosi_io_num                   = mosi;
     buscfg.sclk_io_num                   = scl;
@@ -176,12 +194,17 @@ void ePaperPort::Set_Rotation(uint8_t rot) {
     Rotation = rot;
 }
 
+uint8_t ePaperPort::Get_Rotation() {
+    return Rotation;
+}
+
 void ePaperPort::Set_Mirror(uint8_t mirr_x,uint8_t mirr_y) {
     mirrx = mirr_x;
     mirry = mirr_y;
 }
 
 void ePaperPort::EPD_Init() {
+    RENDER_PROFILE_SCOPE("epd_init", 0);
     EPD_PowerOnEDP();
     vTaskDelay(pdMS_TO_TICKS(1000));
 
@@ -239,10 +262,10 @@ void ePaperPort::EPD_Init() {
     EPD_SendData(0x00);
 
     EPD_SendCommand(0x61);
-    EPD_SendData(0x03);
-    EPD_SendData(0x20);
-    EPD_SendData(0x01);
-    EPD_SendData(0xE0);
+    EPD_SendData(width_ >> 8);
+    EPD_SendData(width_ & 0xFF);
+    EPD_SendData(height_ >> 8);
+    EPD_SendData(height_ & 0xFF);
 
     EPD_SendCommand(0x84);
     EPD_SendData(0x01);
@@ -252,10 +275,39 @@ void ePaperPort::EPD_Init() {
 
     EPD_SendCommand(0x04);
     EPD_LoopBusy();
-    EPD_DispClear(ColorWhite);
+    /*显示缓冲区获取时已填白,这里只清掉还没刷新的旧帧;初始化本身不占用渲染内存池*/
+    if (DispBuffer != NULL) {
+        EPD_DispClear(ColorWhite);
+    }
+}
+
+bool ePaperPort::EPD_FrameAcquire() {
+    if (DispBuffer != NULL) {
+        return true;
+    }
+    renderProfiler.RenderProfiler_BeginFrame();
+    DispBuffer     = (uint8_t *) arena_.RenderArena_Alloc(DisplayLen);
+    RotationBuffer = (uint8_t *) arena_.RenderArena_Alloc(DisplayLen);
+    if (DispBuffer == NULL || RotationBuffer == NULL) {
+        ESP_LOGE(TAG, "frame buffer alloc fail");
+        EPD_FrameRelease();
+        return false;
+    }
+    memset(DispBuffer, (ColorWhite << 4) | ColorWhite, DisplayLen);
+    return true;
+}
+
+void ePaperPort::EPD_FrameRelease() {
+    DispBuffer     = NULL;
+    RotationBuffer = NULL;
+    arena_.RenderArena_LogStats();
+    arena_.RenderArena_Release();
 }
 
 void ePaperPort::EPD_DispClear(uint8_t color) {
+    if (!EPD_FrameAcquire()) {
+        return;
+    }
     uint8_t *buffer = DispBuffer;
     for (int j = 0; j < DisplayLen; j++) {
         buffer[j] = (color << 4) | color;
@@ -263,10 +315,26 @@ void ePaperPort::EPD_DispClear(uint8_t color) {
 }
 
 void ePaperPort::EPD_Display() {
-    EPD_PixelRotate();
-    EPD_SendCommand(0x10);
-    EPD_Sendbuffera(RotationBuffer, DisplayLen);
-    EPD_TurnOnDisplay();
+    if (!EPD_FrameAcquire()) {
+        return;
+    }
+    {
+        RENDER_PROFILE_SCOPE("rotate", DisplayLen);
+        EPD_PixelRotate();
+    }
+    {
+        RENDER_PROFILE_SCOPE("spi_send", DisplayLen);
+        EPD_SendCommand(0x10);
+        EPD_Sendbuffera(RotationBuffer, DisplayLen);
+    }
+    EPD_FrameRelease();                 /*数据已送入面板,刷新等待期间不再占用PSRAM*/
+    {
+        RENDER_PROFILE_SCOPE("refresh", 0);
+        EPD_TurnOnDisplay();
+    }
+    if (renderProfiler.RenderProfiler_GetVerbose()) {
+        renderProfiler.RenderProfiler_DumpToSdcard();
+    }
 }
 
 void ePaperPort::EPD_SrcDisplayCopy(uint8_t *buffer,uint32_t len,uint32_t addlen) {
@@ -274,6 +342,9 @@ void ePaperPort::EPD_SrcDisplayCopy(uint8_t *buffer,uint32_t len,uint32_t addlen
         ESP_LOGE(TAG,"Data exceeds the buffer area.");
         return;
     }
+    if (!EPD_FrameAcquire()) {
+        return;
+    }
     for(uint32_t i = 0; i < len; i++) {
         RotationBuffer[addlen + i] = buffer[i];
     }
@@ -281,21 +352,25 @@ void ePaperPort::EPD_SrcDisplayCopy(uint8_t *buffer,uint32_t len,uint32_t addlen
 }
 
 uint8_t* ePaperPort::EPD_GetIMGBuffer() {
+    EPD_FrameAcquire();
     return DispBuffer;
 }
 
+void ePaperPort::EPD_FrameDiscard() {
+    if (DispBuffer != NULL) {
+        EPD_FrameRelease();
+    }
+}
+
 void ePaperPort::EPD_SetPixel(uint16_t x, uint16_t y, uint16_t color) {
-    if(x >= 800 || y >= 480) {
+    if(x >= width_ || y >= height_) {
         ESP_LOGE("Pixel","Beyond the limit: (%d,%d)",x,y);
         return;
     }
-    uint32_t index = (y << 8) + (y << 7) + (y << 4) + (x >> 1);
-    uint8_t px = DispBuffer[index];
-  
-    uint8_t xor_mask = (x & 1) ? 0xF0 : 0x0F;
-    uint8_t shift    = (x & 1) ? 0     : 4;
-
-    DispBuffer[index] = (px & xor_mask) | (color << shift);
+    if (DispBuffer == NULL && !EPD_FrameAcquire()) {
+        return;
+    }
+    EpdPanel::SetPixel<width_>(DispBuffer, x, y, color);
 }
 
 uint8_t* ePaperPort::EPD_ParseBMPImage(const char *path) {
@@ -320,6 +395,13 @@ uint8_t* ePaperPort::EPD_ParseBMPImage(const char *path) {
         fclose(fp);
         return NULL;
     }
+    RENDER_PROFILE_SCOPE("bmp_read", src_width * src_height * 3);
+    /*由调用者负责回退内存池*/
+    BmpSrcBuffer = (uint8_t *) arena_.RenderArena_Alloc(src_width * src_height * 3);
+    if (BmpSrcBuffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
 
     fseek(fp, bmpFileHeader.bOffset, SEEK_SET);
     int rowBytes = src_width * 3;
@@ -328,8 +410,8 @@ uint8_t* ePaperPort::EPD_ParseBMPImage(const char *path) {
         fread(rowPtr, 1, rowBytes, fp);
     }
     fclose(fp);
-    if(src_width == 480)
-    {Rotation = 3;src_width = 800;src_height = 480;}
+    if(src_width == height_)
+    {Rotation = 3;src_width = width_;src_height = height_;}
     else 
     {Rotation = 2;}
     return BmpSrcBuffer;
@@ -357,80 +439,141 @@ uint8_t ePaperPort::EPD_ColorToePaperColor(uint8_t b,uint8_t g,uint8_t r) {
     return ColorWhite;
 }
 
-uint8_t* ePaperPort::EPD_ParseBMPImageFromMemory(uint8_t *bmp_data, uint32_t data_len) {
-    if (!bmp_data || data_len < 54) {  // BMP header minimum size
-        ESP_LOGE(TAG, "Invalid BMP data");
-        return NULL;
+uint8_t ePaperPort::EPD_NearestePaperColor(uint8_t b,uint8_t g,uint8_t r) {
+    uint8_t  best      = ColorWhite;
+    uint32_t best_dist = 0xFFFFFFFF;
+    for (int i = 0; i < 6; i++) {
+        int      db   = (int) b - ePaperColorBGR[i][0];
+        int      dg   = (int) g - ePaperColorBGR[i][1];
+        int      dr   = (int) r - ePaperColorBGR[i][2];
+        uint32_t dist = db * db + dg * dg + dr * dr;
+        if (dist < best_dist) {
+            best_dist = dist;
+            best      = ePaperColorBGR[i][3];
+        }
     }
+    return best;
+}
 
-    // Parse BMP header from memory
-    BMPFILEHEADER *bmpFileHeader = (BMPFILEHEADER *)bmp_data;
-    BMPINFOHEADER *bmpInfoHeader = (BMPINFOHEADER *)(bmp_data + sizeof(BMPFILEHEADER));
+uint8_t ePaperPort::EPD_BGRToePaperColor(const uint8_t *bgr) {
+    uint8_t b = bgr[0], g = bgr[1], r = bgr[2];
+    /*抖动后的像素每个通道只会是0x00或0xFF,此时直接查表*/
+    if ((((b + 1) | (g + 1) | (r + 1)) & 0xFE) == 0) {
+        uint8_t color = SaturatedColorLUT[((b & 1) << 2) | ((g & 1) << 1) | (r & 1)];
+        if (color != 0xFF) {
+            return color;
+        }
+    }
+    return EPD_NearestePaperColor(b, g, r);
+}
 
-    ESP_LOGW(TAG, "(WIDTH:HEIGHT) = (%ld:%ld)", bmpInfoHeader->biWidth, bmpInfoHeader->biHeight);
-    src_width  = bmpInfoHeader->biWidth;
-    src_height = bmpInfoHeader->biHeight;
-    int readbyte = bmpInfoHeader->biBitCount;
-    
-    if (readbyte != 24) {
+void ePaperPort::EPD_PackBmpRow(const uint8_t *bgr, uint8_t *dst, int pixels) {
+    EpdPanel::PackRow<Panel>(bgr, dst, pixels, [this](const uint8_t *px) { return EPD_BGRToePaperColor(px); });
+}
+
+/*抖动输出的RGB888行,通道顺序与BMP相反*/
+void ePaperPort::EPD_PackRgbRow(const uint8_t *rgb, uint8_t *dst, int pixels) {
+    EpdPanel::PackRow<Panel>(rgb, dst, pixels, [this](const uint8_t *px) {
+        uint8_t bgr[3] = {px[2], px[1], px[0]};
+        return EPD_BGRToePaperColor(bgr);
+    });
+}
+
+/*
+ * 数据来自网络或SD卡,先完整校验文件头再占用显示缓冲区:
+ * 宽高按有符号数解释(负高度为自上而下),行宽和像素数据总长用64位计算后必须落在 data_len 之内
+ */
+bool ePaperPort::EPD_MemoryBmpShakingColor(uint8_t *bmp_data, uint32_t data_len, uint16_t x_start, uint16_t y_start) {
+    if (!bmp_data || data_len < sizeof(BMPFILEHEADER) + sizeof(BMPINFOHEADER)) {
+        ESP_LOGE(TAG, "Invalid BMP data");
+        EPD_FrameDiscard();
+        return false;
+    }
+    const BMPFILEHEADER *bmpFileHeader = (const BMPFILEHEADER *) bmp_data;
+    const BMPINFOHEADER *bmpInfoHeader = (const BMPINFOHEADER *) (bmp_data + sizeof(BMPFILEHEADER));
+    if (bmpInfoHeader->biBitCount != 24 || bmpInfoHeader->biCompression != 0) {
         ESP_LOGE(TAG, "Bmp image is not 24 bitmap!");
-        return NULL;
+        EPD_FrameDiscard();
+        return false;
     }
 
-    // Calculate pixel data offset and size
+    int32_t rawWidth  = (int32_t) bmpInfoHeader->biWidth;
+    int32_t rawHeight = (int32_t) bmpInfoHeader->biHeight;
+    if (rawWidth <= 0 || rawHeight == 0 || rawHeight == INT32_MIN) {
+        ESP_LOGE(TAG, "Invalid BMP size:(%ld:%ld)", (long) rawWidth, (long) rawHeight);
+        EPD_FrameDiscard();
+        return false;
+    }
+    bool     bottomUp        = rawHeight > 0;
+    int      width           = rawWidth;
+    int      height          = bottomUp ? rawHeight : -rawHeight;
+    uint64_t stride          = ((uint64_t) width * 3 + 3) & ~(uint64_t) 3;
     uint32_t pixelDataOffset = bmpFileHeader->bOffset;
-    if (pixelDataOffset >= data_len) {
-        ESP_LOGE(TAG, "Invalid BMP pixel data offset");
-        return NULL;
+    if (pixelDataOffset < sizeof(BMPFILEHEADER) + sizeof(BMPINFOHEADER) || pixelDataOffset >= data_len ||
+        stride * (uint64_t) height > data_len - pixelDataOffset) {
+        ESP_LOGE(TAG, "Invalid BMP pixel data:(%d:%d) offset:%lu len:%lu", width, height, (unsigned long) pixelDataOffset,
+                 (unsigned long) data_len);
+        EPD_FrameDiscard();
+        return false;
     }
-
-    // Copy pixel data to buffer
-    uint8_t *pixelData = bmp_data + pixelDataOffset;
-    int rowBytes = src_width * 3;
-    
-    for (int y = src_height - 1; y >= 0; y--) {
-        uint8_t *rowPtr = BmpSrcBuffer + y * rowBytes;
-        uint8_t *srcPtr = pixelData + (src_height - 1 - y) * rowBytes;
-        memcpy(rowPtr, srcPtr, rowBytes);
-    }
-    
-    if(src_width == 480) {
-        Rotation = 3;
-        src_width = 800;
-        src_height = 480;
+    uint32_t rowBytes = (uint32_t) stride;      /*已确认 rowBytes * height 不超过 data_len*/
+    ESP_LOGW(TAG, "(WIDTH:HEIGHT) = (%d:%d)", width, height);
+
+    /*竖屏图(宽度等于面板高度)按竖屏顺序写入DispBuffer,显示时再旋转*/
+    int canvasWidth = width_;
+    if (width == height_) {
+        Rotation    = 3;
+        canvasWidth = height_;
     } else {
         Rotation = 2;
     }
-    
-    return BmpSrcBuffer;
-}
-
-void ePaperPort::EPD_MemoryBmpShakingColor(uint8_t *bmp_data, uint32_t data_len, uint16_t x_start, uint16_t y_start) {
-    uint8_t r, g, b;
-    uint8_t *buffer = EPD_ParseBMPImageFromMemory(bmp_data, data_len);
-    if (NULL == buffer) {
-        return;
+    int canvasHeight = (width_ * height_) / canvasWidth;
+    int drawWidth    = width;
+    int drawHeight   = height;
+    if (x_start + drawWidth > canvasWidth) {
+        drawWidth = canvasWidth - x_start;
     }
-    
-    uint8_t* scapeBuffer = (uint8_t*)buffer;
-    for (int y = 0; y < src_height; y++) {
-        for (int x = 0; x < src_width; x++) {
-            int idx = (y * src_width + x) * 3;
-            b = scapeBuffer[idx + 0];
-            g = scapeBuffer[idx + 1];
-            r = scapeBuffer[idx + 2];
-            uint8_t color = EPD_ColorToePaperColor(b, g, r);
-            EPD_SetPixel(x_start + x, y_start + y, color);
+    if (y_start + drawHeight > canvasHeight) {
+        drawHeight = canvasHeight - y_start;
+    }
+    if (drawWidth <= 0 || drawHeight <= 0) {
+        ESP_LOGE(TAG, "Beyond the limit: (%d,%d)", x_start, y_start);
+        EPD_FrameDiscard();
+        return false;
+    }
+    if (!EPD_FrameAcquire()) {
+        return false;
+    }
+
+    RENDER_PROFILE_SCOPE("bmp_pack", rowBytes * drawHeight);
+    /*直接在接收缓冲区中逐行转换,不再拷贝到BmpSrcBuffer*/
+    const uint8_t *pixelData = bmp_data + pixelDataOffset;
+    int            dstStride = canvasWidth >> 1;
+    for (int y = 0; y < drawHeight; y++) {
+        const uint8_t *srcRow = pixelData + (bottomUp ? (height - 1 - y) : y) * rowBytes;
+        int            dy     = y_start + y;
+        if ((x_start & 1) == 0) {
+            EPD_PackBmpRow(srcRow, DispBuffer + dy * dstStride + (x_start >> 1), drawWidth);
+        } else {
+            for (int x = 0; x < drawWidth; x++) {
+                EPD_SetPixel4(DispBuffer, canvasWidth, x_start + x, dy, EPD_BGRToePaperColor(srcRow + x * 3));
+            }
         }
     }
+    return true;
 }
 
 void ePaperPort::EPD_SDcardBmpShakingColor(const char *path,uint16_t x_start, uint16_t y_start) {
     uint8_t r,g,b;
+    if (!EPD_FrameAcquire()) {
+        return;
+    }
+    RenderArenaScope scope(arena_);
     uint8_t *buffer = EPD_ParseBMPImage(path);
     if(NULL == buffer) {
         return;
     }
+    RENDER_PROFILE_SCOPE("bmp_pack", src_width * src_height * 3);
     uint8_t* scapeBuffer = (uint8_t*)buffer;
     for(int y = 0; y < src_height; y++) {
         for(int x = 0; x < src_width; x++) {
@@ -444,252 +587,148 @@ void ePaperPort::EPD_SDcardBmpShakingColor(const char *path,uint16_t x_start, ui
     }
 }
 
-void ePaperPort::EPD_SDcardIMGShakingColor(const char *path,uint16_t x_start, uint16_t y_start) {
-    uint8_t *decimgbuff = NULL;
-    int img_len = 0;
-    uint8_t *floyd_buffer = NULL;
-    int s_width;
-    int s_height;
-    if(strstr(path, ".jpg") || strstr(path, ".JPG")) {
-        if(dither_.ImgDecode_TFOneJPGPicture(path,&decimgbuff,&img_len,&s_width,&s_height) == ESP_OK) {
-            floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-            assert(floyd_buffer);
-            ESP_LOGW(TAG,"jpgdecode:(%d,%d)",s_width,s_height);
-            dither_.ImgDecode_DitherRgb888(decimgbuff, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-            dither_.ImgDecode_JPGBufferFree(decimgbuff); 
-            if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                free(floyd_buffer);
-                floyd_buffer = NULL;
-                EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-            } else {
-                ESP_LOGE(TAG, "bmp to sdcard fill");
-                free(floyd_buffer);
-                floyd_buffer = NULL;
-            }
-        } else {
-            ESP_LOGE(TAG, "jpg dec fill");
-            if (decimgbuff != NULL) {
-                dither_.ImgDecode_JPGBufferFree(decimgbuff);
-            }
+/*
+ * 所有格式共用的渲染流程:注册表按文件内容选择解码器,先读文件头得到尺寸,按 render 配置(stretch/fit/fill)算出裁剪区域
+ * 解码器逐行输出裁剪区域,直接(或经过缩放)写入画布,原地抖动后逐行打包进显示缓冲区,不再经过SD卡上的中间BMP
+ * 默认解码和抖动分别在两个核上按行带流水进行(见 ImgDecode_SourceDitherPipelined),auto_levels 需要整图直方图时走顺序流程
+ * scale 为false时只接受 480x800/800x480 的图片
+ */
+bool ePaperPort::EPD_RenderImage(const char *path, bool scale) {
+    if (!EPD_FrameAcquire()) {
+        return false;
+    }
+    bool ok = false;
+    {
+        RenderArenaScope scope(arena_);
+        ImgRowSource    *src = imgDecoderRegistry.ImgDecoderRegistry_Open(path, &arena_);
+        if (src != NULL) {
+            ok = EPD_RenderSource(src, path, scale);
         }
-    } else if(strstr(path, ".png") || strstr(path, ".PNG")) {
-        if(dither_.ImgDecode_TFOnePNGPicture(path,&decimgbuff,&s_width,&s_height) == ESP_OK) {
-            floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-            assert(floyd_buffer);
-            ESP_LOGW(TAG,"pngdecode:(%d,%d)",s_width,s_height);
-            dither_.ImgDecode_DitherRgb888(decimgbuff, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-            dither_.ImgDecode_PNGBufferFree(decimgbuff); 
-            if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                free(floyd_buffer);
-                floyd_buffer = NULL;
-                EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-            } else {
-                ESP_LOGE(TAG, "bmp to sdcard fill");
-                free(floyd_buffer);
-                floyd_buffer = NULL;
-            }
-        } else {
-            ESP_LOGE(TAG, "PNG dec fill");
-            if (decimgbuff != NULL) {
-                dither_.ImgDecode_PNGBufferFree(decimgbuff);
+    }
+    /*解码失败时不能把白帧或画了一半的帧刷到屏幕上或存进帧缓存*/
+    if (!ok) {
+        EPD_FrameDiscard();
+    }
+    return ok;
+}
+
+typedef struct {
+    ePaperPort *self;
+    int         width;
+    int         stride;
+} EpdPackTarget_t;
+
+/*name 用于查找 render 配置中的单张图片设置;src 在函数内释放*/
+bool ePaperPort::EPD_RenderSource(ImgRowSource *src, const char *name, bool scale) {
+    int s_width  = src->ImgSource_Width();
+    int s_height = src->ImgSource_Height();
+    int canvas_w = (s_width > s_height) ? width_ : height_;
+    int canvas_h = (s_width > s_height) ? height_ : width_;
+    ImgRenderOptions_t opts;
+    ImgRect_t          crop;
+    ImgRect_t          dst;
+    uint8_t           *canvas    = NULL;
+    int                dstStride = 0;
+    bool               ok        = false;
+    renderConfig.RenderConfig_Get(name, &opts);
+    if (!scale && (s_width != canvas_w || s_height != canvas_h)) {
+        ESP_LOGE(TAG, "image must be %dx%d:(%d,%d)", canvas_w, canvas_h, s_width, s_height);
+        goto clean_up;
+    }
+    RenderConfig::RenderConfig_Layout(s_width, s_height, canvas_w, canvas_h, &opts, &crop, &dst);
+    ESP_LOGW(TAG,"decode:(%d,%d) mode:%d crop:(%d,%d %dx%d) dst:(%d,%d %dx%d)",s_width,s_height,opts.mode,
+             crop.x,crop.y,crop.w,crop.h,dst.x,dst.y,dst.w,dst.h);
+    if((crop.w > scale_MaxWidth_) || (crop.h > scale_MaxHeight_)) {
+        goto clean_up;
+    }
+    dither_.ImgDecode_SetTone(&opts.tone);
+    dither_.ImgDecode_SetPalette(renderConfig.RenderConfig_GetPalette());
+    if (dither_.ImgDecode_SourceBegin(src, &crop) != ESP_OK) {
+        ESP_LOGE(TAG, "img dec fill");
+        goto clean_up;
+    }
+    /*竖屏图按竖屏顺序写入DispBuffer,显示时再旋转*/
+    Rotation  = (canvas_w == height_) ? 3 : 2;
+    dstStride = canvas_w >> 1;
+    {
+        /*优先走双核流水线:抖动后的行直接打包进DispBuffer,不需要整帧画布*/
+        EpdPackTarget_t target = {this, canvas_w, dstStride};
+        esp_err_t       ret    = dither_.ImgDecode_SourceDitherPipelined(src, canvas_w, canvas_h, &dst, opts.background,
+            [](void *ctx, int y, const uint8_t *rgb) {
+                EpdPackTarget_t *t = (EpdPackTarget_t *) ctx;
+                t->self->EPD_PackRgbRow(rgb, t->self->DispBuffer + y * t->stride, t->width);
+            }, &target);
+        if (ret != ESP_ERR_NOT_SUPPORTED) {
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "img dec fill");
             }
+            ok = (ret == ESP_OK);
+            goto clean_up;
         }
-    } else if(strstr(path, ".bmp") || strstr(path, ".BMP")) {
-        if(dither_.ImgDecodebmp_TFOneBMPPicture(path,&decimgbuff,&s_width,&s_height) == ESP_OK) {
-            floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-            assert(floyd_buffer);
-            ESP_LOGW(TAG,"bmpdecode:(%d,%d)",s_width,s_height);
-            dither_.ImgDecode_DitherRgb888(decimgbuff, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-            dither_.ImgDecode_BMPBufferFree(decimgbuff); 
-            if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                free(floyd_buffer);
-                floyd_buffer = NULL;
-                EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-            } else {
-                ESP_LOGE(TAG, "bmp to sdcard fill");
-                free(floyd_buffer);
-                floyd_buffer = NULL;
-            }
-        } else {
-            ESP_LOGE(TAG, "BMP dec fill");
-            if (decimgbuff != NULL) {
-                dither_.ImgDecode_BMPBufferFree(decimgbuff);
-            }
+    }
+    /*顺序流程:整帧解码到画布,原地抖动后逐行打包*/
+    canvas = (uint8_t *) arena_.RenderArena_Alloc(canvas_w * canvas_h * 3);
+    if (canvas == NULL) {
+        ESP_LOGE(TAG, "canvas alloc fill");
+        goto clean_up;
+    }
+    if (dst.w != canvas_w || dst.h != canvas_h) {   /*fit 模式留边*/
+        for (int i = 0; i < canvas_w * canvas_h; i++) {
+            memcpy(canvas + i * 3, opts.background, 3);
         }
     }
+    if (dither_.ImgDecode_SourceToRgb888(src, canvas + (dst.y * canvas_w + dst.x) * 3, dst.w, dst.h, canvas_w * 3) != ESP_OK) {
+        ESP_LOGE(TAG, "img dec fill");
+        goto clean_up;
+    }
+    delete src;
+    src = NULL;
+    dither_.ImgDecode_DitherRgb888(canvas, canvas, canvas_w, canvas_h);     //The RGB888 data has undergone the jittering algorithm.
+    {
+        RENDER_PROFILE_SCOPE("pack", canvas_w * canvas_h * 3);
+        for (int y = 0; y < canvas_h; y++) {
+            EPD_PackRgbRow(canvas + y * canvas_w * 3, DispBuffer + y * dstStride, canvas_w);
+        }
+    }
+    ok = true;
+
+clean_up:
+    if (src != NULL) {
+        delete src;
+    }
+    return ok;
 }
 
-void ePaperPort::EPD_SDcardScaleIMGShakingColor(const char *path,uint16_t x_start, uint16_t y_start) {
-    uint8_t *decimgbuff = NULL;
-    int img_len = 0;
-    uint8_t *scale_buffer = NULL;
-    uint8_t *floyd_buffer = NULL;
-    int s_width;
-    int s_height;
-    if(strstr(path, ".jpg") || strstr(path, ".JPG")) {
-        if(dither_.ImgDecode_TFOneJPGPicture(path,&decimgbuff,&img_len,&s_width,&s_height) == ESP_OK) {
-            ESP_LOGW(TAG,"jpgdecode:(%d,%d)",s_width,s_height);
-            if((s_width > scale_MaxWidth_) || (s_height > scale_MaxHeight_)) {
-                dither_.ImgDecode_JPGBufferFree(decimgbuff); 
-                return;
-            }
-            if((480 == s_width && 800 == s_height) || (800 == s_width && 480 == s_height)) {
-                floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(floyd_buffer);
-                dither_.ImgDecode_DitherRgb888(decimgbuff, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-                dither_.ImgDecode_JPGBufferFree(decimgbuff); 
-                if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                    EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-                } else {
-                    ESP_LOGE(TAG, "bmp to sdcard fill");
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                }
-            } else { /*拉伸缩放*/
-                scale_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(scale_buffer);
-                if(s_width > s_height) {
-                    dither_.ImgDecode_ScaleRgb888Nearest(decimgbuff,s_width,s_height,scale_buffer,width_,height_);
-                    s_width = width_;
-                    s_height = height_;
-                } else {
-                    dither_.ImgDecode_ScaleRgb888Nearest(decimgbuff,s_width,s_height,scale_buffer,height_,width_);
-                    s_width = height_;
-                    s_height = width_;
-                }
-                dither_.ImgDecode_JPGBufferFree(decimgbuff);
-                floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(floyd_buffer);
-                dither_.ImgDecode_DitherRgb888(scale_buffer, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-                free(scale_buffer);
-                scale_buffer = NULL;
-                if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                    EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-                } else {
-                    ESP_LOGE(TAG, "bmp to sdcard fill");
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                }
-            }
-        } else { /*解码失败*/
-            ESP_LOGE(TAG, "jpg dec fill");
-            if (decimgbuff != NULL) {
-                dither_.ImgDecode_JPGBufferFree(decimgbuff);
-            }
-        }
-    } else if(strstr(path, ".png") || strstr(path, ".PNG")) {
-        if(dither_.ImgDecode_TFOnePNGPicture(path,&decimgbuff,&s_width,&s_height) == ESP_OK) {
-            if((s_width > scale_MaxWidth_) || (s_height > scale_MaxHeight_)) {
-                dither_.ImgDecode_PNGBufferFree(decimgbuff);
-                return;
-            }
-            if((480 == s_width && 800 == s_height) || (800 == s_width && 480 == s_height)) { /*正常抖动显示*/
-                floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(floyd_buffer);
-                dither_.ImgDecode_DitherRgb888(decimgbuff, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-                dither_.ImgDecode_JPGBufferFree(decimgbuff); 
-                if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                    EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-                } else {
-                    ESP_LOGE(TAG, "bmp to sdcard fill");
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                }
-            } else {   /*拉伸缩放*/
-                scale_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(scale_buffer);
-                if(s_width > s_height) {
-                    dither_.ImgDecode_ScaleRgb888Nearest(decimgbuff,s_width,s_height,scale_buffer,width_,height_);
-                    s_width = width_;
-                    s_height = height_;
-                } else {
-                    dither_.ImgDecode_ScaleRgb888Nearest(decimgbuff,s_width,s_height,scale_buffer,height_,width_);
-                    s_width = height_;
-                    s_height = width_;
-                }
-                dither_.ImgDecode_PNGBufferFree(decimgbuff);
-                floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(floyd_buffer);
-                dither_.ImgDecode_DitherRgb888(scale_buffer, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-                free(scale_buffer);
-                scale_buffer = NULL;
-                if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                    EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-                } else {
-                    ESP_LOGE(TAG, "bmp to sdcard fill");
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                }
-            }
-        } else {      /*解码失败*/
-            ESP_LOGE(TAG, "PNG dec fill");
-            if (decimgbuff != NULL) {
-                dither_.ImgDecode_PNGBufferFree(decimgbuff);
-            }
-        }
-    } else if(strstr(path, ".bmp") || strstr(path, ".BMP")) {
-        if(dither_.ImgDecodebmp_TFOneBMPPicture(path,&decimgbuff,&s_width,&s_height) == ESP_OK) {
-            if((s_width > scale_MaxWidth_) || (s_height > scale_MaxHeight_)) {
-                dither_.ImgDecode_BMPBufferFree(decimgbuff);
-                return;
-            }
-            if((480 == s_width && 800 == s_height) || (800 == s_width && 480 == s_height)) { /*正常抖动显示*/
-                floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(floyd_buffer);
-                dither_.ImgDecode_DitherRgb888(decimgbuff, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-                dither_.ImgDecode_JPGBufferFree(decimgbuff); 
-                if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                    EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-                } else {
-                    ESP_LOGE(TAG, "bmp to sdcard fill");
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                }
-            } else {   /*拉伸缩放*/
-                scale_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(scale_buffer);
-                if(s_width > s_height) {
-                    dither_.ImgDecode_ScaleRgb888Nearest(decimgbuff,s_width,s_height,scale_buffer,width_,height_);
-                    s_width = width_;
-                    s_height = height_;
-                } else {
-                    dither_.ImgDecode_ScaleRgb888Nearest(decimgbuff,s_width,s_height,scale_buffer,height_,width_);
-                    s_width = height_;
-                    s_height = width_;
-                }
-                dither_.ImgDecode_BMPBufferFree(decimgbuff);
-                floyd_buffer = (uint8_t *) malloc(width_ * height_ * 3);       // Store the data after applying the RGB888 jitter algorithm
-                assert(floyd_buffer);
-                dither_.ImgDecode_DitherRgb888(scale_buffer, floyd_buffer,s_width,s_height);     //The RGB888 data has undergone the jittering algorithm.
-                free(scale_buffer);
-                scale_buffer = NULL;
-                if (dither_.ImgDecode_EncodingBmpToSdcard(img_to_bmpName, floyd_buffer, s_width,s_height) == ESP_OK) {
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                    EPD_SDcardBmpShakingColor(img_to_bmpName,0,0);
-                } else {
-                    ESP_LOGE(TAG, "bmp to sdcard fill");
-                    free(floyd_buffer);
-                    floyd_buffer = NULL;
-                }
-            }
+bool ePaperPort::EPD_SDcardIMGShakingColor(const char *path, [[maybe_unused]] uint16_t x_start, [[maybe_unused]] uint16_t y_start) {
+    return EPD_RenderImage(path, false);
+}
+
+bool ePaperPort::EPD_SDcardScaleIMGShakingColor(const char *path, [[maybe_unused]] uint16_t x_start, [[maybe_unused]] uint16_t y_start) {
+    return EPD_RenderImage(path, true);
+}
+
+bool ePaperPort::EPD_MemoryIMGShakingColor(uint8_t *data, uint32_t data_len, const char *name) {
+    if (!EPD_FrameAcquire()) {
+        return false;
+    }
+    bool  ok = false;
+    FILE *fp = fmemopen(data, data_len, "rb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "fmemopen fill");
+    } else {
+        RenderArenaScope scope(arena_);
+        ImgRowSource    *src = imgDecoderRegistry.ImgDecoderRegistry_OpenFile(fp, &arena_);
+        if (src == NULL) {
+            ESP_LOGE(TAG, "unsupported image data:%s", name);
         } else {
-            ESP_LOGE(TAG, "BMP dec fill");
-            if (decimgbuff != NULL) {
-                dither_.ImgDecode_BMPBufferFree(decimgbuff);
-            }
+            ok = EPD_RenderSource(src, name, true);
         }
     }
+    /*解码失败时不能把白帧或画了一半的帧刷到屏幕上*/
+    if (!ok) {
+        EPD_FrameDiscard();
+    }
+    return ok;
 }
 
 void ePaperPort::EPD_DrawStringCN(uint16_t Xstart, uint16_t Ystart, const char * pString, cFONT* font,uint16_t Color_Foreground, uint16_t Color_Background) {
@@ -785,71 +824,16 @@ void ePaperPort::EPD_SetPixel4(uint8_t* buf, int width, int x, int y, uint8_t px
 
 void ePaperPort::EPD_PixelRotate() {
     if(Rotation == 3) {
-        EPD_Rotate90CCW_Fast(DispBuffer,RotationBuffer,480,800);
+        EpdPanel::Rotate90CCW<Panel>(DispBuffer,RotationBuffer);
     } else if(Rotation == 1) {
-        EPD_Rotate90CW_Fast(DispBuffer,RotationBuffer,480,800);
+        EpdPanel::Rotate90CW<Panel>(DispBuffer,RotationBuffer);
     } else if(Rotation == 2) {
-        EPD_Rotate180_Fast(DispBuffer,RotationBuffer,800,480);
+        EpdPanel::Rotate180<Panel>(DispBuffer,RotationBuffer);
     } else {
         memcpy(RotationBuffer, DispBuffer, DisplayLen);
     }
 }
 
-void ePaperPort::EPD_Rotate180_Fast(const uint8_t* src, uint8_t* dst, int width, int height)
-{
-    const int bytesPerRow = width >> 1;
-    const int totalRows   = height;    
-    for (int y = 0; y < totalRows; y++) {
-        const uint8_t* srcRow = src + y * bytesPerRow;
-        uint8_t* dstRow = dst + (totalRows - 1 - y) * bytesPerRow;
-        for (int x = 0; x < bytesPerRow; x++) {
-            uint8_t b = srcRow[x];
-            b = (b << 4) | (b >> 4);
-            dstRow[bytesPerRow - 1 - x] = b;
-        }
-    }
-}
-
-void ePaperPort::EPD_Rotate90CCW_Fast(const uint8_t* src, uint8_t* dst, int width, int height)
-{
-    const int srcBytesPerRow = width >> 1;
-    for (int y = 0; y < height; y++) {
-        const uint8_t* srcRow = src + y * srcBytesPerRow;
-        for (int x = 0; x < width; x += 2) {
-
-            uint8_t b = srcRow[x >> 1];
-            uint8_t p0 = b >> 4;
-            uint8_t p1 = b & 0x0F;
-            int ny0 = width - 1 - x;
-            int nx0 = y;
-            int ny1 = width - 2 - x;
-            int nx1 = y;
-            EPD_SetPixel4(dst, height, nx0, ny0, p0);
-            EPD_SetPixel4(dst, height, nx1, ny1, p1);
-        }
-    }
-}
-
-void ePaperPort::EPD_Rotate90CW_Fast(const uint8_t* src, uint8_t* dst, int width, int height)
-{
-    const int srcBytesPerRow = width >> 1;
-    for (int y = 0; y < height; y++) {
-        const uint8_t* srcRow = src + y * srcBytesPerRow;
-        for (int x = 0; x < width; x += 2) {
-
-            uint8_t b = srcRow[x >> 1];
-            uint8_t p0 = b >> 4;  
-            uint8_t p1 = b & 0x0F;
-            int ny0 = x;
-            int nx0 = height - 1 - y;
-            int ny1 = x + 1;
-            int nx1 = height - 1 - y;
-            EPD_SetPixel4(dst, height, nx0, ny0, p0);
-            EPD_SetPixel4(dst, height, nx1, ny1, p1);
-        }
-    }
-}
-
 void ePaperPort::EPD_PowerOffEDP()
 {
     ESP_LOGI(TAG, "Set EPD PowerOff");
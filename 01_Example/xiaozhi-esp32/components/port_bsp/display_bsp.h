@@ -3,6 +3,8 @@
 #include <driver/gpio.h>
 #include <driver/spi_master.h>
 #include "fonts.h"
+#include "epd_panel_traits.h"
+#include "render_arena.h"
 #include "imgdecode_app.h"
 
 enum ColorSelection {
@@ -40,21 +42,26 @@ typedef struct BMP_INFO {
 } __attribute__((packed)) BMPINFOHEADER;
 
 class ePaperPort {
+  public:
+    typedef EpdActivePanel Panel;
+    /*渲染内存池大小:显示/旋转缓冲区 + 3帧RGB888(缩放、抖动输出、抖动工作区)*/
+    static constexpr size_t ArenaSize = Panel::FrameBytes * 2 + (size_t) Panel::Width * Panel::Height * 3 * 3 + 1024;
+
   private:
     spi_device_handle_t spi;
     uint32_t            i2c_data_pdMS_TICKS = 0;
     uint32_t            i2c_done_pdMS_TICKS = 0;
     const char         *TAG                 = "Display";
-    const char         *img_to_bmpName      = "/sdcard/06_user_foundation_img/sys_decode.bmp";
     ImgDecodeDither &dither_;
+    RenderArena     &arena_;
     int                 mosi_;
     int                 scl_;
     int                 dc_;
     int                 cs_;
     int                 rst_;
     int                 busy_;
-    uint16_t            width_;
-    uint16_t            height_;
+    static constexpr uint16_t width_  = Panel::Width;
+    static constexpr uint16_t height_ = Panel::Height;
     uint16_t            scale_MaxWidth_;
     uint16_t            scale_MaxHeight_;
     uint8_t            *DispBuffer = NULL;
@@ -80,18 +87,22 @@ class ePaperPort {
     void    EPD_TurnOnDisplay(void);
     uint8_t EPD_ColorToePaperColor(uint8_t b,uint8_t g,uint8_t r);
     uint8_t* EPD_ParseBMPImage(const char *path);
-    uint8_t* EPD_ParseBMPImageFromMemory(uint8_t *bmp_data, uint32_t data_len);
+    uint8_t EPD_NearestePaperColor(uint8_t b,uint8_t g,uint8_t r);
+    uint8_t EPD_BGRToePaperColor(const uint8_t *bgr);
+    void    EPD_PackBmpRow(const uint8_t *bgr, uint8_t *dst, int pixels);
+    void    EPD_PackRgbRow(const uint8_t *rgb, uint8_t *dst, int pixels);
+    bool    EPD_RenderImage(const char *path, bool scale);
+    bool    EPD_RenderSource(ImgRowSource *src, const char *name, bool scale);
     uint8_t EPD_GetPixel4(const uint8_t* buf, int width, int x, int y);
     void    EPD_SetPixel4(uint8_t* buf, int width, int x, int y, uint8_t px);
-    void EPD_Rotate180_Fast(const uint8_t* src, uint8_t* dst, int width, int height);
-    void EPD_Rotate90CCW_Fast(const uint8_t* src, uint8_t* dst, int width, int height);
-    void EPD_Rotate90CW_Fast(const uint8_t* src, uint8_t* dst, int width, int height);
     void EPD_PixelRotate();
+    bool EPD_FrameAcquire();
+    void EPD_FrameRelease();
     void EPD_PowerOffEDP();
     void EPD_PowerOnEDP();
 
   public:
-    ePaperPort(ImgDecodeDither &dither,int mosi, int scl, int dc, int cs, int rst, int busy, uint16_t width, uint16_t height, uint16_t scale_MaxWidth, uint16_t scale_MaxHeight, spi_host_device_t spihost = SPI3_HOST);
+    ePaperPort(ImgDecodeDither &dither,RenderArena &arena,int mosi, int scl, int dc, int cs, int rst, int busy, uint16_t scale_MaxWidth, uint16_t scale_MaxHeight, spi_host_device_t spihost = SPI3_HOST);
     ~ePaperPort();
 
     void EPD_Init();
@@ -99,12 +110,16 @@ class ePaperPort {
     void EPD_Display();
     void EPD_SrcDisplayCopy(uint8_t *buffer,uint32_t len,uint32_t addlen);
     void Set_Rotation(uint8_t rot); // 0:no 1:90 2:180 3:270
+    uint8_t Get_Rotation();
     void Set_Mirror(uint8_t mirr_x,uint8_t mirr_y);
     uint8_t* EPD_GetIMGBuffer();
+    void EPD_FrameDiscard();        /*放弃 EPD_GetIMGBuffer 后写了一半的帧,不刷新*/
     void EPD_SetPixel(uint16_t x, uint16_t y, uint16_t color);
     void EPD_SDcardBmpShakingColor(const char *path,uint16_t x_start, uint16_t y_start);        /*只能用于经过抖动之后的 480x800/800x480 BMP图片显示*/
-    void EPD_MemoryBmpShakingColor(uint8_t *bmp_data, uint32_t data_len, uint16_t x_start, uint16_t y_start);  /*从内存缓冲区显示BMP图片*/
-    void EPD_SDcardIMGShakingColor(const char *path,uint16_t x_start, uint16_t y_start);        /*可以显示jpg,bmp,png格式图片 480x800/800x480*/
-    void EPD_SDcardScaleIMGShakingColor(const char *path,uint16_t x_start, uint16_t y_start);   /*可以显示jpg,bmp,png格式图片,带自动拉伸缩放的*/
+    bool EPD_MemoryBmpShakingColor(uint8_t *bmp_data, uint32_t data_len, uint16_t x_start, uint16_t y_start);  /*从内存缓冲区显示BMP图片;文件头无效时不占用显示缓冲区,返回false,不要再刷新*/
+    /*x_start/y_start 已不再生效:图片总是按 config.txt 的 render 配置布局到整屏,保留参数只为兼容旧的调用*/
+    bool EPD_SDcardIMGShakingColor(const char *path,uint16_t x_start, uint16_t y_start);        /*可以显示jpg,bmp,png格式图片 480x800/800x480;失败时放弃整帧,不要再刷新*/
+    bool EPD_SDcardScaleIMGShakingColor(const char *path,uint16_t x_start, uint16_t y_start);   /*可以显示jpg,bmp,png格式图片,带自动拉伸缩放的;失败时同上*/
+    bool EPD_MemoryIMGShakingColor(uint8_t *data, uint32_t data_len, const char *name);     /*从内存缓冲区显示未抖动的压缩图片(jpg/png),按格式自动识别;失败时放弃整帧,不要再刷新*/
 	void EPD_DrawStringCN(uint16_t Xstart, uint16_t Ystart, const char * pString, cFONT* font,uint16_t Color_Foreground, uint16_t Color_Background);
 };
\ No newline at end of file
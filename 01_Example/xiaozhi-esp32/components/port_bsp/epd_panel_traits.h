@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * 墨水屏面板几何参数(编译期常量)
+ * Width/Height 为面板原生(横屏)分辨率,NativeRotation 为面板扫描方向相对原生坐标的旋转(0:0 1:90 2:180 3:270)
+ * 更换其他尺寸的微雪面板时只需新增一个 traits 类型并修改 EpdActivePanel
+ */
+template <uint16_t W, uint16_t H, uint8_t BPP, uint8_t NativeRot>
+struct EpdPanelTraits {
+    static_assert(BPP == 4, "only 4bpp (two pixels per byte) panels are supported");
+    static_assert((W % 2) == 0 && (H % 2) == 0, "panel size must be even");
+
+    static constexpr uint16_t Width          = W;
+    static constexpr uint16_t Height         = H;
+    static constexpr uint8_t  BitsPerPixel   = BPP;
+    static constexpr uint8_t  NativeRotation = NativeRot;
+    static constexpr uint8_t  PixelsPerByte  = 8 / BPP;
+    static constexpr uint32_t BytesPerRow    = (uint32_t) W * BPP / 8;   /*横屏一行字节数*/
+    static constexpr uint32_t PortraitBytesPerRow = (uint32_t) H * BPP / 8;   /*竖屏一行字节数*/
+    static constexpr uint32_t FrameBytes     = BytesPerRow * H;
+};
+
+/*7.3inch Spectra 6 (E6) 800x480*/
+typedef EpdPanelTraits<800, 480, 4, 0> EpdPanel_7in3e;
+
+typedef EpdPanel_7in3e EpdActivePanel;
+
+namespace EpdPanel {
+
+/*Stride 为一行像素数,编译期常量*/
+template <uint32_t Stride>
+static inline uint8_t GetPixel(const uint8_t *buf, int x, int y) {
+    uint8_t byte = buf[y * (Stride >> 1) + (x >> 1)];
+    return (x & 1) ? (byte & 0x0F) : (byte >> 4);
+}
+
+template <uint32_t Stride>
+static inline void SetPixel(uint8_t *buf, int x, int y, uint8_t px) {
+    uint8_t *p = &buf[y * (Stride >> 1) + (x >> 1)];
+    if (x & 1)
+        *p = (*p & 0xF0) | (px & 0x0F);
+    else
+        *p = (*p & 0x0F) | (px << 4);
+}
+
+/*
+ * 两个像素打包成一个字节,Map(const uint8_t *bgr) 返回面板颜色编号
+ * 主循环每次处理4个像素(2字节)
+ */
+template <typename Panel, typename Map>
+static inline void PackRow(const uint8_t *bgr, uint8_t *dst, int pixels, Map map) {
+    int pairs = pixels >> 1;
+    int i     = 0;
+    for (; i + 2 <= pairs; i += 2) {
+        dst[i]     = (map(bgr) << 4) | map(bgr + 3);
+        dst[i + 1] = (map(bgr + 6) << 4) | map(bgr + 9);
+        bgr += 12;
+    }
+    for (; i < pairs; i++) {
+        dst[i] = (map(bgr) << 4) | map(bgr + 3);
+        bgr += 6;
+    }
+    if (pixels & 1) {
+        dst[pairs] = (dst[pairs] & 0x0F) | (map(bgr) << 4);
+    }
+}
+
+/*横屏 Width x Height 旋转180度*/
+template <typename Panel>
+static void Rotate180(const uint8_t *src, uint8_t *dst) {
+    constexpr uint32_t bytesPerRow = Panel::BytesPerRow;
+    for (int y = 0; y < Panel::Height; y++) {
+        const uint8_t *srcRow = src + y * bytesPerRow;
+        uint8_t       *dstRow = dst + (Panel::Height - 1 - y) * bytesPerRow + bytesPerRow - 1;
+        for (uint32_t x = 0; x < bytesPerRow; x++) {
+            uint8_t b   = srcRow[x];
+            *(dstRow - x) = (b << 4) | (b >> 4);
+        }
+    }
+}
+
+/*
+ * 竖屏 Height x Width 逆时针旋转90度得到横屏 Width x Height
+ * dst(nx,ny) = src(Height-1-ny, nx),按目标行顺序写,每次合成一个完整字节
+ */
+template <typename Panel>
+static void Rotate90CCW(const uint8_t *src, uint8_t *dst) {
+    constexpr uint32_t srcBytesPerRow = Panel::PortraitBytesPerRow;
+    constexpr uint32_t dstBytesPerRow = Panel::BytesPerRow;
+    for (int ny = 0; ny < Panel::Height; ny++) {
+        const int      sx     = Panel::Height - 1 - ny;
+        const uint8_t  shift  = (sx & 1) ? 0 : 4;
+        const uint8_t *srcCol = src + (sx >> 1);
+        uint8_t       *dstRow = dst + ny * dstBytesPerRow;
+        for (uint32_t k = 0; k < dstBytesPerRow; k++) {
+            uint8_t p0 = (srcCol[0] >> shift) & 0x0F;
+            uint8_t p1 = (srcCol[srcBytesPerRow] >> shift) & 0x0F;
+            dstRow[k]  = (p0 << 4) | p1;
+            srcCol += srcBytesPerRow * 2;
+        }
+    }
+}
+
+/*
+ * 竖屏 Height x Width 顺时针旋转90度得到横屏 Width x Height
+ * dst(nx,ny) = src(ny, Width-1-nx)
+ */
+template <typename Panel>
+static void Rotate90CW(const uint8_t *src, uint8_t *dst) {
+    constexpr uint32_t srcBytesPerRow = Panel::PortraitBytesPerRow;
+    constexpr uint32_t dstBytesPerRow = Panel::BytesPerRow;
+    for (int ny = 0; ny < Panel::Height; ny++) {
+        const uint8_t  shift  = (ny & 1) ? 0 : 4;
+        const uint8_t *srcCol = src + (Panel::Width - 1) * srcBytesPerRow + (ny >> 1);
+        uint8_t       *dstRow = dst + ny * dstBytesPerRow;
+        for (uint32_t k = 0; k < dstBytesPerRow; k++) {
+            uint8_t p0 = (srcCol[0] >> shift) & 0x0F;
+            uint8_t p1 = (*(srcCol - srcBytesPerRow) >> shift) & 0x0F;
+            dstRow[k]  = (p0 << 4) | p1;
+            srcCol -= srcBytesPerRow * 2;
+        }
+    }
+}
+
+} // namespace EpdPanel
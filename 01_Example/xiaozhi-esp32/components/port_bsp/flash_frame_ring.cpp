@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include "flash_frame_ring.h"
+#include "display_bsp.h"
+
+bool FlashFrameRing::FlashFrameRing_Open() {
+    slotCount_ = 0;
+    seq_       = 0;
+    part_      = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, FLASH_FRAME_RING_LABEL);
+    if (part_ == NULL) {
+        ESP_LOGI(TAG, "No %s partition found", FLASH_FRAME_RING_LABEL);
+        return false;
+    }
+    slotCount_ = part_->size / FLASH_FRAME_RING_SLOT_BYTES;
+    if (slotCount_ > FLASH_FRAME_RING_SLOT_MAX) {
+        slotCount_ = FLASH_FRAME_RING_SLOT_MAX;
+    }
+    for (int i = 0; i < slotCount_; i++) {
+        FlashFrameHeader_t *h = &hdr_[i];
+        if (esp_partition_read(part_, (size_t) i * FLASH_FRAME_RING_SLOT_BYTES, h, sizeof(*h)) != ESP_OK ||
+            h->magic != FLASH_FRAME_RING_MAGIC || h->bytes > FLASH_FRAME_RING_DATA_BYTES) {
+            memset(h, 0, sizeof(*h));
+            continue;
+        }
+        if (h->seq > seq_) {
+            seq_ = h->seq;
+        }
+    }
+    ESP_LOGI(TAG, "%d slots, seq:%lu", slotCount_, (unsigned long) seq_);
+    return slotCount_ > 0;
+}
+
+int FlashFrameRing::FlashFrameRing_Find(uint32_t key) {
+    for (int i = 0; i < slotCount_ && key != 0; i++) {
+        if (hdr_[i].magic == FLASH_FRAME_RING_MAGIC && hdr_[i].key == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*只映射用到的这一个槽,不长期占用 MMU 页*/
+bool FlashFrameRing::FlashFrameRing_Get(uint32_t key, uint8_t *dst, size_t len, uint8_t *rotation) {
+    int slot = FlashFrameRing_Find(key);
+    if (slot < 0 || hdr_[slot].bytes != len) {
+        return false;
+    }
+    const void                 *ptr    = NULL;
+    esp_partition_mmap_handle_t handle = 0;
+    esp_err_t                   err    = esp_partition_mmap(part_, (size_t) slot * FLASH_FRAME_RING_SLOT_BYTES + FLASH_FRAME_RING_HEADER, len,
+                                                         ESP_PARTITION_MMAP_DATA, &ptr, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mmap slot %d: %s", slot, esp_err_to_name(err));
+        return false;
+    }
+    memcpy(dst, ptr, len);
+    esp_partition_munmap(handle);
+    *rotation = hdr_[slot].rotation;
+    return true;
+}
+
+bool FlashFrameRing::FlashFrameRing_Put(uint32_t key, const uint8_t *src, size_t len, uint8_t rotation, const uint32_t *keep, int keep_count) {
+    if (slotCount_ == 0 || key == 0 || len > FLASH_FRAME_RING_DATA_BYTES) {
+        return false;
+    }
+    int slot = FlashFrameRing_Find(key);
+    if (slot < 0) {         /*空槽优先,否则覆盖最早写入的*/
+        for (int i = 0; i < slotCount_; i++) {
+            bool kept = false;
+            for (int k = 0; k < keep_count && !kept; k++) {
+                kept = hdr_[i].magic == FLASH_FRAME_RING_MAGIC && hdr_[i].key == keep[k];
+            }
+            if (kept) {
+                continue;
+            }
+            if (slot < 0 || hdr_[i].magic != FLASH_FRAME_RING_MAGIC || hdr_[i].seq < hdr_[slot].seq) {
+                slot = i;
+                if (hdr_[i].magic != FLASH_FRAME_RING_MAGIC) {
+                    break;
+                }
+            }
+        }
+        if (slot < 0) {
+            return false;
+        }
+    }
+    size_t offset = (size_t) slot * FLASH_FRAME_RING_SLOT_BYTES;
+    memset(&hdr_[slot], 0, sizeof(hdr_[slot]));
+    esp_err_t err = esp_partition_erase_range(part_, offset, FLASH_FRAME_RING_SLOT_BYTES);
+    if (err == ESP_OK) {
+        err = esp_partition_write(part_, offset + FLASH_FRAME_RING_HEADER, src, len);
+    }
+    FlashFrameHeader_t h = {};
+    h.magic              = 0xFFFFFFFF;      /*写 1 不改变已擦除的 flash*/
+    h.key                = key;
+    h.bytes              = len;
+    h.seq                = ++seq_;
+    h.rotation           = rotation;
+    if (err == ESP_OK) {
+        err = esp_partition_write(part_, offset, &h, sizeof(h));
+    }
+    h.magic = FLASH_FRAME_RING_MAGIC;
+    if (err == ESP_OK) {
+        err = esp_partition_write(part_, offset, &h.magic, sizeof(h.magic));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "write slot %d fail:%s", slot, esp_err_to_name(err));
+        return false;
+    }
+    hdr_[slot] = h;
+    return true;
+}
+
+bool FlashFrameRing::FlashFrameRing_Show(ePaperPort &display, uint32_t key) {
+    if (!FlashFrameRing_Contains(key)) {
+        return false;
+    }
+    uint8_t *buf = display.EPD_GetIMGBuffer();
+    uint8_t  rotation;
+    if (buf == NULL || !FlashFrameRing_Get(key, buf, ePaperPort::Panel::FrameBytes, &rotation)) {
+        return false;
+    }
+    display.Set_Rotation(rotation);
+    return true;
+}
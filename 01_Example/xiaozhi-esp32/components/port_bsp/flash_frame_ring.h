@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_partition.h>
+
+class ePaperPort;
+
+#define FLASH_FRAME_RING_LABEL      "frames"
+#define FLASH_FRAME_RING_MAGIC      0x47525046      /*"FPRG"*/
+#define FLASH_FRAME_RING_HEADER     4096            /*每个槽开头一个擦除扇区放槽头*/
+#define FLASH_FRAME_RING_DATA_BYTES (192 * 1024)    /*一帧 4bpp 800x480 为 192000 字节,按扇区对齐*/
+#define FLASH_FRAME_RING_SLOT_BYTES (FLASH_FRAME_RING_HEADER + FLASH_FRAME_RING_DATA_BYTES)
+#define FLASH_FRAME_RING_SLOT_MAX   16
+
+typedef struct {
+    uint32_t magic;         /*最后写入,未写完的槽为 0xFFFFFFFF*/
+    uint32_t key;
+    uint32_t bytes;
+    uint32_t seq;           /*写入顺序,覆盖时选最小的*/
+    uint8_t  rotation;
+    uint8_t  reserved[3];
+} FlashFrameHeader_t;
+
+/*
+ * flash 数据分区中的最近/即将显示帧的环形缓存
+ * 槽头在打开时读入内存;显示时只把该槽 esp_partition_mmap 出来拷进显示缓冲区,不需要SD卡
+ * 写入时擦除整槽,先写帧数据再写槽头,magic 最后写,掉电后未写完的槽视为空槽
+ */
+class FlashFrameRing
+{
+private:
+    const char            *TAG = "FlashFrameRing";
+    const esp_partition_t *part_      = NULL;
+    int                    slotCount_ = 0;
+    uint32_t               seq_       = 0;
+    FlashFrameHeader_t     hdr_[FLASH_FRAME_RING_SLOT_MAX];
+
+    int FlashFrameRing_Find(uint32_t key);
+
+public:
+    bool FlashFrameRing_Open();                 /*没有 frames 分区时返回false*/
+    bool FlashFrameRing_Contains(uint32_t key) { return FlashFrameRing_Find(key) >= 0; }
+    bool FlashFrameRing_Get(uint32_t key, uint8_t *dst, size_t len, uint8_t *rotation);
+    /*覆盖最早写入且不在 keep 中的槽,keep 为这一批已选中要保留的帧*/
+    bool FlashFrameRing_Put(uint32_t key, const uint8_t *src, size_t len, uint8_t rotation, const uint32_t *keep = NULL, int keep_count = 0);
+    /*命中时把帧拷入显示缓冲区并恢复旋转方向*/
+    bool FlashFrameRing_Show(ePaperPort &display, uint32_t key);
+};
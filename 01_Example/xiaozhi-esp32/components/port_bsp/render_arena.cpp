@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "render_arena.h"
+
+RenderArena::RenderArena(size_t capacity) :
+capacity_(capacity) {
+}
+
+RenderArena::~RenderArena() {
+    RenderArena_Release();
+}
+
+bool RenderArena::RenderArena_Reserve() {
+    if (base_ != NULL) {
+        return true;
+    }
+    base_ = (uint8_t *) heap_caps_aligned_alloc(64, capacity_, MALLOC_CAP_SPIRAM);
+    if (base_ == NULL) {
+        failCount_++;
+        ESP_LOGE(TAG, "reserve %u bytes fail, largest free block:%u", (unsigned) capacity_,
+                 (unsigned) heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+        return false;
+    }
+    offset_ = 0;
+    reserveCount_++;
+    return true;
+}
+
+void RenderArena::RenderArena_Release() {
+    if (base_ == NULL) {
+        return;
+    }
+    heap_caps_free(base_);
+    base_   = NULL;
+    offset_ = 0;
+}
+
+void *RenderArena::RenderArena_Alloc(size_t size, size_t align) {
+    if (!RenderArena_Reserve()) {
+        return NULL;
+    }
+    size_t start = (offset_ + align - 1) & ~(align - 1);
+    if (start + size > capacity_) {
+        failCount_++;
+        ESP_LOGE(TAG, "alloc %u bytes fail, used:%u/%u", (unsigned) size, (unsigned) offset_, (unsigned) capacity_);
+        return NULL;
+    }
+    offset_ = start + size;
+    if (offset_ > highWater_) {
+        highWater_ = offset_;
+    }
+    if (offset_ > stagePeak_) {
+        stagePeak_ = offset_;
+    }
+    return base_ + start;
+}
+
+size_t RenderArena::RenderArena_Mark() {
+    return offset_;
+}
+
+void RenderArena::RenderArena_Rewind(size_t mark) {
+    if (mark <= offset_) {
+        offset_ = mark;
+    }
+}
+
+bool RenderArena::RenderArena_IsReserved() {
+    return base_ != NULL;
+}
+
+size_t RenderArena::RenderArena_GetUsed() {
+    return offset_;
+}
+
+size_t RenderArena::RenderArena_GetCapacity() {
+    return capacity_;
+}
+
+size_t RenderArena::RenderArena_GetHighWater() {
+    return highWater_;
+}
+
+size_t RenderArena::RenderArena_BeginPeak() {
+    size_t prev = stagePeak_;
+    stagePeak_  = offset_;
+    return prev;
+}
+
+size_t RenderArena::RenderArena_EndPeak(size_t prevPeak) {
+    size_t peak = stagePeak_;
+    if (prevPeak > stagePeak_) {
+        stagePeak_ = prevPeak;
+    }
+    return peak;
+}
+
+void RenderArena::RenderArena_LogStats() {
+    ESP_LOGI(TAG, "capacity:%u highwater:%u reserve:%lu fail:%lu", (unsigned) capacity_, (unsigned) highWater_,
+             (unsigned long) reserveCount_, (unsigned long) failCount_);
+}
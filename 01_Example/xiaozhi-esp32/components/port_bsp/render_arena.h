@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 渲染内存池:一次渲染所需的大缓冲区都从同一块PSRAM中顺序分配
+ * 第一次分配时才向系统申请整块内存,渲染结束(空闲)后整块释放,避免长时间运行后PSRAM碎片化
+ * 只允许在持有 epaper_gui_semapHandle 的渲染上下文中使用,内部不加锁
+ */
+class RenderArena
+{
+private:
+    const char *TAG = "RenderArena";
+    uint8_t    *base_      = NULL;
+    size_t      capacity_;
+    size_t      offset_    = 0;
+    size_t      highWater_ = 0;        /*单次占用的最大值*/
+    size_t      stagePeak_ = 0;        /*当前统计区间内的最大值,供RenderProfiler使用*/
+    uint32_t    reserveCount_ = 0;
+    uint32_t    failCount_    = 0;
+
+public:
+    RenderArena(size_t capacity);
+    ~RenderArena();
+
+    bool   RenderArena_Reserve();                              /*申请整块内存,已申请则直接返回*/
+    void   RenderArena_Release();                              /*整块释放,之前分配的指针全部失效*/
+    void  *RenderArena_Alloc(size_t size, size_t align = 16);  /*失败返回NULL*/
+    size_t RenderArena_Mark();
+    void   RenderArena_Rewind(size_t mark);                    /*回退到Mark处,释放其后分配的所有缓冲区*/
+    bool   RenderArena_IsReserved();
+    size_t RenderArena_GetUsed();
+    size_t RenderArena_GetCapacity();
+    size_t RenderArena_GetHighWater();
+    size_t RenderArena_BeginPeak();                            /*开始统计区间,返回上一层区间的峰值*/
+    size_t RenderArena_EndPeak(size_t prevPeak);               /*结束统计区间,返回本区间峰值*/
+    void   RenderArena_LogStats();
+};
+
+/*作用域结束时自动回退到构造时的位置*/
+class RenderArenaScope
+{
+private:
+    RenderArena &arena_;
+    size_t       mark_;
+
+public:
+    RenderArenaScope(RenderArena &arena) : arena_(arena), mark_(arena.RenderArena_Mark()) {}
+    ~RenderArenaScope() { arena_.RenderArena_Rewind(mark_); }
+};
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "render_profiler.h"
+#include "render_arena.h"
+
+RenderProfiler renderProfiler;
+
+void RenderProfiler::RenderProfiler_SetArena(RenderArena *arena) {
+    arena_ = arena;
+}
+
+RenderArena *RenderProfiler::RenderProfiler_GetArena() {
+    return arena_;
+}
+
+void RenderProfiler::RenderProfiler_SetVerbose(bool verbose) {
+    verbose_ = verbose;
+}
+
+bool RenderProfiler::RenderProfiler_GetVerbose() {
+    return verbose_;
+}
+
+void RenderProfiler::RenderProfiler_BeginFrame() {
+    taskENTER_CRITICAL(&lock_);
+    frame_++;
+    taskEXIT_CRITICAL(&lock_);
+}
+
+void RenderProfiler::RenderProfiler_Record(const char *stage, int64_t start_us, uint32_t duration_us, uint32_t bytes, uint32_t arena_peak) {
+    RenderProfileRecord_t rec;
+    rec.stage       = stage;
+    rec.start_us    = start_us;
+    rec.duration_us = duration_us;
+    rec.bytes       = bytes;
+    rec.arena_peak  = arena_peak;
+    rec.psram_used  = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    taskENTER_CRITICAL(&lock_);
+    rec.frame       = frame_;
+    records_[head_] = rec;
+    head_           = (head_ + 1) % RENDER_PROFILER_RECORD_MAX;
+    if (count_ < RENDER_PROFILER_RECORD_MAX) {
+        count_++;
+    }
+    taskEXIT_CRITICAL(&lock_);
+    if (!verbose_) {
+        return;
+    }
+    ESP_LOGI(TAG, "frame:%lu %s %luus %lubytes", (unsigned long) rec.frame, stage, (unsigned long) duration_us, (unsigned long) bytes);
+}
+
+int RenderProfiler::RenderProfiler_ToJson(char *buf, size_t len) {
+    RenderProfileRecord_t snap[RENDER_PROFILER_RECORD_MAX];
+    uint32_t              count;
+    taskENTER_CRITICAL(&lock_);
+    count = count_;
+    for (uint32_t i = 0; i < count; i++) {
+        snap[i] = records_[(head_ + RENDER_PROFILER_RECORD_MAX - count + i) % RENDER_PROFILER_RECORD_MAX];
+    }
+    taskEXIT_CRITICAL(&lock_);
+
+    /*从最新的记录往前估算,缓冲区放不下时丢弃最旧的*/
+    const size_t recordMax = 160;
+    uint32_t     first     = 0;
+    if (len < 64) {
+        return 0;
+    }
+    if ((size_t) count * recordMax + 64 > len) {
+        first = count - (len - 64) / recordMax;
+    }
+    size_t arena_cap  = arena_ ? arena_->RenderArena_GetCapacity() : 0;
+    size_t arena_high = arena_ ? arena_->RenderArena_GetHighWater() : 0;
+    int    pos        = snprintf(buf, len, "{\"arena_capacity\":%u,\"arena_highwater\":%u,\"records\":[", (unsigned) arena_cap, (unsigned) arena_high);
+    for (uint32_t i = first; i < count && pos < (int) len; i++) {
+        pos += snprintf(buf + pos, len - pos,
+                        "%s{\"frame\":%lu,\"stage\":\"%s\",\"start_us\":%lld,\"us\":%lu,\"bytes\":%lu,\"arena_peak\":%lu,\"psram_used\":%lu}",
+                        (i == first) ? "" : ",", (unsigned long) snap[i].frame, snap[i].stage, (long long) snap[i].start_us,
+                        (unsigned long) snap[i].duration_us, (unsigned long) snap[i].bytes, (unsigned long) snap[i].arena_peak,
+                        (unsigned long) snap[i].psram_used);
+    }
+    if (pos < (int) len) {
+        pos += snprintf(buf + pos, len - pos, "]}");
+    }
+    return (pos < (int) len) ? pos : (int) len - 1;
+}
+
+int RenderProfiler::RenderProfiler_DumpToSdcard(const char *path) {
+    const size_t len = RENDER_PROFILER_RECORD_MAX * 160 + 64;
+    char        *buf = (char *) heap_caps_malloc(len, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        return 0;
+    }
+    int   n  = RenderProfiler_ToJson(buf, len);
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "open %s fail", path);
+        heap_caps_free(buf);
+        return 0;
+    }
+    fwrite(buf, 1, n, fp);
+    fclose(fp);
+    heap_caps_free(buf);
+    return n;
+}
+
+void RenderProfiler::RenderProfiler_Clear() {
+    taskENTER_CRITICAL(&lock_);
+    head_  = 0;
+    count_ = 0;
+    taskEXIT_CRITICAL(&lock_);
+}
+
+RenderProfileScope::RenderProfileScope(const char *stage, uint32_t bytes) :
+stage_(stage),
+bytes_(bytes) {
+    RenderArena *arena = renderProfiler.RenderProfiler_GetArena();
+    prevPeak_          = arena ? arena->RenderArena_BeginPeak() : 0;
+    start_             = esp_timer_get_time();
+}
+
+RenderProfileScope::~RenderProfileScope() {
+    int64_t      end   = esp_timer_get_time();
+    RenderArena *arena = renderProfiler.RenderProfiler_GetArena();
+    size_t       peak  = arena ? arena->RenderArena_EndPeak(prevPeak_) : 0;
+    renderProfiler.RenderProfiler_Record(stage_, start_, (uint32_t) (end - start_), bytes_, peak);
+}
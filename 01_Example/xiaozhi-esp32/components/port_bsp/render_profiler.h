@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+
+#define RENDER_PROFILER_RECORD_MAX 48
+#define RENDER_PROFILER_SDCARD_PATH "/sdcard/render_profile.json"
+
+typedef struct {
+    uint32_t    frame;        /*第几次渲染*/
+    const char *stage;        /*阶段名,必须是字符串常量*/
+    int64_t     start_us;
+    uint32_t    duration_us;
+    uint32_t    bytes;        /*该阶段处理的数据量*/
+    uint32_t    arena_peak;   /*该阶段内渲染内存池的峰值占用*/
+    uint32_t    psram_used;   /*阶段结束时PSRAM已用大小*/
+} RenderProfileRecord_t;
+
+class RenderArena;
+
+/*
+ * 渲染流程各阶段耗时统计,记录保存在环形缓冲区中
+ * 可通过网页 /RenderProfile 获取JSON;打开 verbose 后才打印日志、写到SD卡
+ */
+class RenderProfiler
+{
+private:
+    const char           *TAG = "RenderProfiler";
+    RenderProfileRecord_t records_[RENDER_PROFILER_RECORD_MAX];
+    uint32_t              head_  = 0;          /*下一条写入位置*/
+    uint32_t              count_ = 0;
+    uint32_t              frame_ = 0;
+    RenderArena          *arena_ = NULL;
+    bool                  verbose_ = false;    /*逐条打印日志并在每次刷新后写SD卡,由 config.txt 的 render.profile 打开*/
+    portMUX_TYPE          lock_  = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+    void     RenderProfiler_SetArena(RenderArena *arena);
+    RenderArena *RenderProfiler_GetArena();
+    void     RenderProfiler_SetVerbose(bool verbose);
+    bool     RenderProfiler_GetVerbose();
+    void     RenderProfiler_BeginFrame();       /*开始新的一帧,之后的记录归属此帧*/
+    void     RenderProfiler_Record(const char *stage, int64_t start_us, uint32_t duration_us, uint32_t bytes, uint32_t arena_peak);
+    int      RenderProfiler_ToJson(char *buf, size_t len);   /*返回写入长度,缓冲区不足时只输出最新的记录*/
+    int      RenderProfiler_DumpToSdcard(const char *path = RENDER_PROFILER_SDCARD_PATH);
+    void     RenderProfiler_Clear();
+};
+
+extern RenderProfiler renderProfiler;
+
+/*在作用域结束时记录一个阶段*/
+class RenderProfileScope
+{
+private:
+    const char *stage_;
+    int64_t     start_;
+    uint32_t    bytes_;
+    size_t      prevPeak_;
+
+public:
+    RenderProfileScope(const char *stage, uint32_t bytes = 0);
+    ~RenderProfileScope();
+    void SetBytes(uint32_t bytes) { bytes_ = bytes; }
+};
+
+#define RENDER_PROFILE_CONCAT_(a, b) a##b
+#define RENDER_PROFILE_CONCAT(a, b) RENDER_PROFILE_CONCAT_(a, b)
+#define RENDER_PROFILE_SCOPE(stage, bytes) RenderProfileScope RENDER_PROFILE_CONCAT(_render_profile_, __LINE__)(stage, bytes)
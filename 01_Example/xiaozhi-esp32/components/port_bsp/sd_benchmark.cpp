@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_random.h>
+#include <esp_log.h>
+#include "sd_benchmark.h"
+
+static const uint32_t SDBenchmarkBlocks[] = {512, 4 * 1024, 16 * 1024, 64 * 1024};
+#define SD_BENCHMARK_BLOCK_MAX (64 * 1024)
+
+SDBenchmark::SDBenchmark(CustomSDPort *sd) :
+sd_(sd) {
+}
+
+uint32_t SDBenchmark::SDBenchmark_Rand() {
+    rand_ = rand_ * 1664525 + 1013904223;
+    return rand_ >> 8;
+}
+
+void SDBenchmark::SDBenchmark_Add(const char *test, uint32_t block, uint32_t ops, uint64_t bytes, int64_t start_us) {
+    uint32_t us = (uint32_t) (esp_timer_get_time() - start_us);
+    if (count_ >= SD_BENCHMARK_RECORD_MAX) {
+        return;
+    }
+    records_[count_++] = {test, block, ops, bytes, us};
+    ESP_LOGI(TAG, "%-10s block:%6lu ops:%5lu %8.1f KB/s %8.1f us/op", test, (unsigned long) block, (unsigned long) ops,
+             us ? bytes * 1000000.0 / 1024 / us : 0.0, ops ? (double) us / ops : 0.0);
+}
+
+/*包括 fsync 和 fclose,数据确实写到卡上才停止计时*/
+bool SDBenchmark::SDBenchmark_SeqWrite(uint8_t *buf, uint32_t block) {
+    int64_t start = esp_timer_get_time();
+    FILE   *fp    = fopen(SD_BENCHMARK_FILE, "wb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", SD_BENCHMARK_FILE);
+        return false;
+    }
+    setvbuf(fp, NULL, _IONBF, 0);
+    uint32_t ops = SD_BENCHMARK_FILE_SIZE / block;
+    bool     ok  = true;
+    for (uint32_t i = 0; i < ops && ok; i++) {
+        ok = fwrite(buf, 1, block, fp) == block;
+    }
+    fflush(fp);
+    fsync(fileno(fp));
+    ok = (fclose(fp) == 0) && ok;
+    SDBenchmark_Add("seq_write", block, ops, (uint64_t) ops * block, start);
+    return ok;
+}
+
+bool SDBenchmark::SDBenchmark_SeqRead(uint8_t *buf, uint32_t block) {
+    int64_t start = esp_timer_get_time();
+    FILE   *fp    = fopen(SD_BENCHMARK_FILE, "rb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file: %s", SD_BENCHMARK_FILE);
+        return false;
+    }
+    setvbuf(fp, NULL, _IONBF, 0);
+    uint32_t ops   = 0;
+    uint64_t bytes = 0;
+    size_t   n;
+    while ((n = fread(buf, 1, block, fp)) > 0) {
+        bytes += n;
+        ops++;
+    }
+    fclose(fp);
+    SDBenchmark_Add("seq_read", block, ops, bytes, start);
+    return bytes == SD_BENCHMARK_FILE_SIZE;
+}
+
+/*块对齐的随机位置读写,写测试结束时 fsync*/
+bool SDBenchmark::SDBenchmark_Random(uint8_t *buf, uint32_t block, bool write) {
+    int64_t start = esp_timer_get_time();
+    FILE   *fp    = fopen(SD_BENCHMARK_FILE, write ? "r+b" : "rb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file: %s", SD_BENCHMARK_FILE);
+        return false;
+    }
+    setvbuf(fp, NULL, _IONBF, 0);
+    uint32_t blocks = SD_BENCHMARK_FILE_SIZE / block;
+    bool     ok     = true;
+    for (uint32_t i = 0; i < SD_BENCHMARK_RANDOM_OPS && ok; i++) {
+        long offset = (long) (SDBenchmark_Rand() % blocks) * block;
+        ok          = fseek(fp, offset, SEEK_SET) == 0;
+        if (ok) {
+            ok = (write ? fwrite(buf, 1, block, fp) : fread(buf, 1, block, fp)) == block;
+        }
+    }
+    if (write) {
+        fflush(fp);
+        fsync(fileno(fp));
+    }
+    fclose(fp);
+    SDBenchmark_Add(write ? "rand_write" : "rand_read", block, SD_BENCHMARK_RANDOM_OPS, (uint64_t) SD_BENCHMARK_RANDOM_OPS * block, start);
+    return ok;
+}
+
+bool SDBenchmark::SDBenchmark_OpenClose() {
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < SD_BENCHMARK_OPEN_OPS; i++) {
+        FILE *fp = fopen(SD_BENCHMARK_FILE, "rb");
+        if (fp == NULL) {
+            return false;
+        }
+        fclose(fp);
+    }
+    SDBenchmark_Add("open_close", 0, SD_BENCHMARK_OPEN_OPS, 0, start);
+    return true;
+}
+
+bool SDBenchmark::SDBenchmark_Run() {
+    uint8_t *buf = (uint8_t *) heap_caps_malloc(SD_BENCHMARK_BLOCK_MAX, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "buffer alloc fail");
+        return false;
+    }
+    for (int i = 0; i < SD_BENCHMARK_BLOCK_MAX; i++) {
+        buf[i] = (uint8_t) (i * 31 + 7);
+    }
+    count_  = 0;
+    rand_   = esp_random() | 1;
+    bool ok = true;
+    for (size_t b = 0; b < sizeof(SDBenchmarkBlocks) / sizeof(SDBenchmarkBlocks[0]) && ok; b++) {
+        uint32_t block = SDBenchmarkBlocks[b];
+        ok             = SDBenchmark_SeqWrite(buf, block) && SDBenchmark_SeqRead(buf, block) &&
+                         SDBenchmark_Random(buf, block, false) && SDBenchmark_Random(buf, block, true);
+    }
+    ok = ok && SDBenchmark_OpenClose();
+    remove(SD_BENCHMARK_FILE);
+    heap_caps_free(buf);
+    if (!ok) {
+        ESP_LOGE(TAG, "benchmark fail after %d records", count_);
+    }
+    return ok;
+}
+
+int SDBenchmark::SDBenchmark_ToJson(char *buf, size_t len) {
+    const SDPortBusConfig_t *bus  = sd_->SDPort_GetBusConfig();
+    sdmmc_card_t            *card = sd_->SDPort_GetSdMMCHost();
+    int pos = snprintf(buf, len, "{\"width\":%d,\"freq_khz\":%lu,\"ddr\":%d,\"card_khz\":%lu,\"read_buf\":%lu,\"write_buf\":%lu,\"records\":[",
+                       bus->width, (unsigned long) bus->freq_khz, card ? (int) card->is_ddr : 0, card ? (unsigned long) card->max_freq_khz : 0UL,
+                       (unsigned long) bus->read_buf, (unsigned long) bus->write_buf);
+    for (int i = 0; i < count_ && pos < (int) len; i++) {
+        const SDBenchmarkRecord_t *r = &records_[i];
+        pos += snprintf(buf + pos, len - pos, "%s{\"test\":\"%s\",\"block\":%lu,\"ops\":%lu,\"bytes\":%llu,\"us\":%lu,\"kbps\":%lu}",
+                        i ? "," : "", r->test, (unsigned long) r->block, (unsigned long) r->ops, (unsigned long long) r->bytes,
+                        (unsigned long) r->us, r->us ? (unsigned long) (r->bytes * 1000000 / 1024 / r->us) : 0UL);
+    }
+    if (pos < (int) len) {
+        pos += snprintf(buf + pos, len - pos, "]}");
+    }
+    return (pos < (int) len) ? pos : (int) len - 1;
+}
+
+int SDBenchmark::SDBenchmark_DumpToSdcard(const char *path) {
+    const size_t len = SD_BENCHMARK_RECORD_MAX * 128 + 160;
+    char        *buf = (char *) heap_caps_malloc(len, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        return 0;
+    }
+    int   n  = SDBenchmark_ToJson(buf, len);
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "open %s fail", path);
+        heap_caps_free(buf);
+        return 0;
+    }
+    fwrite(buf, 1, n, fp);
+    fclose(fp);
+    heap_caps_free(buf);
+    return n;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdcard_bsp.h"
+
+#define SD_BENCHMARK_FILE       "/sdcard/sd_benchmark.tmp"
+#define SD_BENCHMARK_RESULT     "/sdcard/sd_benchmark.json"
+#define SD_BENCHMARK_FILE_SIZE  (4 * 1024 * 1024)
+#define SD_BENCHMARK_RANDOM_OPS 64
+#define SD_BENCHMARK_OPEN_OPS   32
+#define SD_BENCHMARK_RECORD_MAX 20
+
+typedef struct {
+    const char *test;       /*seq_write / seq_read / rand_write / rand_read / open_close,字符串常量*/
+    uint32_t    block;      /*每次读写的字节数,open_close 为0*/
+    uint32_t    ops;
+    uint64_t    bytes;
+    uint32_t    us;
+} SDBenchmarkRecord_t;
+
+/*
+ * SD卡存储性能测试:不同块大小的顺序/随机读写,以及打开关闭文件的开销
+ * 缓冲区与流式读写一样在 PSRAM 中申请,测到的是实际使用时的速度
+ * 测试文件用完即删;结果可写到SD卡,网页 /SDBenchmark 读取
+ */
+class SDBenchmark
+{
+private:
+    const char         *TAG = "SDBenchmark";
+    CustomSDPort       *sd_;
+    SDBenchmarkRecord_t records_[SD_BENCHMARK_RECORD_MAX];
+    int                 count_ = 0;
+    uint32_t            rand_  = 1;
+
+    uint32_t SDBenchmark_Rand();
+    void     SDBenchmark_Add(const char *test, uint32_t block, uint32_t ops, uint64_t bytes, int64_t start_us);
+    bool     SDBenchmark_SeqWrite(uint8_t *buf, uint32_t block);
+    bool     SDBenchmark_SeqRead(uint8_t *buf, uint32_t block);
+    bool     SDBenchmark_Random(uint8_t *buf, uint32_t block, bool write);
+    bool     SDBenchmark_OpenClose();
+
+public:
+    SDBenchmark(CustomSDPort *sd);
+
+    bool SDBenchmark_Run();
+    int  SDBenchmark_ToJson(char *buf, size_t len);      /*返回写入长度*/
+    int  SDBenchmark_DumpToSdcard(const char *path = SD_BENCHMARK_RESULT);
+};
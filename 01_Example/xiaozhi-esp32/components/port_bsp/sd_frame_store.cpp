@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <esp_log.h>
+#include "ff.h"
+#include "diskio_sdmmc.h"
+#include "sd_frame_store.h"
+#include "display_bsp.h"
+#include "render_config.h"
+
+#define SD_FRAME_STORE_SECTOR    512
+#define SD_FRAME_STORE_FILE_SIZE (SD_FRAME_STORE_DIR_BYTES + (uint64_t) SD_FRAME_STORE_SLOT_BYTES * SD_FRAME_STORE_SLOTS)
+
+SDFrameStore::SDFrameStore(CustomSDPort *sd) :
+sd_(sd) {
+}
+
+SDFrameStore::~SDFrameStore() {
+    if (dir_ != NULL) {
+        heap_caps_free(dir_);
+    }
+}
+
+/*通过 FatFs 取文件的起始簇,换算成卡上的绝对扇区号;文件连续,之后按偏移直接访问*/
+bool SDFrameStore::SDFrameStore_Locate() {
+    BYTE pdrv = ff_diskio_get_pdrv_card(card_);
+    if (pdrv == 0xFF) {
+        ESP_LOGE(TAG, "card not registered to FatFs");
+        return false;
+    }
+    char fat_path[32];
+    snprintf(fat_path, sizeof(fat_path), "%d:%s", pdrv, SD_FRAME_STORE_PATH + strlen("/sdcard"));
+    FIL     fil;
+    FRESULT res = f_open(&fil, fat_path, FA_READ);
+    if (res != FR_OK) {
+        ESP_LOGE(TAG, "f_open %s fail:%d", fat_path, res);
+        return false;
+    }
+    FATFS *fs    = fil.obj.fs;
+    DWORD  clust = fil.obj.sclust;
+    bool   ok    = clust >= 2 && fs->ssize == SD_FRAME_STORE_SECTOR;
+    if (ok) {
+        firstSector_ = (uint32_t) (fs->database + (LBA_t) fs->csize * (clust - 2));
+    }
+    f_close(&fil);
+    return ok;
+}
+
+/*能 DMA 的缓冲区一次传完,否则(PSRAM)经过内部内存分块传输,每块仍是一次多扇区传输*/
+bool SDFrameStore::SDFrameStore_Transfer(uint32_t sector, uint8_t *buf, size_t bytes, bool write) {
+    size_t    count = (bytes + SD_FRAME_STORE_SECTOR - 1) / SD_FRAME_STORE_SECTOR;
+    esp_err_t ret   = ESP_OK;
+    if (esp_ptr_dma_capable(buf) && bytes % SD_FRAME_STORE_SECTOR == 0 && ((uintptr_t) buf & 3) == 0) {
+        ret = write ? sdmmc_write_sectors(card_, buf, sector, count) : sdmmc_read_sectors(card_, buf, sector, count);
+    } else {
+        uint8_t *bounce = (uint8_t *) heap_caps_malloc(SD_FRAME_STORE_BOUNCE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (bounce == NULL) {
+            ESP_LOGE(TAG, "bounce buffer alloc fail");
+            return false;
+        }
+        for (size_t off = 0; off < bytes && ret == ESP_OK; off += SD_FRAME_STORE_BOUNCE) {
+            size_t n   = (bytes - off < SD_FRAME_STORE_BOUNCE) ? bytes - off : SD_FRAME_STORE_BOUNCE;
+            size_t cnt = (n + SD_FRAME_STORE_SECTOR - 1) / SD_FRAME_STORE_SECTOR;
+            if (write) {
+                memcpy(bounce, buf + off, n);
+                memset(bounce + n, 0, cnt * SD_FRAME_STORE_SECTOR - n);
+                ret = sdmmc_write_sectors(card_, bounce, sector + off / SD_FRAME_STORE_SECTOR, cnt);
+            } else {
+                ret = sdmmc_read_sectors(card_, bounce, sector + off / SD_FRAME_STORE_SECTOR, cnt);
+                memcpy(buf + off, bounce, n);
+            }
+        }
+        heap_caps_free(bounce);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s sectors %lu+%u fail:%s", write ? "write" : "read", (unsigned long) sector, (unsigned) count, esp_err_to_name(ret));
+        return false;
+    }
+    return true;
+}
+
+bool SDFrameStore::SDFrameStore_WriteDir() {
+    return SDFrameStore_Transfer(firstSector_, (uint8_t *) dir_, SD_FRAME_STORE_DIR_BYTES, true);
+}
+
+int SDFrameStore::SDFrameStore_Find(uint32_t key) {
+    for (int i = 0; i < SD_FRAME_STORE_SLOTS; i++) {
+        if (dir_->slots[i].key == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool SDFrameStore::SDFrameStore_Open() {
+    ready_ = false;
+    card_  = sd_->SDPort_GetSdMMCHost();
+    if (card_ == NULL) {
+        return false;
+    }
+    if (dir_ == NULL) {
+        dir_ = (SDFrameDir_t *) heap_caps_calloc(1, SD_FRAME_STORE_DIR_BYTES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (dir_ == NULL) {
+            ESP_LOGE(TAG, "directory alloc fail");
+            return false;
+        }
+    }
+    const char *base          = "/sdcard";
+    bool        is_contiguous = false;
+    if (esp_vfs_fat_test_contiguous_file(base, SD_FRAME_STORE_PATH, &is_contiguous) != ESP_OK || !is_contiguous) {
+        /*第一次使用,或者文件被改动过:重新分配一块连续空间,旧的帧全部作废*/
+        remove(SD_FRAME_STORE_PATH);
+        esp_err_t ret = esp_vfs_fat_create_contiguous_file(base, SD_FRAME_STORE_PATH, SD_FRAME_STORE_FILE_SIZE, true);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "contiguous file create fail:%s", esp_err_to_name(ret));
+            return false;
+        }
+        ESP_LOGI(TAG, "frame store created: %u slots", SD_FRAME_STORE_SLOTS);
+    }
+    if (!SDFrameStore_Locate() || !SDFrameStore_Transfer(firstSector_, (uint8_t *) dir_, SD_FRAME_STORE_DIR_BYTES, false)) {
+        return false;
+    }
+    if (dir_->magic != SD_FRAME_STORE_MAGIC || dir_->version != SD_FRAME_STORE_VERSION || dir_->slotCount != SD_FRAME_STORE_SLOTS ||
+        dir_->slotBytes != SD_FRAME_STORE_SLOT_BYTES) {
+        memset(dir_, 0, SD_FRAME_STORE_DIR_BYTES);
+        dir_->magic     = SD_FRAME_STORE_MAGIC;
+        dir_->version   = SD_FRAME_STORE_VERSION;
+        dir_->slotCount = SD_FRAME_STORE_SLOTS;
+        dir_->slotBytes = SD_FRAME_STORE_SLOT_BYTES;
+        if (!SDFrameStore_WriteDir()) {
+            return false;
+        }
+    }
+    ready_ = true;
+    return true;
+}
+
+bool SDFrameStore::SDFrameStore_Get(uint32_t key, uint8_t *dst, size_t len, uint8_t *rotation) {
+    int slot = ready_ && key != 0 ? SDFrameStore_Find(key) : -1;
+    if (slot < 0 || dir_->slots[slot].bytes != len) {
+        return false;
+    }
+    uint32_t sector = firstSector_ + (SD_FRAME_STORE_DIR_BYTES + (uint32_t) slot * SD_FRAME_STORE_SLOT_BYTES) / SD_FRAME_STORE_SECTOR;
+    if (!SDFrameStore_Transfer(sector, dst, len, false)) {
+        return false;
+    }
+    *rotation = dir_->slots[slot].rotation;
+    return true;
+}
+
+bool SDFrameStore::SDFrameStore_Put(uint32_t key, const uint8_t *src, size_t len, uint8_t rotation) {
+    if (!ready_ || key == 0 || len > SD_FRAME_STORE_SLOT_BYTES) {
+        return false;
+    }
+    int slot = SDFrameStore_Find(key);
+    if (slot < 0) {         /*空槽优先,否则覆盖最早写入的*/
+        slot = 0;
+        for (int i = 0; i < SD_FRAME_STORE_SLOTS; i++) {
+            if (dir_->slots[i].key == 0 || dir_->slots[i].seq < dir_->slots[slot].seq) {
+                slot = i;
+                if (dir_->slots[i].key == 0) {
+                    break;
+                }
+            }
+        }
+    }
+    /*先作废目录项再写数据,写到一半掉电时不会读到半帧*/
+    dir_->slots[slot].key = 0;
+    uint32_t sector       = firstSector_ + (SD_FRAME_STORE_DIR_BYTES + (uint32_t) slot * SD_FRAME_STORE_SLOT_BYTES) / SD_FRAME_STORE_SECTOR;
+    if (!SDFrameStore_WriteDir() || !SDFrameStore_Transfer(sector, (uint8_t *) src, len, true)) {
+        return false;
+    }
+    SDFrameSlot_t *s = &dir_->slots[slot];
+    s->key           = key;
+    s->bytes         = len;
+    s->rotation      = rotation;
+    s->seq           = ++dir_->seq;
+    return SDFrameStore_WriteDir();
+}
+
+uint32_t SDFrameStore::SDFrameStore_ImageKey(uint32_t content_hash, const char *path) {
+    ImgRenderOptions_t opts;
+    renderConfig.RenderConfig_Get(path, &opts);
+    uint32_t fields[] = {content_hash,
+                         (uint32_t) opts.mode,
+                         (uint32_t) opts.background[0] << 16 | (uint32_t) opts.background[1] << 8 | opts.background[2],
+                         (uint32_t) opts.focus_x << 16 | opts.focus_y,
+                         (uint32_t) (opts.tone.gamma * 1000),
+                         (uint32_t) (opts.tone.contrast * 1000),
+                         (uint32_t) (opts.tone.saturation * 1000),
+                         (uint32_t) opts.tone.auto_levels,
+                         (uint32_t) (opts.tone.clip * 1000)};
+    uint32_t    hash    = 0x811C9DC5;
+    const char *palette = renderConfig.RenderConfig_GetPalette();
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        for (int b = 0; b < 4; b++) {
+            hash = (hash ^ ((fields[i] >> (b * 8)) & 0xFF)) * 0x01000193;
+        }
+    }
+    for (const char *p = palette; *p; p++) {
+        hash = (hash ^ (uint8_t) *p) * 0x01000193;
+    }
+    return hash ? hash : 1;
+}
+
+bool SDFrameStore::SDFrameStore_Show(ePaperPort &display, uint32_t key) {
+    uint8_t *buf = display.EPD_GetIMGBuffer();
+    uint8_t  rotation;
+    if (buf == NULL) {
+        return false;
+    }
+    int slot = ready_ && key != 0 ? SDFrameStore_Find(key) : -1;
+    if (slot < 0) {
+        return false;
+    }
+    if (!SDFrameStore_Get(key, buf, ePaperPort::Panel::FrameBytes, &rotation)) {
+        display.EPD_DispClear(ColorWhite);      /*读了一半的帧不能留给后面的解码*/
+        return false;
+    }
+    display.Set_Rotation(rotation);
+    return true;
+}
+
+bool SDFrameStore::SDFrameStore_Save(ePaperPort &display, uint32_t key) {
+    uint8_t *buf = display.EPD_GetIMGBuffer();
+    return buf != NULL && SDFrameStore_Put(key, buf, ePaperPort::Panel::FrameBytes, display.Get_Rotation());
+}
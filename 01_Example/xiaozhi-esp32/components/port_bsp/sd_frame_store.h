@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdcard_bsp.h"
+
+class ePaperPort;
+
+#define SD_FRAME_STORE_PATH       "/sdcard/frames.bin"
+#define SD_FRAME_STORE_MAGIC      0x4D524650     /*"PFRM"*/
+#define SD_FRAME_STORE_VERSION    1
+#define SD_FRAME_STORE_SLOT_BYTES (192 * 1024)   /*一帧 4bpp 800x480 为 192000 字节,按 4KB 对齐*/
+#define SD_FRAME_STORE_SLOTS      32
+#define SD_FRAME_STORE_DIR_BYTES  4096           /*文件开头的槽目录*/
+#define SD_FRAME_STORE_BOUNCE     (32 * 1024)    /*目标不能 DMA 时经过的内部内存缓冲区*/
+
+typedef struct {
+    uint32_t key;           /*0 表示空槽*/
+    uint32_t bytes;
+    uint8_t  rotation;      /*保存时的 Rotation,显示时恢复*/
+    uint8_t  reserved[3];
+    uint32_t seq;           /*写入顺序*/
+} SDFrameSlot_t;
+
+typedef struct {
+    uint32_t      magic;
+    uint16_t      version;
+    uint16_t      slotCount;
+    uint32_t      slotBytes;
+    uint32_t      seq;
+    SDFrameSlot_t slots[SD_FRAME_STORE_SLOTS];
+} SDFrameDir_t;
+
+/*
+ * 已抖动面板帧的SD卡缓存,不经过 FAT 逐个文件读写
+ * 打开时预分配一个连续的大文件(槽目录 + 固定大小的槽),只查一次它的起始扇区,
+ * 之后每帧都是一次多扇区 sdmmc_read_sectors/sdmmc_write_sectors
+ * 先作废目录项,写完帧数据再写目录,中途掉电最多丢掉这一帧;槽满时覆盖最早写入的帧
+ */
+class SDFrameStore
+{
+private:
+    const char   *TAG = "SDFrameStore";
+    CustomSDPort *sd_;
+    sdmmc_card_t *card_        = NULL;
+    uint32_t      firstSector_ = 0;
+    SDFrameDir_t *dir_         = NULL;          /*DMA 内存,直接读写目录扇区*/
+    bool          ready_       = false;
+
+    bool SDFrameStore_Locate();
+    bool SDFrameStore_Transfer(uint32_t sector, uint8_t *buf, size_t bytes, bool write);
+    bool SDFrameStore_WriteDir();
+    int  SDFrameStore_Find(uint32_t key);
+
+public:
+    SDFrameStore(CustomSDPort *sd);
+    ~SDFrameStore();
+
+    bool SDFrameStore_Open();       /*文件不存在或不连续时重新创建*/
+    bool SDFrameStore_Get(uint32_t key, uint8_t *dst, size_t len, uint8_t *rotation);
+    bool SDFrameStore_Put(uint32_t key, const uint8_t *src, size_t len, uint8_t rotation);
+
+    /*图片内容哈希 + 该图片的渲染配置 + 调色板,任何一项变化都不会命中旧的帧*/
+    static uint32_t SDFrameStore_ImageKey(uint32_t content_hash, const char *path);
+    /*命中时把帧读入显示缓冲区并恢复旋转方向;未命中返回false*/
+    bool SDFrameStore_Show(ePaperPort &display, uint32_t key);
+    bool SDFrameStore_Save(ePaperPort &display, uint32_t key);
+};
@@ -0,0 +1,444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include "sd_library.h"
+#include "img_source.h"
+#include "sdcard_bsp.h"
+
+#define SD_LIBRARY_HASH_CHUNK (8 * 1024)
+
+SDLibrary::SDLibrary(const char *dir) {
+    snprintf(dir_, sizeof(dir_), "%s", dir);
+}
+
+SDLibrary::~SDLibrary() {
+    if (data_ != NULL) {
+        heap_caps_free(data_);
+    }
+}
+
+bool SDLibrary::SDLibrary_IsImage(const char *name) {
+    static const char *exts[] = {".bmp", ".jpg", ".jpeg", ".png"};
+    size_t             n      = strlen(name);
+    if (!strcasecmp(name, "sys_decode.bmp")) {     /*旧版本解码时留下的中间文件*/
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+        size_t e = strlen(exts[i]);
+        if (n > e && !strcasecmp(name + n - e, exts[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t SDLibrary::SDLibrary_Fnv(const void *data, size_t len, uint32_t hash) {
+    const uint8_t *p = (const uint8_t *) data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+/*根目录中的图片排在最前,其余按路径排序,同一个一级子目录下的图片自然连续*/
+int SDLibrary::SDLibrary_ComparePath(const char *a, const char *b) {
+    bool ra = strchr(a, '/') == NULL;
+    bool rb = strchr(b, '/') == NULL;
+    if (ra != rb) {
+        return ra ? -1 : 1;
+    }
+    return strcmp(a, b);
+}
+
+int SDLibrary::SDLibrary_CompareName(const void *a, const void *b) {
+    return SDLibrary_ComparePath(*(const char *const *) a, *(const char *const *) b);
+}
+
+bool SDLibrary::SDLibrary_Load() {
+    char path[SD_LIBRARY_PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/%s", dir_, SD_LIBRARY_INDEX_NAME);
+    CustomSDPort::SDPort_Restore(path);
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    SDLibraryHeader_t header;
+    uint8_t          *data     = NULL;
+    size_t            size     = 0;
+    size_t            head     = 0;
+    long              file_len = 0;
+    uint64_t          body     = 0;
+    bool              ok       = false;
+    if (fread(&header, 1, sizeof(header), fp) != sizeof(header) || header.magic != SD_LIBRARY_MAGIC ||
+        header.version != SD_LIBRARY_VERSION || header.entrySize != sizeof(SDLibraryEntry_t) || header.poolSize == 0 ||
+        header.albumCount >= SD_LIBRARY_NO_ALBUM) {
+        ESP_LOGW(TAG, "index header mismatch:%s", path);
+        goto clean_up;
+    }
+    /*各段长度用64位计算并与文件长度比对,32位 size_t 上 count*sizeof 不会回绕*/
+    body = (uint64_t) header.count * sizeof(SDLibraryEntry_t) + (uint64_t) header.albumCount * sizeof(SDLibraryAlbum_t) + header.poolSize;
+    if (fseek(fp, 0, SEEK_END) != 0 || (file_len = ftell(fp)) < 0 || body != (uint64_t) file_len - sizeof(header) ||
+        fseek(fp, sizeof(header), SEEK_SET) != 0) {
+        ESP_LOGW(TAG, "index size mismatch:%s", path);
+        goto clean_up;
+    }
+    head = (size_t) header.count * sizeof(SDLibraryEntry_t) + (size_t) header.albumCount * sizeof(SDLibraryAlbum_t);
+    size = head + header.poolSize;
+    data = (uint8_t *) heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (data == NULL || fread(data, 1, size, fp) != size || data[size - 1] != 0) {
+        ESP_LOGW(TAG, "index read fill:%s", path);
+        goto clean_up;
+    }
+    for (uint32_t i = 0; i < header.count; i++) {
+        const SDLibraryEntry_t *e = &((SDLibraryEntry_t *) data)[i];
+        if (e->nameOffset >= header.poolSize || e->album >= header.albumCount) {
+            goto clean_up;
+        }
+    }
+    for (uint32_t i = 0; i < header.albumCount; i++) {
+        const SDLibraryAlbum_t *a = &((SDLibraryAlbum_t *) (data + (size_t) header.count * sizeof(SDLibraryEntry_t)))[i];
+        if (a->nameOffset >= header.poolSize || a->first > header.count || a->count > header.count - a->first) {
+            goto clean_up;
+        }
+    }
+    if (data_ != NULL) {
+        heap_caps_free(data_);
+    }
+    data_       = data;
+    data        = NULL;
+    entries_    = (SDLibraryEntry_t *) data_;
+    albums_     = (SDLibraryAlbum_t *) (data_ + (size_t) header.count * sizeof(SDLibraryEntry_t));
+    pool_       = (const char *) (data_ + head);
+    count_      = header.count;
+    albumCount_ = header.albumCount;
+    poolSize_   = header.poolSize;
+    dirSig_     = header.dirSig;
+    ok          = true;
+
+clean_up:
+    if (data != NULL) {
+        heap_caps_free(data);
+    }
+    fclose(fp);
+    return ok;
+}
+
+/*先写临时文件再改名,写到一半掉电时旧索引仍然有效*/
+bool SDLibrary::SDLibrary_Save() {
+    char path[SD_LIBRARY_PATH_MAX + 16];
+    char temp[SD_LIBRARY_PATH_MAX + 32];     /*path 再加 ".tmp"*/
+    snprintf(path, sizeof(path), "%s/%s", dir_, SD_LIBRARY_INDEX_NAME);
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *fp = fopen(temp, "wb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", temp);
+        return false;
+    }
+    SDLibraryHeader_t header = {SD_LIBRARY_MAGIC, SD_LIBRARY_VERSION, sizeof(SDLibraryEntry_t), count_, poolSize_, dirSig_, albumCount_};
+    size_t            size   = (size_t) count_ * sizeof(SDLibraryEntry_t) + (size_t) albumCount_ * sizeof(SDLibraryAlbum_t) + poolSize_;
+    bool              ok     = fwrite(&header, 1, sizeof(header), fp) == sizeof(header) && fwrite(data_, 1, size, fp) == size;
+    ok                       = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        ESP_LOGE(TAG, "index write fill");
+        remove(temp);
+        return false;
+    }
+    return CustomSDPort::SDPort_Replace(temp, path);
+}
+
+/*
+ * 递归读目录,把图片的相对路径('\0'分隔)追加到 scan->names,同时计算与顺序无关的签名
+ * rel 为当前目录的相对路径(根目录为空串),缓冲区长度为 SD_LIBRARY_PATH_MAX
+ * 隐藏目录和 "System Volume Information" 不扫描;完整路径超过 SD_LIBRARY_PATH_MAX 的文件跳过,不截断
+ */
+bool SDLibrary::SDLibrary_ScanDir(char *rel, size_t rel_len, int depth, SDLibraryScan_t *scan) {
+    char path[SD_LIBRARY_PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s%s%s", dir_, rel_len > 0 ? "/" : "", rel) >= (int) sizeof(path)) {
+        return depth > 0;
+    }
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", path);
+        return depth > 0;       /*子目录打不开时跳过,不影响其它图片*/
+    }
+    size_t         dir_len = strlen(dir_) + 1;
+    struct dirent *entry;
+    bool           ok      = true;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        size_t      len  = strlen(name);
+        if (name[0] == '.') {
+            continue;
+        }
+        if (dir_len + rel_len + (rel_len > 0 ? 1 : 0) + len + 1 > SD_LIBRARY_PATH_MAX) {
+            ESP_LOGW(TAG, "path too long, skipped:%s/%s", rel, name);
+            continue;
+        }
+        if (entry->d_type == DT_DIR) {
+            if (depth + 1 >= SD_LIBRARY_DEPTH_MAX || !strcasecmp(name, "System Volume Information")) {
+                continue;
+            }
+            size_t sub_len = rel_len;
+            if (sub_len > 0) {
+                rel[sub_len++] = '/';
+            }
+            memcpy(rel + sub_len, name, len + 1);
+            ok           = SDLibrary_ScanDir(rel, sub_len + len, depth + 1, scan);
+            rel[rel_len] = '\0';
+            continue;
+        }
+        if (!SDLibrary_IsImage(name)) {
+            continue;
+        }
+        size_t need = rel_len + (rel_len > 0 ? 1 : 0) + len + 1;
+        if (scan->size + need > scan->cap) {
+            size_t cap   = scan->cap * 2 > scan->size + need ? scan->cap * 2 : scan->size + need;
+            char  *grown = (char *) heap_caps_realloc(scan->names, cap, MALLOC_CAP_SPIRAM);
+            if (grown == NULL) {
+                ESP_LOGE(TAG, "scan buffer alloc fail");
+                ok = false;
+                break;
+            }
+            scan->names = grown;
+            scan->cap   = cap;
+        }
+        char *dst = scan->names + scan->size;
+        snprintf(dst, need, "%s%s%s", rel, rel_len > 0 ? "/" : "", name);
+        /*同名覆盖的文件路径不变,签名还要带上大小和修改时间*/
+        char        path[SD_LIBRARY_PATH_MAX];
+        struct stat st = {};
+        if (snprintf(path, sizeof(path), "%s/%s", dir_, dst) < (int) sizeof(path)) {
+            stat(path, &st);
+        }
+        uint32_t meta[2] = {(uint32_t) st.st_size, (uint32_t) st.st_mtime};
+        scan->size += need;
+        scan->sig  += SDLibrary_Fnv(meta, sizeof(meta), SDLibrary_Fnv(dst, need - 1));
+        scan->count++;
+    }
+    closedir(dir);
+    return ok;
+}
+
+/*读取文件头得到格式和尺寸,再读完整个文件计算哈希*/
+bool SDLibrary::SDLibrary_Probe(const char *name, SDLibraryEntry_t *entry) {
+    char path[SD_LIBRARY_PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", dir_, name) >= (int) sizeof(path)) {
+        return false;
+    }
+    FILE    *fp  = fopen(path, "rb");
+    uint8_t *buf = (uint8_t *) malloc(SD_LIBRARY_HASH_CHUNK);
+    if (fp == NULL || buf == NULL) {
+        ESP_LOGE(TAG, "Failed to open file: %s", path);
+        if (fp != NULL) {
+            fclose(fp);
+        }
+        free(buf);
+        return false;
+    }
+    uint32_t hash = 0x811C9DC5;
+    size_t   n;
+    bool     first = true;
+    while ((n = fread(buf, 1, SD_LIBRARY_HASH_CHUNK, fp)) > 0) {
+        if (first) {
+            const ImgDecoderEntry_t *dec = imgDecoderRegistry.ImgDecoderRegistry_Find(buf, n < IMG_SNIFF_BYTES ? n : IMG_SNIFF_BYTES);
+            if (dec != NULL) {
+                memcpy(entry->format, dec->name, strnlen(dec->name, sizeof(entry->format)));
+            }
+            first = false;
+        }
+        hash = SDLibrary_Fnv(buf, n, hash);
+    }
+    free(buf);
+    entry->hash = hash;
+    fseek(fp, 0, SEEK_SET);
+    ImgRowSource *src = imgDecoderRegistry.ImgDecoderRegistry_OpenFile(fp);
+    if (src != NULL) {
+        entry->width  = src->ImgSource_Width();
+        entry->height = src->ImgSource_Height();
+        delete src;
+    }
+    return true;
+}
+
+const SDLibraryEntry_t *SDLibrary::SDLibrary_Find(const char *name) {
+    uint32_t lo = 0;
+    uint32_t hi = count_;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        int      cmp = SDLibrary_ComparePath(pool_ + entries_[mid].nameOffset, name);
+        if (cmp == 0) {
+            return &entries_[mid];
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+/*相册名:第一个'/'之前的部分,根目录中的图片为空串*/
+static size_t SDLibrary_AlbumLen(const char *name) {
+    const char *slash = strchr(name, '/');
+    return slash != NULL ? (size_t) (slash - name) : 0;
+}
+
+bool SDLibrary::SDLibrary_Rebuild(SDLibraryScan_t *scan) {
+    uint32_t     count  = scan->count;
+    const char **sorted = (const char **) malloc((count > 0 ? count : 1) * sizeof(char *));
+    if (sorted == NULL) {
+        ESP_LOGE(TAG, "index alloc fail:%ld", (long) count);
+        return false;
+    }
+    for (uint32_t i = 0, off = 0; i < count; i++) {
+        sorted[i]  = scan->names + off;
+        off       += strlen(scan->names + off) + 1;
+    }
+    qsort(sorted, count, sizeof(char *), SDLibrary_CompareName);
+
+    /*先数出相册个数和相册名的长度,条目数组、相册数组、名字池一次申请*/
+    uint32_t albums    = 0;
+    uint32_t album_len = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        size_t len = SDLibrary_AlbumLen(sorted[i]);
+        if (i == 0 || len != SDLibrary_AlbumLen(sorted[i - 1]) || strncmp(sorted[i], sorted[i - 1], len)) {
+            albums++;
+            album_len += len + 1;
+        }
+    }
+    if (albums >= SD_LIBRARY_NO_ALBUM) {
+        ESP_LOGE(TAG, "too many albums:%ld", (long) albums);
+        free(sorted);
+        return false;
+    }
+    size_t   head = (size_t) count * sizeof(SDLibraryEntry_t) + (size_t) albums * sizeof(SDLibraryAlbum_t);
+    uint8_t *data = (uint8_t *) heap_caps_malloc(head + scan->size + album_len + 1, MALLOC_CAP_SPIRAM);
+    if (data == NULL) {
+        ESP_LOGE(TAG, "index alloc fail:%ld", (long) count);
+        free(sorted);
+        return false;
+    }
+
+    SDLibraryEntry_t *entries = (SDLibraryEntry_t *) data;
+    SDLibraryAlbum_t *album   = (SDLibraryAlbum_t *) (data + (size_t) count * sizeof(SDLibraryEntry_t));
+    char             *pool    = (char *) (data + head);
+    uint32_t          off     = 0;
+    uint32_t          probed  = 0;
+    int               cur     = -1;
+    pool[0]                   = 0;          /*没有图片时名字池只有一个'\0'*/
+    for (uint32_t i = 0; i < count; i++) {
+        char        path[SD_LIBRARY_PATH_MAX];
+        struct stat st = {};
+        size_t      len = strlen(sorted[i]) + 1;
+        if (snprintf(path, sizeof(path), "%s/%s", dir_, sorted[i]) < (int) sizeof(path)) {     /*扫描时已跳过过长的路径*/
+            stat(path, &st);
+        }
+        SDLibraryEntry_t       *e   = &entries[i];
+        const SDLibraryEntry_t *old = (entries_ != NULL) ? SDLibrary_Find(sorted[i]) : NULL;
+        if (old != NULL && old->size == (uint32_t) st.st_size && old->mtime == (uint32_t) st.st_mtime) {
+            *e = *old;
+        } else {
+            memset(e, 0, sizeof(*e));
+            e->size  = (uint32_t) st.st_size;
+            e->mtime = (uint32_t) st.st_mtime;
+            SDLibrary_Probe(sorted[i], e);
+            probed++;
+        }
+        e->nameOffset = off;
+        memcpy(pool + off, sorted[i], len);
+        off += len;
+
+        size_t alen = SDLibrary_AlbumLen(sorted[i]);
+        if (i == 0 || alen != SDLibrary_AlbumLen(sorted[i - 1]) || strncmp(sorted[i], sorted[i - 1], alen)) {
+            cur++;
+            album[cur].first = i;
+            album[cur].count = 0;
+        }
+        album[cur].count++;
+        e->album    = (uint16_t) cur;
+        e->reserved = 0;
+    }
+    for (uint32_t a = 0; a < albums; a++) {          /*相册名追加在图片路径之后*/
+        const char *name = pool + entries[album[a].first].nameOffset;
+        size_t      alen = SDLibrary_AlbumLen(name);
+        memcpy(pool + off, name, alen);
+        pool[off + alen]    = '\0';
+        album[a].nameOffset = off;
+        off                += alen + 1;
+    }
+    free(sorted);
+    if (data_ != NULL) {
+        heap_caps_free(data_);
+    }
+    data_       = data;
+    entries_    = entries;
+    albums_     = album;
+    pool_       = pool;
+    count_      = count;
+    albumCount_ = albums;
+    poolSize_   = off > 0 ? off : 1;
+    dirSig_     = scan->sig;
+    ESP_LOGI(TAG, "index rebuilt:%s entries:%ld albums:%ld probed:%ld", dir_, (long) count, (long) albums, (long) probed);
+    return SDLibrary_Save();
+}
+
+bool SDLibrary::SDLibrary_Open(bool validate) {
+    bool loaded = SDLibrary_Load();
+    if (loaded && !validate) {
+        return true;
+    }
+    char            rel[SD_LIBRARY_PATH_MAX] = "";
+    SDLibraryScan_t scan                     = {};
+    scan.cap                                 = 4 * 1024;
+    scan.names                               = (char *) heap_caps_malloc(scan.cap, MALLOC_CAP_SPIRAM);
+    if (scan.names == NULL || !SDLibrary_ScanDir(rel, 0, 0, &scan)) {
+        heap_caps_free(scan.names);
+        return loaded;
+    }
+    scan.sig += scan.count * 0x9E3779B1;
+    bool ok   = true;
+    if (!loaded || scan.sig != dirSig_ || scan.count != count_) {
+        ok = SDLibrary_Rebuild(&scan);
+    }
+    heap_caps_free(scan.names);
+    return ok || data_ != NULL;
+}
+
+const SDLibraryEntry_t *SDLibrary::SDLibrary_At(uint32_t idx) {
+    return (idx < count_) ? &entries_[idx] : NULL;
+}
+
+const char *SDLibrary::SDLibrary_Name(uint32_t idx) {
+    return (idx < count_) ? pool_ + entries_[idx].nameOffset : NULL;
+}
+
+int SDLibrary::SDLibrary_Path(uint32_t idx, char *buf, size_t len) {
+    if (idx >= count_) {
+        return -1;
+    }
+    int n = snprintf(buf, len, "%s/%s", dir_, pool_ + entries_[idx].nameOffset);
+    return (n > 0 && (size_t) n < len) ? n : -1;
+}
+
+const SDLibraryAlbum_t *SDLibrary::SDLibrary_Album(uint32_t album) {
+    return (album < albumCount_) ? &albums_[album] : NULL;
+}
+
+const char *SDLibrary::SDLibrary_AlbumName(uint32_t album) {
+    return (album < albumCount_) ? pool_ + albums_[album].nameOffset : NULL;
+}
+
+int SDLibrary::SDLibrary_FindAlbum(const char *name) {
+    for (uint32_t i = 0; i < albumCount_; i++) {
+        if (!strcmp(pool_ + albums_[i].nameOffset, name)) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SD_LIBRARY_INDEX_NAME "library.idx"
+#define SD_LIBRARY_MAGIC      0x58494C50     /*"PLIX"*/
+#define SD_LIBRARY_VERSION    3
+#define SD_LIBRARY_PATH_MAX   512            /*完整路径(UTF-8)的最大长度*/
+#define SD_LIBRARY_DEPTH_MAX  4              /*子目录最多递归的层数*/
+#define SD_LIBRARY_NO_ALBUM   0xFFFF
+
+/*索引文件:SDLibraryHeader_t + count 个 SDLibraryEntry_t + albumCount 个 SDLibraryAlbum_t + 名字池,整体一次读入*/
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t count;
+    uint32_t poolSize;
+    uint32_t dirSig;        /*所有图片路径、大小和修改时间的签名,用于快速校验*/
+    uint32_t albumCount;
+} SDLibraryHeader_t;
+
+typedef struct {
+    uint32_t nameOffset;    /*在名字池中的偏移,'\0'结尾,相对于图库目录的路径(UTF-8,不限长度)*/
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t hash;          /*文件内容的 FNV-1a*/
+    uint16_t width;         /*EXIF方向校正后的尺寸,无法解析时为0*/
+    uint16_t height;
+    char     format[4];     /*解码器名字("jpg"/"png"/"bmp"),不一定以'\0'结尾*/
+    uint16_t album;         /*所属相册下标*/
+    uint16_t reserved;
+} SDLibraryEntry_t;
+
+/*相册:图库目录下的一级子目录(其中的子目录也归入该相册),根目录中的图片为名字为空的相册*/
+typedef struct {
+    uint32_t nameOffset;
+    uint32_t first;         /*相册中的图片在条目数组中连续存放*/
+    uint32_t count;
+} SDLibraryAlbum_t;
+
+/*
+ * SD卡图库索引,代替每次唤醒都 readdir 建链表再用 list_at 顺序查找
+ * 索引有效时打开只需读一个文件,之后按下标 O(1) 访问;
+ * 校验读一遍目录项,按路径、大小和修改时间计算签名(只 stat、不打开文件),签名不同时增量重建:
+ * 路径、大小、修改时间都没变的条目直接沿用,只有新文件或改动过的文件才重新读取尺寸和计算哈希
+ * 条目先按相册(根目录在前)再按路径排序,所以每个相册是条目数组中连续的一段
+ */
+class SDLibrary
+{
+private:
+    const char       *TAG = "SDLibrary";
+    char              dir_[SD_LIBRARY_PATH_MAX];
+    uint8_t          *data_       = NULL;    /*条目数组 + 相册数组 + 名字池*/
+    SDLibraryEntry_t *entries_    = NULL;
+    SDLibraryAlbum_t *albums_     = NULL;
+    const char       *pool_       = NULL;
+    uint32_t          count_      = 0;
+    uint32_t          albumCount_ = 0;
+    uint32_t          poolSize_   = 0;
+    uint32_t          dirSig_     = 0;
+
+    typedef struct {
+        char    *names;
+        size_t   cap;
+        uint32_t size;
+        uint32_t count;
+        uint32_t sig;
+    } SDLibraryScan_t;
+
+    static bool     SDLibrary_IsImage(const char *name);
+    static uint32_t SDLibrary_Fnv(const void *data, size_t len, uint32_t hash = 0x811C9DC5);
+    static int      SDLibrary_ComparePath(const char *a, const char *b);
+    static int      SDLibrary_CompareName(const void *a, const void *b);
+    bool            SDLibrary_Load();
+    bool            SDLibrary_Save();
+    bool            SDLibrary_ScanDir(char *rel, size_t rel_len, int depth, SDLibraryScan_t *scan);
+    bool            SDLibrary_Probe(const char *name, SDLibraryEntry_t *entry);
+    const SDLibraryEntry_t *SDLibrary_Find(const char *name);
+    bool            SDLibrary_Rebuild(SDLibraryScan_t *scan);
+
+public:
+    SDLibrary(const char *dir);
+    ~SDLibrary();
+
+    /*validate 为false时只要索引文件存在就直接使用(如深度睡眠唤醒);为true时读一遍目录校验,有变化时增量重建*/
+    bool SDLibrary_Open(bool validate);
+    uint32_t SDLibrary_Count() { return count_; }
+    uint32_t SDLibrary_Signature() { return dirSig_; }
+    const SDLibraryEntry_t *SDLibrary_At(uint32_t idx);
+    const char *SDLibrary_Name(uint32_t idx);                     /*相对于图库目录的路径*/
+    int SDLibrary_Path(uint32_t idx, char *buf, size_t len);      /*完整路径,返回长度,失败返回-1*/
+
+    uint32_t SDLibrary_AlbumCount() { return albumCount_; }
+    const SDLibraryAlbum_t *SDLibrary_Album(uint32_t album);
+    const char *SDLibrary_AlbumName(uint32_t album);
+    int SDLibrary_FindAlbum(const char *name);                    /*不存在时返回-1*/
+};
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <esp_heap_caps.h>
+#include <esp_random.h>
+#include <esp_log.h>
+#include "ArduinoJson.h"
+#include "sd_playlist.h"
+
+SDPlaylist::SDPlaylist(SDLibrary *lib, SDPlaylistState_t *state) :
+lib_(lib),
+state_(state) {
+}
+
+bool SDPlaylist::SDPlaylist_LoadConfig(const char *path) {
+    order_       = SDPlaylistSequential;
+    album_[0]    = '\0';
+    weightCount_ = 0;
+    FILE *fp     = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    char  *buf = (char *) heap_caps_malloc(RENDER_CONFIG_FILE_MAX, MALLOC_CAP_SPIRAM);
+    size_t len = buf ? fread(buf, 1, RENDER_CONFIG_FILE_MAX, fp) : 0;
+    fclose(fp);
+    if (buf == NULL) {
+        return false;
+    }
+    JsonDocument         doc;
+    DeserializationError error = deserializeJson(doc, buf, len);
+    heap_caps_free(buf);
+    if (error) {
+        ESP_LOGE(TAG, "Parsing failed:%s", error.c_str());
+        return false;
+    }
+    JsonVariantConst playlist = doc["playlist"];
+    if (playlist.isNull()) {
+        return true;
+    }
+    const char *order = playlist["order"];
+    if (order != NULL) {
+        if (!strcmp(order, "shuffle")) {
+            order_ = SDPlaylistShuffle;
+        } else if (!strcmp(order, "weighted")) {
+            order_ = SDPlaylistWeighted;
+        }
+    }
+    const char *album = playlist["album"];
+    if (album != NULL) {
+        snprintf(album_, sizeof(album_), "%s", album);
+    }
+    for (JsonPairConst kv : playlist["weights"].as<JsonObjectConst>()) {
+        if (weightCount_ >= SD_PLAYLIST_WEIGHT_MAX) {
+            ESP_LOGW(TAG, "too many weights, max:%d", SD_PLAYLIST_WEIGHT_MAX);
+            break;
+        }
+        SDPlaylistWeight_t *w = &weights_[weightCount_++];
+        snprintf(w->name, sizeof(w->name), "%s", kv.key().c_str());
+        w->weight = kv.value().as<uint16_t>();
+    }
+    ESP_LOGI(TAG, "order:%d album:%s weights:%d", order_, album_, weightCount_);
+    return true;
+}
+
+/*murmur3 的 fmix32*/
+uint32_t SDPlaylist::SDPlaylist_Mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85EBCA6B;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35;
+    x ^= x >> 16;
+    return x;
+}
+
+/*把 [0,n) 中的 i 映射到 [0,n) 中的另一个数,同一个 seed 下是一一映射*/
+uint32_t SDPlaylist::SDPlaylist_Permute(uint32_t i, uint32_t n, uint32_t seed) {
+    int bits = 2;
+    while (bits < 32 && (1u << bits) < n) {
+        bits += 2;              /*左右两半位数相同*/
+    }
+    int      half = bits / 2;
+    uint32_t mask = (1u << half) - 1;
+    do {
+        uint32_t l = i >> half;
+        uint32_t r = i & mask;
+        for (uint32_t round = 0; round < 4; round++) {
+            uint32_t t = l ^ (SDPlaylist_Mix(r ^ seed ^ (round * 0x9E3779B9)) & mask);
+            l          = r;
+            r          = t;
+        }
+        i = (l << half) | r;
+    } while (i >= n);           /*域最多是 n 的4倍,平均不到4次*/
+    return i;
+}
+
+void SDPlaylist::SDPlaylist_Range(uint16_t *album, uint32_t *first, uint32_t *count) {
+    int idx = album_[0] ? lib_->SDLibrary_FindAlbum(album_) : -1;
+    if (idx < 0) {
+        if (album_[0]) {
+            ESP_LOGW(TAG, "album not found:%s", album_);
+        }
+        *album = SD_LIBRARY_NO_ALBUM;
+        *first = 0;
+        *count = lib_->SDLibrary_Count();
+        return;
+    }
+    const SDLibraryAlbum_t *a = lib_->SDLibrary_Album(idx);
+    *album                    = (uint16_t) idx;
+    *first                    = a->first;
+    *count                    = a->count;
+}
+
+uint32_t SDPlaylist::SDPlaylist_Weight(const char *album) {
+    for (int i = 0; i < weightCount_; i++) {
+        if (!strcmp(weights_[i].name, album)) {
+            return weights_[i].weight;
+        }
+    }
+    return 1;
+}
+
+/*先按权重选相册,再在相册中随机选一张;相册数量很少,与图片数量无关*/
+uint32_t SDPlaylist::SDPlaylist_PickWeighted(uint32_t first, uint32_t count) {
+    uint32_t rnd = SDPlaylist_Mix(state_->seed ^ SDPlaylist_Mix(state_->cursor));
+    if (state_->album == SD_LIBRARY_NO_ALBUM) {
+        uint32_t total = 0;
+        for (uint32_t a = 0; a < lib_->SDLibrary_AlbumCount(); a++) {
+            total += SDPlaylist_Weight(lib_->SDLibrary_AlbumName(a));
+        }
+        if (total > 0) {
+            uint32_t pick = rnd % total;
+            for (uint32_t a = 0; a < lib_->SDLibrary_AlbumCount(); a++) {
+                uint32_t w = SDPlaylist_Weight(lib_->SDLibrary_AlbumName(a));
+                if (pick < w) {
+                    first = lib_->SDLibrary_Album(a)->first;
+                    count = lib_->SDLibrary_Album(a)->count;
+                    break;
+                }
+                pick -= w;
+            }
+        }
+    }
+    uint32_t idx = first + SDPlaylist_Mix(rnd) % count;
+    if (idx == state_->last && count > 1) {
+        idx = first + (idx - first + 1) % count;
+    }
+    return idx;
+}
+
+int SDPlaylist::SDPlaylist_Next(char *path, size_t len) {
+    bool validated = false;
+    for (;;) {
+        /*一轮放完时重新校验图库,期间增删的图片从下一轮开始生效*/
+        if (!validated && state_->magic == SD_PLAYLIST_MAGIC && state_->cursor >= state_->count) {
+            lib_->SDLibrary_Open(true);
+            validated = true;
+        }
+        uint16_t album;
+        uint32_t first, count;
+        SDPlaylist_Range(&album, &first, &count);
+        if (count == 0) {
+            return -1;
+        }
+        if (state_->magic != SD_PLAYLIST_MAGIC || state_->order != order_ || state_->album != album ||
+            state_->count != count || state_->libSig != lib_->SDLibrary_Signature()) {
+            state_->magic  = SD_PLAYLIST_MAGIC;
+            state_->order  = order_;
+            state_->album  = album;
+            state_->cursor = 0;
+            state_->seed   = esp_random();
+            state_->count  = count;
+            state_->libSig = lib_->SDLibrary_Signature();
+            state_->last   = UINT32_MAX;
+        } else if (state_->cursor >= state_->count) {
+            state_->cursor = 0;
+            state_->seed   = SDPlaylist_Mix(state_->seed + 0x9E3779B9);
+        }
+        uint32_t idx;
+        switch (order_) {
+            case SDPlaylistShuffle:
+                idx = first + SDPlaylist_Permute(state_->cursor, count, state_->seed);
+                break;
+            case SDPlaylistWeighted:
+                idx = SDPlaylist_PickWeighted(first, count);
+                break;
+            default:
+                idx = first + state_->cursor;
+                break;
+        }
+        if (lib_->SDLibrary_Path(idx, path, len) < 0) {
+            ESP_LOGE(TAG, "path buffer too small:%ld", (long) idx);
+            return -1;
+        }
+        /*文件已被删除:重新校验图库,图库签名改变后从新的一轮开始*/
+        if (!validated && access(path, F_OK) != 0) {
+            lib_->SDLibrary_Open(true);
+            validated = true;
+            continue;
+        }
+        state_->cursor++;
+        state_->last = idx;
+        return (int) idx;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sd_library.h"
+#include "render_config.h"
+
+#define SD_PLAYLIST_MAGIC      0x504C5354     /*"PLST"*/
+#define SD_PLAYLIST_WEIGHT_MAX 16             /*config.txt 中可设置权重的相册数量*/
+#define SD_PLAYLIST_NAME_MAX   128
+
+enum SDPlaylistOrder {
+    SDPlaylistSequential = 0, /*按路径顺序*/
+    SDPlaylistShuffle,        /*随机且一轮内不重复*/
+    SDPlaylistWeighted,       /*按相册权重随机,不连续重复同一张*/
+};
+
+/*保存在 RTC 内存中的播放状态,深度睡眠唤醒后继续,不需要重新扫描或排序图库*/
+typedef struct {
+    uint32_t magic;
+    uint8_t  order;
+    uint8_t  reserved;
+    uint16_t album;     /*SD_LIBRARY_NO_ALBUM 为全部相册*/
+    uint32_t cursor;    /*本轮已播放的数量*/
+    uint32_t seed;      /*本轮排列的种子,每轮重新混合一次*/
+    uint32_t count;     /*本轮的图片数量*/
+    uint32_t libSig;    /*建立本轮时图库的签名,图库变化后重新开始*/
+    uint32_t last;      /*上一张的下标*/
+} SDPlaylistState_t;
+
+/*
+ * 图库播放列表:每次取下一张只做 O(1) 计算
+ * shuffle 用以种子为密钥的 Feistel 网络在 2 的幂大小的域上做置换,超出范围的值继续置换(cycle-walking),
+ * 第 cursor 张就是 cursor 的置换结果,不需要保存打乱后的数组
+ * 一轮放完或者文件已被删除时才重新校验图库
+ * config.txt 中的配置,例:
+ * "playlist": {"order": "shuffle", "album": "travel", "weights": {"travel": 3, "family": 1}}
+ */
+class SDPlaylist
+{
+private:
+    const char        *TAG = "SDPlaylist";
+    SDLibrary         *lib_;
+    SDPlaylistState_t *state_;
+    SDPlaylistOrder    order_ = SDPlaylistSequential;
+    char               album_[SD_PLAYLIST_NAME_MAX] = "";     /*空串为全部相册*/
+
+    typedef struct {
+        char     name[SD_PLAYLIST_NAME_MAX];
+        uint16_t weight;
+    } SDPlaylistWeight_t;
+
+    SDPlaylistWeight_t weights_[SD_PLAYLIST_WEIGHT_MAX];
+    int                weightCount_ = 0;
+
+    static uint32_t SDPlaylist_Mix(uint32_t x);
+    void            SDPlaylist_Range(uint16_t *album, uint32_t *first, uint32_t *count);
+    uint32_t        SDPlaylist_Weight(const char *album);
+    uint32_t        SDPlaylist_PickWeighted(uint32_t first, uint32_t count);
+
+public:
+    SDPlaylist(SDLibrary *lib, SDPlaylistState_t *state);
+
+    /*把 [0,n) 中的 i 映射到 [0,n) 中的另一个数,同一个 seed 下是一一映射*/
+    static uint32_t SDPlaylist_Permute(uint32_t i, uint32_t n, uint32_t seed);
+
+    bool SDPlaylist_LoadConfig(const char *path = RENDER_CONFIG_PATH);     /*没有 playlist 项时为顺序播放全部图片*/
+    /*取下一张图片的完整路径,返回其在图库中的下标,图库为空时返回-1*/
+    int SDPlaylist_Next(char *path, size_t len);
+};
@@ -4,38 +4,141 @@
 #include <dirent.h>
 #include <string.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include "ArduinoJson.h"
 #include "sdcard_bsp.h"
 
 CustomSDPort::CustomSDPort(const char *SdName,int clk,int cmd,int d0,int d1,int d2,int d3,int width) :
 SdName_(SdName)
 {
     ScanListHandle = list_new();
+    pins_[0]       = clk;
+    pins_[1]       = cmd;
+    pins_[2]       = d0;
+    pins_[3]       = d1;
+    pins_[4]       = d2;
+    pins_[5]       = d3;
+    bus_.width     = width;
+    is_SdcardInitOK = SDPort_Mount(&bus_) ? 1 : 0;
+}
 
+/*挂载后连续读几次扇区,总线速度超出卡或走线的能力时这里会出现 CRC 错误或超时*/
+esp_err_t CustomSDPort::SDPort_MountOnce(const SDPortBusConfig_t *cfg) {
     esp_vfs_fat_sdmmc_mount_config_t mount_config = {};
     mount_config.format_if_mount_failed           = false;
-    mount_config.max_files                        = 5;
-    mount_config.allocation_unit_size             = 16 * 1024 * 3;
+    mount_config.max_files                        = cfg->max_files;
+    mount_config.allocation_unit_size             = cfg->alloc_unit;
 
     sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-    host.max_freq_khz = SDMMC_FREQ_HIGHSPEED;
+    host.max_freq_khz = cfg->freq_khz;
+    if (!cfg->ddr) {
+        host.flags &= ~SDMMC_HOST_FLAG_DDR;
+    }
 
     sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
-    slot_config.width               = width;
-    slot_config.clk                 = (gpio_num_t)clk;
-    slot_config.cmd                 = (gpio_num_t)cmd;
-    slot_config.d0                  = (gpio_num_t)d0;
-    slot_config.d1                  = (gpio_num_t)d1;
-    slot_config.d2                  = (gpio_num_t)d2;
-    slot_config.d3                  = (gpio_num_t)d3;
+    slot_config.width               = cfg->width;
+    slot_config.clk                 = (gpio_num_t)pins_[0];
+    slot_config.cmd                 = (gpio_num_t)pins_[1];
+    slot_config.d0                  = (gpio_num_t)pins_[2];
+    slot_config.d1                  = (gpio_num_t)pins_[3];
+    slot_config.d2                  = (gpio_num_t)pins_[4];
+    slot_config.d3                  = (gpio_num_t)pins_[5];
+
+    esp_err_t ret = esp_vfs_fat_sdmmc_mount(SdName_, &host, &slot_config, &mount_config, &sdcard_host);
+    if (ret != ESP_OK) {
+        sdcard_host = NULL;
+        return ret;
+    }
+    uint8_t *probe = (uint8_t *) heap_caps_malloc(8 * 512, MALLOC_CAP_DMA);
+    if (probe != NULL) {
+        for (int i = 0; i < 4 && ret == ESP_OK; i++) {
+            ret = sdmmc_read_sectors(sdcard_host, probe, i * 8, 8);
+        }
+        heap_caps_free(probe);
+    }
+    if (ret != ESP_OK) {
+        esp_vfs_fat_sdcard_unmount(SdName_, sdcard_host);
+        sdcard_host = NULL;
+    }
+    return ret;
+}
 
-    ESP_ERROR_CHECK_WITHOUT_ABORT(esp_vfs_fat_sdmmc_mount(SdName_, &host, &slot_config, &mount_config, &sdcard_host));
+/*CRC错误或超时时依次关闭DDR、降到默认速度、改为1线,直到能稳定读写;没有卡等其它错误直接失败*/
+bool CustomSDPort::SDPort_Mount(SDPortBusConfig_t *cfg) {
+    for (;;) {
+        esp_err_t ret = SDPort_MountOnce(cfg);
+        if (ret == ESP_OK) {
+            sdmmc_card_print_info(stdout, sdcard_host);
+            ESP_LOGI(TAG, "bus:%d-bit %ldkHz ddr:%d", cfg->width, (long) cfg->freq_khz, (int) sdcard_host->is_ddr);
+            return true;
+        }
+        if (ret != ESP_ERR_INVALID_CRC && ret != ESP_ERR_TIMEOUT && ret != ESP_ERR_INVALID_RESPONSE) {
+            ESP_LOGE(TAG, "mount fail:%s", esp_err_to_name(ret));
+            return false;
+        }
+        if (cfg->ddr) {
+            cfg->ddr = false;
+        } else if (cfg->freq_khz > SDMMC_FREQ_DEFAULT) {
+            cfg->freq_khz = SDMMC_FREQ_DEFAULT;
+        } else if (cfg->width > 1) {
+            cfg->width = 1;
+        } else {
+            ESP_LOGE(TAG, "mount fail at lowest bus mode:%s", esp_err_to_name(ret));
+            return false;
+        }
+        ESP_LOGW(TAG, "%s, fall back to %d-bit %ldkHz ddr:%d", esp_err_to_name(ret), cfg->width, (long) cfg->freq_khz, cfg->ddr);
+    }
+}
 
-    if (sdcard_host != NULL) {
-        sdmmc_card_print_info(stdout, sdcard_host);
-        is_SdcardInitOK = 1;
-    } else {
-        is_SdcardInitOK = 0;
+bool CustomSDPort::SDPort_LoadBusConfig(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    char  *buf = (char *) heap_caps_malloc(SDPORT_CONFIG_FILE_MAX, MALLOC_CAP_SPIRAM);
+    size_t len = buf ? fread(buf, 1, SDPORT_CONFIG_FILE_MAX, fp) : 0;
+    fclose(fp);
+    if (buf == NULL) {
+        return false;
     }
+    JsonDocument         doc;
+    DeserializationError error = deserializeJson(doc, buf, len);
+    heap_caps_free(buf);
+    JsonVariantConst sdcard = doc["sdcard"];
+    if (error || sdcard.isNull()) {
+        return false;
+    }
+    SDPortBusConfig_t cfg = bus_;
+    cfg.width             = (sdcard["width"] | (int) cfg.width) == 1 ? 1 : 4;
+    cfg.freq_khz          = sdcard["freq_khz"] | cfg.freq_khz;
+    cfg.ddr               = sdcard["ddr"] | cfg.ddr;
+    cfg.max_files         = sdcard["max_files"] | (int) cfg.max_files;
+    cfg.alloc_unit        = sdcard["alloc_unit"] | cfg.alloc_unit;
+    cfg.read_buf          = sdcard["read_buf"] | cfg.read_buf;
+    cfg.write_buf         = sdcard["write_buf"] | cfg.write_buf;
+    if (cfg.read_buf < 512 || cfg.write_buf < 512 || cfg.max_files == 0) {
+        ESP_LOGE(TAG, "invalid sdcard config");
+        return false;
+    }
+    bool remount = cfg.width != bus_.width || cfg.freq_khz != bus_.freq_khz || cfg.ddr != bus_.ddr ||
+                   cfg.max_files != bus_.max_files || cfg.alloc_unit != bus_.alloc_unit;
+    if (remount && sdcard_host != NULL) {
+        esp_vfs_fat_sdcard_unmount(SdName_, sdcard_host);
+        sdcard_host = NULL;
+        if (!SDPort_Mount(&cfg)) {
+            /*新配置完全无法挂载时回到原来的总线配置*/
+            cfg.width       = bus_.width;
+            cfg.freq_khz    = bus_.freq_khz;
+            cfg.ddr         = bus_.ddr;
+            cfg.max_files   = bus_.max_files;
+            cfg.alloc_unit  = bus_.alloc_unit;
+            is_SdcardInitOK = SDPort_Mount(&cfg) ? 1 : 0;
+        }
+    }
+    bus_ = cfg;
+    return sdcard["benchmark"] | false;
 }
 
 CustomSDPort::~CustomSDPort() {
@@ -153,6 +256,303 @@ int CustomSDPort::SDPort_WriteOffset(const char *path, const void *data, size_t
     return bytes_written;
 }
 
+/*
+ * SDMMC 只能 DMA 内部内存,PSRAM 缓冲区会被驱动拆成一个个扇区经过它自己的小缓冲区
+ * 所以流式读写的缓冲区优先放在内部内存,内部内存不够时退回 PSRAM(仍然可用,只是慢)
+ */
+static uint8_t *SDPort_BufAlloc(size_t size) {
+    uint8_t *buf = (uint8_t *) heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (buf == NULL) {
+        ESP_LOGW("SDPort", "no internal DMA memory for %zu bytes, using PSRAM", size);
+        buf = (uint8_t *) heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    }
+    return buf;
+}
+
+SDPortWriter_t* CustomSDPort::SDPort_WriterOpen(const char *path) {
+    if (sdcard_host == NULL) {
+        ESP_LOGE(TAG, "SD card not initialized");
+        return NULL;
+    }
+
+    if (sdmmc_get_status(sdcard_host) != ESP_OK) {
+        ESP_LOGE(TAG, "SD card not ready");
+        return NULL;
+    }
+
+    size_t          path_len = strlen(path) + 1;
+    SDPortWriter_t *writer   = (SDPortWriter_t *) calloc(1, sizeof(SDPortWriter_t) + path_len * 2 + 4);
+    if (writer == NULL) {
+        ESP_LOGE(TAG, "writer alloc fail");
+        return NULL;
+    }
+    writer->path = (char *) (writer + 1);
+    writer->temp = writer->path + path_len;
+    memcpy(writer->path, path, path_len);
+    snprintf(writer->temp, path_len + 4, "%s.tmp", path);
+    SDPort_Restore(path);
+    writer->bufSize = bus_.write_buf;
+    writer->buf     = SDPort_BufAlloc(writer->bufSize);
+    writer->fp  = fopen(writer->temp, "wb");
+    if (writer->buf == NULL || writer->fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file for writing: %s", writer->temp);
+        SDPort_WriterAbort(writer);
+        return NULL;
+    }
+    setvbuf(writer->fp, NULL, _IONBF, 0);      /*已经按整簇缓冲,不再经过 stdio 的小缓冲区*/
+    return writer;
+}
+
+static bool SDPort_WriterFlush(SDPortWriter_t *writer) {
+    if (writer->fill > 0 && !writer->failed) {
+        writer->failed = fwrite(writer->buf, 1, writer->fill, writer->fp) != writer->fill;
+    }
+    writer->fill = 0;
+    return !writer->failed;
+}
+
+int CustomSDPort::SDPort_WriterWrite(SDPortWriter_t *writer, const void *data, size_t len) {
+    const uint8_t *src = (const uint8_t *) data;
+    size_t         n   = len;
+    while (n > 0 && !writer->failed) {
+        size_t chunk = writer->bufSize - writer->fill;
+        if (chunk > n) {
+            chunk = n;
+        }
+        memcpy(writer->buf + writer->fill, src, chunk);
+        writer->fill += chunk;
+        src          += chunk;
+        n            -= chunk;
+        if (writer->fill == writer->bufSize) {
+            SDPort_WriterFlush(writer);
+        }
+    }
+    if (writer->failed) {
+        ESP_LOGE(TAG, "Write failed: %s", writer->temp);
+        return ESP_FAIL;
+    }
+    writer->total += len;
+    return len;
+}
+
+/*path + ".bak",用完 free*/
+static char *SDPort_BakPath(const char *path) {
+    size_t len = strlen(path) + 5;
+    char  *bak = (char *) malloc(len);
+    if (bak != NULL) {
+        snprintf(bak, len, "%s.bak", path);
+    }
+    return bak;
+}
+
+/*
+ * FAT 上 rename 不会覆盖已存在的文件:先把旧文件改名为 .bak,再把 temp 改名为 path,最后删除 .bak
+ * 第二次改名失败时恢复 .bak 并保留 temp;任何时刻掉电,旧文件或新文件至少有一个完整留在卡上
+ */
+bool CustomSDPort::SDPort_Replace(const char *temp, const char *path) {
+    char *bak = SDPort_BakPath(path);
+    if (bak == NULL) {
+        return false;
+    }
+    remove(bak);
+    bool had = rename(path, bak) == 0;
+    if (!had && access(path, F_OK) == 0) {
+        free(bak);
+        return false;
+    }
+    bool ok = rename(temp, path) == 0;
+    if (!ok && had) {
+        rename(bak, path);
+    } else if (ok && had) {
+        remove(bak);
+    }
+    free(bak);
+    return ok;
+}
+
+/*上次替换时在两次改名之间掉电:path 不存在而 .bak 还在,把旧文件改回来*/
+void CustomSDPort::SDPort_Restore(const char *path) {
+    if (access(path, F_OK) == 0) {
+        return;
+    }
+    char *bak = SDPort_BakPath(path);
+    if (bak != NULL && access(bak, F_OK) == 0) {
+        rename(bak, path);
+    }
+    free(bak);
+}
+
+int CustomSDPort::SDPort_WriterCommit(SDPortWriter_t *writer) {
+    bool ok    = SDPort_WriterFlush(writer);
+    ok         = (fclose(writer->fp) == 0) && ok;
+    writer->fp = NULL;
+    if (!ok) {
+        ESP_LOGE(TAG, "commit fail: %s", writer->path);
+        SDPort_WriterAbort(writer);         /*旧文件没有动过,临时文件不完整*/
+        return ESP_FAIL;
+    }
+    if (!SDPort_Replace(writer->temp, writer->path)) {
+        ESP_LOGE(TAG, "replace fail, kept %s", writer->temp);
+        heap_caps_free(writer->buf);
+        free(writer);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "File written: %s, %zu bytes", writer->path, writer->total);
+    heap_caps_free(writer->buf);
+    free(writer);
+    return ESP_OK;
+}
+
+void CustomSDPort::SDPort_WriterAbort(SDPortWriter_t *writer) {
+    if (writer->fp != NULL) {
+        fclose(writer->fp);
+    }
+    remove(writer->temp);
+    heap_caps_free(writer->buf);
+    free(writer);
+}
+
+/*后台预读任务:拿到空闲缓冲区就读下一块,读到文件结束或 stop 时退出*/
+static void SDPort_ReaderTask(void *arg) {
+    SDPortReader_t *reader = (SDPortReader_t *) arg;
+    for (;;) {
+        SDPortReadBlock_t block = {};
+        xQueueReceive(reader->freeQ, &block.data, portMAX_DELAY);
+        if (reader->stop) {
+            break;
+        }
+        block.len = fread(block.data, 1, reader->bufSize, reader->fp);
+        xQueueSend(reader->fullQ, &block, portMAX_DELAY);
+        if (block.len == 0) {
+            break;
+        }
+    }
+    xSemaphoreGive(reader->done);
+    vTaskDelete(NULL);
+}
+
+SDPortReader_t* CustomSDPort::SDPort_ReaderOpen(const char *path, size_t buf_size, bool prefetch) {
+    if (sdcard_host == NULL) {
+        ESP_LOGE(TAG, "SD card not initialized");
+        return NULL;
+    }
+
+    if (sdmmc_get_status(sdcard_host) != ESP_OK) {
+        ESP_LOGE(TAG, "SD card not ready");
+        return NULL;
+    }
+
+    SDPortReader_t *reader = (SDPortReader_t *) calloc(1, sizeof(SDPortReader_t));
+    if (reader == NULL) {
+        ESP_LOGE(TAG, "reader alloc fail");
+        return NULL;
+    }
+    reader->bufSize  = buf_size > 0 ? buf_size : bus_.read_buf;
+    reader->prefetch = prefetch;
+    reader->fp       = fopen(path, "rb");
+    if (reader->fp == NULL) {
+        ESP_LOGE(TAG, "Failed to open file: %s", path);
+        free(reader);
+        return NULL;
+    }
+    setvbuf(reader->fp, NULL, _IONBF, 0);      /*整块读入自己的缓冲区,不再经过 stdio 的小缓冲区*/
+    for (int i = 0; i < (prefetch ? 2 : 1); i++) {
+        reader->buf[i] = SDPort_BufAlloc(reader->bufSize);
+        if (reader->buf[i] == NULL) {
+            ESP_LOGE(TAG, "reader buffer alloc fail:%zu", reader->bufSize);
+            SDPort_ReaderClose(reader);
+            return NULL;
+        }
+    }
+    if (prefetch) {
+        reader->freeQ = xQueueCreate(2, sizeof(uint8_t *));
+        reader->fullQ = xQueueCreate(3, sizeof(SDPortReadBlock_t));
+        reader->done  = xSemaphoreCreateBinary();
+        if (reader->freeQ == NULL || reader->fullQ == NULL || reader->done == NULL) {
+            ESP_LOGE(TAG, "reader queue create fail");
+            reader->prefetch = false;
+            SDPort_ReaderClose(reader);
+            return NULL;
+        }
+        xQueueSend(reader->freeQ, &reader->buf[0], 0);
+        xQueueSend(reader->freeQ, &reader->buf[1], 0);
+        if (xTaskCreate(SDPort_ReaderTask, "sd_prefetch", 3 * 1024, reader, 4, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "prefetch task create fail");
+            reader->prefetch = false;          /*任务没有启动,直接释放*/
+            SDPort_ReaderClose(reader);
+            return NULL;
+        }
+    }
+    return reader;
+}
+
+int CustomSDPort::SDPort_ReaderRead(SDPortReader_t *reader, void *data, size_t len) {
+    uint8_t *dst  = (uint8_t *) data;
+    size_t   done = 0;
+    while (done < len && !reader->eof) {
+        if (reader->pos == reader->cur.len) {
+            if (reader->prefetch) {
+                if (reader->cur.data != NULL) {
+                    xQueueSend(reader->freeQ, &reader->cur.data, portMAX_DELAY);
+                }
+                xQueueReceive(reader->fullQ, &reader->cur, portMAX_DELAY);
+            } else if (len - done >= reader->bufSize && esp_ptr_dma_capable(dst + done) && ((uintptr_t) (dst + done) & 3) == 0) {     /*调用者的缓冲区能 DMA 时整块直接读进去*/
+                size_t n  = fread(dst + done, 1, len - done, reader->fp);
+                done     += n;
+                reader->eof = (n == 0);
+                continue;
+            } else {
+                reader->cur.data = reader->buf[0];
+                reader->cur.len  = fread(reader->buf[0], 1, reader->bufSize, reader->fp);
+            }
+            reader->pos = 0;
+            if (reader->cur.len == 0) {
+                reader->eof = true;
+                break;
+            }
+        }
+        size_t n = reader->cur.len - reader->pos;
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(dst + done, reader->cur.data + reader->pos, n);
+        reader->pos += n;
+        done        += n;
+    }
+    if (reader->eof && done == 0 && ferror(reader->fp)) {
+        ESP_LOGE(TAG, "Read failed");
+        return -1;
+    }
+    return done;
+}
+
+void CustomSDPort::SDPort_ReaderClose(SDPortReader_t *reader) {
+    if (reader->prefetch) {
+        /*后台任务没有读到文件结束时还在等空闲缓冲区,唤醒它退出*/
+        reader->stop = true;
+        if (!reader->eof) {
+            uint8_t *none = NULL;
+            xQueueSend(reader->freeQ, &none, 0);
+        }
+        xSemaphoreTake(reader->done, portMAX_DELAY);
+    }
+    if (reader->freeQ != NULL) {
+        vQueueDelete(reader->freeQ);
+    }
+    if (reader->fullQ != NULL) {
+        vQueueDelete(reader->fullQ);
+    }
+    if (reader->done != NULL) {
+        vSemaphoreDelete(reader->done);
+    }
+    if (reader->fp != NULL) {
+        fclose(reader->fp);
+    }
+    heap_caps_free(reader->buf[0]);
+    heap_caps_free(reader->buf[1]);
+    free(reader);
+}
+
 sdmmc_card_t* CustomSDPort::SDPort_GetSdMMCHost() {
     return sdcard_host;
 }
@@ -189,14 +589,14 @@ void CustomSDPort::SDPort_ScanListDir(const char *path) {
             }
             if (strstr(entry->d_name, ".bmp") || strstr(entry->d_name, ".jpg") || strstr(entry->d_name, ".png") \
                 || strstr(entry->d_name, ".BMP") || strstr(entry->d_name, ".JPG") || strstr(entry->d_name, ".PNG")) {
-                uint16_t       Namestrlen   = strlen(path) + strlen(entry->d_name) + 1 + 1; 
-                if (Namestrlen >= 80) {
-                    ESP_LOGE(TAG, "scan file fill _strlen:%d", Namestrlen);
-                    continue;
-                }
                 CustomSDPortNode_t *node_data = (CustomSDPortNode_t *) LIST_MALLOC(sizeof(CustomSDPortNode_t));
                 assert(node_data);
-                snprintf(node_data->sdcard_name, sizeof(node_data->sdcard_name), "%s/%s", path, entry->d_name); 
+                int Namestrlen = snprintf(node_data->sdcard_name, sizeof(node_data->sdcard_name), "%s/%s", path, entry->d_name);
+                if (Namestrlen < 0 || Namestrlen >= (int) sizeof(node_data->sdcard_name)) {   /*路径放不下时跳过,不截断*/
+                    ESP_LOGE(TAG, "scan file fill _strlen:%d", Namestrlen + 1);
+                    LIST_FREE(node_data);
+                    continue;
+                }
                 list_rpush(ScanListHandle, list_node_new(node_data)); 
                 ESP_LOGW("Scan_Dir","DirDoc:%s,size:%d",node_data->sdcard_name,strlen(node_data->sdcard_name));
                 ImgValue++;
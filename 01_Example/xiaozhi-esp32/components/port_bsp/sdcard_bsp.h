@@ -3,6 +3,9 @@
 #include <esp_vfs_fat.h>
 #include <sdmmc_cmd.h>
 #include <driver/sdmmc_host.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include "list.h"
 
 
@@ -11,25 +14,106 @@ typedef struct
     char sdcard_name[80];  
 }CustomSDPortNode_t;
 
+#define SDPORT_WRITER_BUF_SIZE (64 * 1024)     /*512B~64KB 各种簇大小的整数倍,每次写入整簇*/
+
+/*流式写文件:一直打开同一个临时文件,数据攒满缓冲区再写,提交时改名为目标文件*/
+typedef struct
+{
+    FILE    *fp;
+    uint8_t *buf;
+    size_t   fill;
+    size_t   total;
+    bool     failed;
+    size_t   bufSize;
+    char    *path;
+    char    *temp;      /*path + ".tmp"*/
+}SDPortWriter_t;
+
+#define SDPORT_READER_BUF_SIZE (32 * 1024)     /*默认预读大小*/
+
+typedef struct
+{
+    uint8_t *data;
+    size_t   len;       /*0 表示文件已读完*/
+}SDPortReadBlock_t;
+
+/*SD卡总线和文件缓冲配置,可在 config.txt 的 "sdcard" 项中修改,例:
+ * "sdcard": {"width": 4, "freq_khz": 40000, "ddr": false, "max_files": 5, "alloc_unit": 49152,
+ *            "read_buf": 32768, "write_buf": 65536, "benchmark": false}
+ * benchmark 为 true 时每种总线配置在卡挂载成功后测一次存储性能,测试成功才记入 NVS*/
+typedef struct
+{
+    uint8_t  width;         /*1 或 4 线*/
+    uint32_t freq_khz;      /*20000 默认速度,40000 高速,50000 配合 ddr 为 DDR50*/
+    bool     ddr;           /*卡支持时使用 DDR 模式*/
+    uint8_t  max_files;     /*可同时打开的文件数*/
+    uint32_t alloc_unit;    /*格式化时的簇大小*/
+    uint32_t read_buf;      /*流式读的默认块大小*/
+    uint32_t write_buf;     /*流式写的缓冲区大小,应为簇大小的整数倍*/
+}SDPortBusConfig_t;
+
+#define SDPORT_CONFIG_FILE_MAX    4096
+#define SDPORT_BUS_CONFIG_DEFAULT {4, SDMMC_FREQ_HIGHSPEED, false, 5, 16 * 1024 * 3, SDPORT_READER_BUF_SIZE, SDPORT_WRITER_BUF_SIZE}
+
+/*
+ * 流式读文件:文件一直打开,每次从 SD 卡读一整块缓冲区,调用者从缓冲区中取数据
+ * prefetch 时有两块缓冲区,后台任务在调用者取当前块的同时读下一块
+ */
+typedef struct
+{
+    FILE             *fp;
+    uint8_t          *buf[2];
+    size_t            bufSize;
+    SDPortReadBlock_t cur;          /*正在读取的块*/
+    size_t            pos;          /*cur 中已取走的字节数*/
+    bool              eof;
+    bool              prefetch;
+    volatile bool     stop;
+    QueueHandle_t     freeQ;        /*空闲的缓冲区*/
+    QueueHandle_t     fullQ;        /*后台任务读好的 SDPortReadBlock_t*/
+    SemaphoreHandle_t done;         /*后台任务已退出*/
+}SDPortReader_t;
+
 class CustomSDPort
 {
 private:
     const char *TAG = "SDPort";
     const char *SdName_;
+    int pins_[6];                       /*clk cmd d0 d1 d2 d3,重新挂载时使用*/
+    SDPortBusConfig_t bus_ = SDPORT_BUS_CONFIG_DEFAULT;
     int is_SdcardInitOK = 0;
     sdmmc_card_t *sdcard_host = NULL;
     list_t *ScanListHandle = NULL;
 
     list_node_t *CurrentlyNode = NULL; 
     uint16_t ImgValue = 0;
+
+    esp_err_t SDPort_MountOnce(const SDPortBusConfig_t *cfg);
+    bool SDPort_Mount(SDPortBusConfig_t *cfg);
 public:
     CustomSDPort(const char *SdName,int clk = 39,int cmd = 41,int d0 = 40,int d1 = 1,int d2 = 2,int d3 = 38,int width = 4);
     ~CustomSDPort();
 
+    /*读取 config.txt 中的 "sdcard" 项,总线设置变化时重新挂载;返回是否要求运行存储性能测试*/
+    bool SDPort_LoadBusConfig(const char *path);
+    const SDPortBusConfig_t* SDPort_GetBusConfig() { return &bus_; }
+
     int SDPort_WriteFile(const char *path, const void *data, size_t data_len);
     int SDPort_ReadFile(const char *path, uint8_t *buffer, size_t *outLen);
     int SDPort_ReadOffset(const char *path, void *buffer, size_t len, size_t offset);
     int SDPort_WriteOffset(const char *path, const void *data, size_t len, bool append);
+    /*用 temp 替换 path,失败时 path 保持原样、temp 保留;Restore 找回替换中途掉电留下的 path.bak*/
+    static bool SDPort_Replace(const char *temp, const char *path);
+    static void SDPort_Restore(const char *path);
+    /*写入过程中目标文件保持不变;Commit 成功后才替换,写入失败或 Abort 时删除临时文件,两者都会释放 writer*/
+    SDPortWriter_t* SDPort_WriterOpen(const char *path);
+    int SDPort_WriterWrite(SDPortWriter_t *writer, const void *data, size_t len);
+    int SDPort_WriterCommit(SDPortWriter_t *writer);
+    void SDPort_WriterAbort(SDPortWriter_t *writer);
+    /*顺序读取,返回读到的字节数,文件结束返回0,出错返回-1*/
+    SDPortReader_t* SDPort_ReaderOpen(const char *path, size_t buf_size = 0, bool prefetch = false);     /*buf_size 为0时用 read_buf*/
+    int SDPort_ReaderRead(SDPortReader_t *reader, void *data, size_t len);
+    void SDPort_ReaderClose(SDPortReader_t *reader);
     sdmmc_card_t* SDPort_GetSdMMCHost();
     void SDPort_ScanListDir(const char *path);
     list_t* SDPort_GetListHost();
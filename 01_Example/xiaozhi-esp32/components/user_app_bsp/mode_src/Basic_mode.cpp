@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include <esp_heap_caps.h>
 #include <nvs_flash.h>
 #include <driver/rtc_io.h>
@@ -8,35 +9,97 @@
 #include "user_app.h"
 #include "button_bsp.h"
 #include "ai_app.h"
-#include "list.h"
+#include "sd_library.h"
+#include "sd_playlist.h"
+#include "sd_frame_store.h"
+#include "flash_frame_ring.h"
+#include "power_bsp.h"
 
 
 #define ext_wakeup_pin_1 GPIO_NUM_0 
 #define ext_wakeup_pin_2 GPIO_NUM_5 
 #define ext_wakeup_pin_3 GPIO_NUM_4 
 
-static RTC_DATA_ATTR uint32_t sdcard_Basic_count = 0; 
+#define BASIC_STAGE_AHEAD 4     /*每次读SD卡时预先放入 flash 的后续帧数,不超过 flash 槽数*/
+
+/*已放入 flash 的后续帧,以及显示它之后的播放状态*/
+typedef struct {
+    uint32_t          key;
+    SDPlaylistState_t state;
+} BasicStagedFrame_t;
+
+static RTC_DATA_ATTR SDPlaylistState_t basic_playlist_state = {};  /*播放顺序、本轮进度和种子,深度睡眠后保留*/
+static RTC_DATA_ATTR BasicStagedFrame_t basic_staged[BASIC_STAGE_AHEAD];
+static RTC_DATA_ATTR uint8_t basic_staged_count = 0;
+static RTC_DATA_ATTR uint8_t basic_staged_pos   = 0;
 static RTC_DATA_ATTR int basic_rtc_set_time = 13 * 60;// User sets the wake-up time in seconds. // The default is 60 seconds. It is awakened by a timer.
 static uint8_t           Basic_sleep_arg = 0; // Parameters for low-power tasks
 static SemaphoreHandle_t sleep_Semp;          // Binary call low-power task 
 static uint8_t           wakeup_basic_flag = 0;
-static list_t* ListHost;
+static SDLibrary        *Library;              /*06_user_foundation_img 的图库索引*/
+static SDPlaylist       *Playlist;
+static SDFrameStore     *FrameStore;            /*已抖动帧的缓存,命中时跳过解码和抖动*/
+static FlashFrameRing    FrameRing;              /*定时唤醒不挂载SD卡时从这里取帧*/
+static bool              FrameRingReady = false; /*分区表中没有 frames 分区时不预存*/
+
+
+static void basic_deep_sleep(void) {
+    const uint64_t ext_wakeup_pin_1_mask = 1ULL << ext_wakeup_pin_1;
+    const uint64_t ext_wakeup_pin_3_mask = 1ULL << ext_wakeup_pin_3;
+    ESP_ERROR_CHECK(esp_sleep_enable_ext1_wakeup_io(ext_wakeup_pin_1_mask | ext_wakeup_pin_3_mask, ESP_EXT1_WAKEUP_ANY_LOW)); 
+    ESP_ERROR_CHECK(rtc_gpio_pulldown_dis(ext_wakeup_pin_3));
+    ESP_ERROR_CHECK(rtc_gpio_pullup_en(ext_wakeup_pin_3));
+    esp_sleep_enable_timer_wakeup((uint64_t)basic_rtc_set_time * 1000000ULL);
+    //axp_basic_sleep_start();
+    vTaskDelay(pdMS_TO_TICKS(500));
+    esp_deep_sleep_start(); 
+}
 
+/*
+ * 预取播放列表中接下来的几张,SD卡帧缓存中有的放入 flash,没有的就停在那里(不为此解码)
+ * 播放状态取完后还原,每张记下显示它之后的状态,定时唤醒时直接接上
+ */
+static void basic_stage_upcoming(void) {
+    basic_staged_count = 0;
+    basic_staged_pos   = 0;
+    if (!FrameRingReady) {
+        return;
+    }
+    uint8_t *frame     = (uint8_t *) heap_caps_malloc(ePaperPort::Panel::FrameBytes, MALLOC_CAP_SPIRAM);
+    if (frame == NULL) {
+        return;
+    }
+    SDPlaylistState_t saved = basic_playlist_state;
+    uint32_t          keys[BASIC_STAGE_AHEAD];
+    char              path[SD_LIBRARY_PATH_MAX];
+    for (int i = 0; i < BASIC_STAGE_AHEAD; i++) {
+        int index = Playlist->SDPlaylist_Next(path, sizeof(path));
+        if (index < 0) {
+            break;
+        }
+        uint8_t rotation;
+        keys[i] = SDFrameStore::SDFrameStore_ImageKey(Library->SDLibrary_At(index)->hash, path);
+        if (!FrameRing.FlashFrameRing_Contains(keys[i])) {
+            if (!FrameStore->SDFrameStore_Get(keys[i], frame, ePaperPort::Panel::FrameBytes, &rotation) ||
+                !FrameRing.FlashFrameRing_Put(keys[i], frame, ePaperPort::Panel::FrameBytes, rotation, keys, i)) {
+                break;
+            }
+        }
+        basic_staged[i].key   = keys[i];
+        basic_staged[i].state = basic_playlist_state;
+        basic_staged_count    = i + 1;
+    }
+    basic_playlist_state = saved;
+    heap_caps_free(frame);
+    ESP_LOGI("stage", "%d frames staged in flash", basic_staged_count);
+}
 
 static void pwr_button_user_Task(void *arg) {
     for (;;) {
         EventBits_t even = xEventGroupWaitBits(PWRButtonGroups, set_bit_all, pdTRUE, pdFALSE, pdMS_TO_TICKS(2000));
         if (get_bit_button(even, 0))
         {
-            const uint64_t ext_wakeup_pin_1_mask = 1ULL << ext_wakeup_pin_1;
-            const uint64_t ext_wakeup_pin_3_mask = 1ULL << ext_wakeup_pin_3;
-            ESP_ERROR_CHECK(esp_sleep_enable_ext1_wakeup_io(ext_wakeup_pin_1_mask | ext_wakeup_pin_3_mask, ESP_EXT1_WAKEUP_ANY_LOW)); 
-            ESP_ERROR_CHECK(rtc_gpio_pulldown_dis(ext_wakeup_pin_3));
-            ESP_ERROR_CHECK(rtc_gpio_pullup_en(ext_wakeup_pin_3));
-            esp_sleep_enable_timer_wakeup((uint64_t)basic_rtc_set_time * 1000000ULL);
-            //axp_basic_sleep_start();
-            vTaskDelay(pdMS_TO_TICKS(500));
-            esp_deep_sleep_start(); 
+            basic_deep_sleep();
         }
     }
 }
@@ -49,19 +112,22 @@ static void boot_button_user_Task(void *arg) {
         if (get_bit_button(even, 0)) {
             if (*wakeup_arg == 0) {
                 if (pdTRUE == xSemaphoreTake(epaper_gui_semapHandle, 2000)) {                       
-                    list_node_t *sdcard_node = list_at(ListHost, sdcard_Basic_count); 
-                    if (sdcard_node == NULL) {
-                        sdcard_Basic_count = 0;
-                        sdcard_node        = list_at(ListHost, sdcard_Basic_count);
-                    }
-                    ESP_LOGW("node", "%ld", sdcard_Basic_count);
-                    sdcard_Basic_count++;
-                    if (sdcard_node != NULL) {
+                    char path[SD_LIBRARY_PATH_MAX];
+                    int  index = Playlist->SDPlaylist_Next(path, sizeof(path));
+                    ESP_LOGW("node", "%d", index);
+                    if (index >= 0) {
                         xEventGroupSetBits(Green_led_Mode_queue,set_bit_button(6));
                         Green_led_arg                   = 1;
-                        CustomSDPortNode_t *sdcard_Name_node = (CustomSDPortNode_t *) sdcard_node->val;
-                        ePaperDisplay.EPD_SDcardScaleIMGShakingColor(sdcard_Name_node->sdcard_name,0,0);
-                        ePaperDisplay.EPD_Display();
+                        uint32_t key = SDFrameStore::SDFrameStore_ImageKey(Library->SDLibrary_At(index)->hash, path);
+                        bool drawn = FrameStore->SDFrameStore_Show(ePaperDisplay, key);
+                        if (!drawn && ePaperDisplay.EPD_SDcardScaleIMGShakingColor(path,0,0)) {
+                            FrameStore->SDFrameStore_Save(ePaperDisplay, key);  /*EPD_Display 会释放显示缓冲区,先保存*/
+                            drawn = true;
+                        }
+                        if (drawn) {                                            /*解码失败时不刷新,也不缓存*/
+                            ePaperDisplay.EPD_Display();
+                        }
+                        basic_stage_upcoming();
                         xSemaphoreGive(epaper_gui_semapHandle); 
                         Green_led_arg = 0;
                         xSemaphoreGive(sleep_Semp);
@@ -78,15 +144,7 @@ static void default_sleep_user_Task(void *arg) {
     for (;;) {
         if (pdTRUE == xSemaphoreTake(sleep_Semp, portMAX_DELAY)) {
             if (*sleep_arg == 1) {
-                const uint64_t ext_wakeup_pin_1_mask = 1ULL << ext_wakeup_pin_1;
-                const uint64_t ext_wakeup_pin_3_mask = 1ULL << ext_wakeup_pin_3;
-                ESP_ERROR_CHECK(esp_sleep_enable_ext1_wakeup_io(ext_wakeup_pin_1_mask | ext_wakeup_pin_3_mask,ESP_EXT1_WAKEUP_ANY_LOW)); 
-                ESP_ERROR_CHECK(rtc_gpio_pulldown_dis(ext_wakeup_pin_3));
-                ESP_ERROR_CHECK(rtc_gpio_pullup_en(ext_wakeup_pin_3));
-                esp_sleep_enable_timer_wakeup((uint64_t)basic_rtc_set_time * 1000000ULL);
-                //axp_basic_sleep_start(); 
-                vTaskDelay(pdMS_TO_TICKS(500));
-                esp_deep_sleep_start();  
+                basic_deep_sleep();
             }
         }
     }
@@ -109,7 +167,6 @@ static void get_wakeup_gpio(void) {
 }
 
 void User_Basic_mode_app_init(void) {
-    ListHost = SDPort->SDPort_GetListHost();
     sleep_Semp  = xSemaphoreCreateBinary();
     BaseAIModel model(SDPort,decdither);
     xEventGroupSetBits(Red_led_Mode_queue, set_bit_button(0));  
@@ -119,11 +176,41 @@ void User_Basic_mode_app_init(void) {
         basic_rtc_set_time = AIModelConfig->time;
         ESP_LOGI("TIMER", "basic_rtc_set_time:%d", basic_rtc_set_time);
     }
-    SDPort->SDPort_ScanListDir("/sdcard/06_user_foundation_img"); 
-    ESP_LOGW("IMG","Values:%d",SDPort->Get_Sdcard_ImgValue());  
+    /*上电时校验索引,深度睡眠唤醒直接使用上次的索引*/
+    Library = new SDLibrary("/sdcard/06_user_foundation_img");
+    Library->SDLibrary_Open(esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED);
+    ESP_LOGW("IMG","Values:%ld",Library->SDLibrary_Count());  
+    Playlist = new SDPlaylist(Library, &basic_playlist_state);
+    Playlist->SDPlaylist_LoadConfig();
+    FrameStore = new SDFrameStore(SDPort);
+    FrameStore->SDFrameStore_Open();
+    FrameRingReady = FrameRing.FlashFrameRing_Open();
     xTaskCreate(boot_button_user_Task, "boot_button_user_Task", 6 * 1024, &wakeup_basic_flag, 3, NULL);
     xTaskCreate(pwr_button_user_Task, "pwr_button_user_Task", 4 * 1024, NULL, 3, NULL);
     xTaskCreate(default_sleep_user_Task, "default_sleep_user_Task", 4 * 1024, &Basic_sleep_arg, 3, NULL); 
     get_wakeup_gpio();
 }
 
+/*定时唤醒且下一张已在 flash 中时,只初始化电源和屏幕就显示并重新睡眠,不返回;否则返回0走正常流程*/
+uint8_t User_Basic_mode_flash_wake(void) {
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER || basic_staged_pos >= basic_staged_count) {
+        return 0;
+    }
+    const BasicStagedFrame_t *next = &basic_staged[basic_staged_pos];
+    if (!FrameRing.FlashFrameRing_Open() || !FrameRing.FlashFrameRing_Contains(next->key)) {
+        basic_staged_count = 0;
+        return 0;
+    }
+    Custom_PmicPortInit(&I2cBus, 0x34);
+    ePaperDisplay.EPD_Init();
+    if (!FrameRing.FlashFrameRing_Show(ePaperDisplay, next->key)) {
+        basic_staged_count = 0;
+        return 0;
+    }
+    ePaperDisplay.EPD_Display();
+    basic_playlist_state = next->state;
+    basic_staged_pos++;
+    ESP_LOGI("stage", "flash frame %d/%d shown", basic_staged_pos, basic_staged_count);
+    basic_deep_sleep();
+    return 1;
+}
@@ -86,6 +86,29 @@ static void Network_user_Task(void *arg) {
                 xEventGroupSetBits(sleep_group, set_bit_button(1));  
             }
         }
+        /*与上面的位可能同时置位,单独判断*/
+        ServerPortImage_t img;
+        if (get_bit_button(even, 7) && ServerPort_TakeImage(&img)) {
+            if (pdTRUE == xSemaphoreTake(epaper_gui_semapHandle, portMAX_DELAY)) {
+                xEventGroupSetBits(Green_led_Mode_queue, set_bit_button(6));
+                Green_led_arg = 1;
+                if (ePaperDisplay.EPD_MemoryIMGShakingColor(img.data, img.len, "imageUP")) {
+                    ePaperDisplay.EPD_Display();
+                }
+                xSemaphoreGive(epaper_gui_semapHandle);
+                Green_led_arg = 0;
+            }
+            heap_caps_free(img.data);
+        }
+        if (get_bit_button(even, 8)) {      /*/frameUP 已把整帧写进显示缓冲区*/
+            if (pdTRUE == xSemaphoreTake(epaper_gui_semapHandle, portMAX_DELAY)) {
+                xEventGroupSetBits(Green_led_Mode_queue, set_bit_button(6));
+                Green_led_arg = 1;
+                ePaperDisplay.EPD_Display();
+                xSemaphoreGive(epaper_gui_semapHandle);
+                Green_led_arg = 0;
+            }
+        }
     }
 }
 
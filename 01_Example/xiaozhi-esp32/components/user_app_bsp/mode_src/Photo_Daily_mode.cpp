@@ -452,6 +452,8 @@ static bool fetch_and_display_image(const char *url, const char *api_key)
         esp_http_client_set_header(client, "X-API-Key", api_key);
         ESP_LOGI(TAG, "API Key added to request header");
     }
+    // 服务器可以返回压缩格式(jpg/png),在设备上解码抖动,比已抖动的BMP小得多
+    esp_http_client_set_header(client, "Accept", "image/jpeg,image/png,image/bmp");
     
     esp_err_t err = esp_http_client_open(client, 0);
     if (err != ESP_OK) {
@@ -500,19 +502,26 @@ static bool fetch_and_display_image(const char *url, const char *api_key)
     
     ESP_LOGI(TAG, "Image downloaded successfully, displaying from memory...");
     
-    // 直接从内存显示到墨水屏 - 使用EPD_MemoryBmpShakingColor处理BMP数据
+    // 直接从内存显示到墨水屏 - BMP按已抖动的数据直接显示,其他格式解码、缩放、抖动后显示
+    bool drawn = true;
     if (pdTRUE == xSemaphoreTake(epaper_gui_semapHandle, portMAX_DELAY)) {
         ePaperDisplay.EPD_Init();
-        // BMP数据已经过抖动处理，直接从内存显示
-        ePaperDisplay.EPD_MemoryBmpShakingColor(image_buffer, total_len, 0, 0);
-        ePaperDisplay.EPD_Display();
+        if (total_len >= 2 && image_buffer[0] == 'B' && image_buffer[1] == 'M') {
+            drawn = ePaperDisplay.EPD_MemoryBmpShakingColor(image_buffer, total_len, 0, 0);
+        } else {
+            drawn = ePaperDisplay.EPD_MemoryIMGShakingColor(image_buffer, total_len, url);
+        }
+        if (drawn) {
+            ePaperDisplay.EPD_Display();
+            ESP_LOGI(TAG, "Image displayed on e-paper");
+        } else {
+            ESP_LOGE(TAG, "Image decode failed, keep the current picture");
+        }
         xSemaphoreGive(epaper_gui_semapHandle);
-        
-        ESP_LOGI(TAG, "Image displayed on e-paper");
     }
     
     heap_caps_free(image_buffer);
-    return true;
+    return drawn;
 }
 
 // 初始化SNTP时间同步
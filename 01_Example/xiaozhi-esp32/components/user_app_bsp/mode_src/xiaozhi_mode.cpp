@@ -166,8 +166,9 @@ static void gui_user_Task(void *arg) {
                     CustomSDPortNode_t *sdcard_Name_node = (CustomSDPortNode_t *) sdcard_node->val;
                     SDPort->SDPort_SetCurrentlyNode(sdcard_node);
                     ESP_LOGW(TAG,"voice_Sort:%d,list_Sort:%d,path:%s",(*sdcard_doc+1),*sdcard_doc,sdcard_Name_node->sdcard_name);
-                    ePaperDisplay.EPD_SDcardScaleIMGShakingColor(sdcard_Name_node->sdcard_name,0,0);
-                    ePaperDisplay.EPD_Display();
+                    if (ePaperDisplay.EPD_SDcardScaleIMGShakingColor(sdcard_Name_node->sdcard_name,0,0)) {
+                        ePaperDisplay.EPD_Display();
+                    }
                 }
             } else if (get_bit_button(even, 2)) {                     
                 ePaperDisplay.EPD_SDcardBmpShakingColor(AiModel->Get_AiTFImgName(),0,0);
@@ -179,8 +180,9 @@ static void gui_user_Task(void *arg) {
                     CustomSDPortNode_t *sdcard_Name_node_ai = (CustomSDPortNode_t *) node->val;
                     SDPort->SDPort_SetCurrentlyNode(node);
                     ESP_LOGW(TAG,"loop_Sort:%d,list_Sort:%d,path:%s",(img_loopCount+1),img_loopCount,sdcard_Name_node_ai->sdcard_name);
-                    ePaperDisplay.EPD_SDcardScaleIMGShakingColor(sdcard_Name_node_ai->sdcard_name,0,0);
-                    ePaperDisplay.EPD_Display();
+                    if (ePaperDisplay.EPD_SDcardScaleIMGShakingColor(sdcard_Name_node_ai->sdcard_name,0,0)) {
+                        ePaperDisplay.EPD_Display();
+                    }
                 }
                 if(img_loopCount == 0) {
                     img_loopCount = sdcard_bmp_Quantity;
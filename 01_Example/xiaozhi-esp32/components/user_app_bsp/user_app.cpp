@@ -9,10 +9,14 @@
 #include "power_bsp.h"
 #include "led_bsp.h"
 #include "imgdecode_app.h"
+#include "render_profiler.h"
+#include "render_config.h"
+#include "sd_benchmark.h"
 
 CustomSDPort *SDPort = NULL;
-ImgDecodeDither decdither;
-ePaperPort ePaperDisplay(decdither,11,10,8,9,12,13,800,480,1350,1350);
+RenderArena renderArena(ePaperPort::ArenaSize);
+ImgDecodeDither decdither(&renderArena);
+ePaperPort ePaperDisplay(decdither,renderArena,11,10,8,9,12,13,1350,1350);
 I2cMasterBus I2cBus(48,47,0);
 
 SemaphoreHandle_t  epaper_gui_semapHandle = NULL; // Mutual exclusion lock to prevent repeated refreshing
@@ -149,15 +153,60 @@ static void key1_button_user_Task(void *arg) {
     }
 }
 
+/*
+ * "benchmark": true 时每种总线配置只测一次:测试成功后把配置签名存进 NVS,之后的开机和唤醒都跳过,
+ * 改了总线配置才会再测;卡没有挂载或测试失败时不写签名,下次开机重试
+ */
+static uint32_t User_SDBenchmarkSig(const SDPortBusConfig_t *bus) {
+    uint32_t sig = 0x811C9DC5;
+    uint32_t fields[] = {bus->width, bus->freq_khz, bus->ddr, bus->max_files, bus->alloc_unit, bus->read_buf, bus->write_buf};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        sig = (sig ^ fields[i]) * 0x01000193;
+    }
+    return sig;
+}
+
+static bool User_SDBenchmarkPending(uint32_t sig) {
+    nvs_handle_t my_handle;
+    if (nvs_open("PhotoPainter", NVS_READONLY, &my_handle) != ESP_OK) {
+        return true;                /*命名空间还不存在,没有测过*/
+    }
+    uint32_t done = 0;
+    bool     run  = nvs_get_u32(my_handle, "SDBenchSig", &done) != ESP_OK || done != sig;
+    nvs_close(my_handle);
+    return run;
+}
+
+static void User_SDBenchmarkDone(uint32_t sig) {
+    nvs_handle_t my_handle;
+    if (nvs_open("PhotoPainter", NVS_READWRITE, &my_handle) == ESP_OK) {
+        nvs_set_u32(my_handle, "SDBenchSig", sig);
+        nvs_commit(my_handle);
+        nvs_close(my_handle);
+    }
+}
+
 uint8_t User_Mode_init(void) 
 {
     epaper_gui_semapHandle = xSemaphoreCreateMutex(); /* Acquire the mutual exclusion lock to prevent re-flashing */
+    renderProfiler.RenderProfiler_SetArena(&renderArena);
     Custom_PmicPortInit(&I2cBus,0x34);
     Led_init();                                       /* LED Blink Initialization */
     SDPort = new CustomSDPort("/sdcard");
     uint8_t sdcard_win = SDPort->SDPort_GetSdcardInitOK();              /* SD Card Initialization */
     if (sdcard_win == 0)
         return 0;
+    /*config.txt 中的 sdcard 项:总线模式和缓冲区大小,需要时测一次存储性能*/
+    bool benchmark = SDPort->SDPort_LoadBusConfig(RENDER_CONFIG_PATH);
+    if (SDPort->SDPort_GetSdcardInitOK() == 0)          /*新旧总线配置都无法重新挂载*/
+        return 0;
+    uint32_t bench_sig = User_SDBenchmarkSig(SDPort->SDPort_GetBusConfig());
+    if (benchmark && User_SDBenchmarkPending(bench_sig)) {
+        SDBenchmark bench(SDPort);
+        if (bench.SDBenchmark_Run() && bench.SDBenchmark_DumpToSdcard() > 0) {
+            User_SDBenchmarkDone(bench_sig);
+        }
+    }
     Green_led_Mode_queue = xEventGroupCreate();
     Red_led_Mode_queue   = xEventGroupCreate();
     epaper_groups        = xEventGroupCreate();
@@ -6,6 +6,7 @@
 #include "i2c_bsp.h"
 #include "imgdecode_app.h"
 
+extern RenderArena renderArena;
 extern ImgDecodeDither decdither;
 extern CustomSDPort *SDPort;
 extern ePaperPort ePaperDisplay;
@@ -34,6 +35,7 @@ extern EventGroupHandle_t ai_IMG_Group;
 extern SemaphoreHandle_t ai_img_while_semap;
 
 void User_Basic_mode_app_init(void);
+uint8_t User_Basic_mode_flash_wake(void);    // main.cc,在 User_Mode_init 之前调用
 void User_Network_mode_app_init(void);
 void User_PhotoDaily_mode_app_init(void);
 void Mode_Selection_Init(void);
@@ -0,0 +1,730 @@
+/*
+ * 主机端渲染流程性能测试
+ * 对 02_SDCARD/05_user_ai_img 下的每张图片分别计时: 解码、缩放、抖动、BMP编码、完整流程,
+ * JPG图片另外重新编码成每MCU行一个重启标记的版本,比较单线程和双核分割解码,
+ * (libjpeg 的平滑上采样会跨越分割处,所以两者只有分割处上下两行不同,分别记录校验和)
+ * 完整流程分别用双核流水线(pipeline)和顺序流程(pipeline_seq)各跑一次,两者的帧校验和应相同
+ * 另外单独测试旋转和中文字体绘制,并把各阶段输出的校验和与 golden_checksums.txt 比对
+ * /frameUP 的解包器用本文件里的小型 LZ4 块压缩器做往返校验,覆盖每一种分段大小和损坏的数据
+ * 内存BMP显示函数用构造的异常文件头检查是否在占用显示缓冲区之前拒绝
+ * 图库索引和播放列表在临时目录中建一个小图库,检查排序、相册范围、索引重新读入和每轮不重复
+ *
+ * render_bench [--sdcard DIR] [--images SUBDIR] [--iterations N] [--golden FILE] [--update-golden] [--verbose]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+#include <esp_log.h>
+#include "display_bsp.h"
+#include "render_profiler.h"
+#include "img_source.h"
+#include "frame_unpack.h"
+#include "sd_library.h"
+#include "sd_playlist.h"
+#include "host_mock.h"
+
+#define BENCH_EPD_MOSI 11
+#define BENCH_EPD_SCL  10
+#define BENCH_EPD_DC   8
+#define BENCH_EPD_CS   9
+#define BENCH_EPD_RST  12
+#define BENCH_EPD_BUSY 13
+#define BENCH_SCALE_MAX 1350
+
+typedef EpdActivePanel Panel;
+
+typedef struct {
+    std::string name;
+    double      best_ms = 0;
+    double      total_ms = 0;
+    uint64_t    bytes    = 0;
+    int         runs     = 0;
+} BenchStage_t;
+
+static std::vector<BenchStage_t>           stages;
+static std::map<std::string, std::string> checksums;
+static int                                 iterations = 3;
+static int                                 failures   = 0;
+
+/*FNV-1a 64位*/
+static uint64_t Bench_Fnv1a(const uint8_t *data, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static void Bench_Checksum(const std::string &key, const uint8_t *data, size_t len) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long) Bench_Fnv1a(data, len));
+    checksums[key] = buf;
+}
+
+/*执行 iterations 次,记录最好成绩和平均值*/
+template <typename Fn>
+static void Bench_Run(const std::string &name, uint64_t bytes, Fn fn) {
+    BenchStage_t st;
+    st.name  = name;
+    st.bytes = bytes;
+    for (int i = 0; i < iterations; i++) {
+        int64_t t0 = host_time_get_real_us();
+        fn(i);
+        double ms = (host_time_get_real_us() - t0) / 1000.0;
+        st.total_ms += ms;
+        st.best_ms = (i == 0 || ms < st.best_ms) ? ms : st.best_ms;
+        st.runs++;
+    }
+    stages.push_back(st);
+}
+
+static bool Bench_HasExt(const std::string &name, const char *ext) {
+    size_t n = strlen(ext);
+    return name.size() > n && strcasecmp(name.c_str() + name.size() - n, ext) == 0;
+}
+
+static std::vector<std::string> Bench_ListImages(const std::string &dir) {
+    std::vector<std::string> files;
+    DIR                     *d = opendir(dir.c_str());
+    if (d == NULL) {
+        return files;
+    }
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        std::string n = e->d_name;
+        if (Bench_HasExt(n, ".jpg") || Bench_HasExt(n, ".png") || Bench_HasExt(n, ".bmp")) {
+            files.push_back(n);
+        }
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+/*按文件内容选择解码器,返回RGB888*/
+static uint8_t *Bench_Decode(ImgDecodeDither &dither, const std::string &path, int *w, int *h) {
+    uint8_t *out = NULL;
+    *w = *h = 0;
+    if (dither.ImgDecode_TFOnePicture(path.c_str(), NULL, &out, w, h) != ESP_OK) {
+        return NULL;
+    }
+    return out;
+}
+
+static void Bench_Free(ImgDecodeDither &dither, const std::string &path, uint8_t *buf) {
+    dither.ImgDecode_PictureBufferFree(buf);
+}
+
+/*用 libjpeg 重新编码,每个MCU行插入一个重启标记(相机常用的 DRI 设置)*/
+static bool Bench_WriteRestartJpeg(const char *path, const uint8_t *rgb, int w, int h) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr       jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, fp);
+    cinfo.image_width      = w;
+    cinfo.image_height     = h;
+    cinfo.input_components = 3;
+    cinfo.in_color_space   = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 90, TRUE);
+    cinfo.restart_in_rows = 1;
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = (JSAMPROW) (rgb + (size_t) cinfo.next_scanline * w * 3);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(fp);
+    return true;
+}
+
+static void Bench_ParallelJpeg(ImgDecodeDither &dither, const std::string &name, const uint8_t *rgb, int w, int h) {
+    const char *path = "/sdcard/06_user_foundation_img/bench_restart.jpg";
+    if (!Bench_WriteRestartJpeg(path, rgb, w, h)) {
+        return;
+    }
+    uint8_t *single = NULL;
+    uint8_t *dual   = NULL;
+    int      dw, dh;
+    ImgSourceJpg_SetParallel(false);
+    Bench_Run(name + " rst_decode_1core", (uint64_t) w * h * 3, [&](int) {
+        dither.ImgDecode_PictureBufferFree(single);
+        dither.ImgDecode_TFOnePicture(path, NULL, &single, &dw, &dh);
+    });
+    ImgSourceJpg_SetParallel(true);
+    Bench_Run(name + " rst_decode_2core", (uint64_t) w * h * 3, [&](int) {
+        dither.ImgDecode_PictureBufferFree(dual);
+        dither.ImgDecode_TFOnePicture(path, NULL, &dual, &dw, &dh);
+    });
+    if (single != NULL && dual != NULL) {
+        Bench_Checksum(name + " rst_decode_1core", single, (size_t) w * h * 3);
+        Bench_Checksum(name + " rst_decode_2core", dual, (size_t) w * h * 3);
+    }
+    dither.ImgDecode_PictureBufferFree(single);
+    dither.ImgDecode_PictureBufferFree(dual);
+}
+
+static void Bench_Image(ImgDecodeDither &dither, ePaperPort &epd, const std::string &subdir, const std::string &name) {
+    std::string path = "/sdcard/" + subdir + "/" + name;
+    int         w, h;
+    uint8_t    *rgb = Bench_Decode(dither, path, &w, &h);
+    if (rgb == NULL) {
+        fprintf(stderr, "decode %s fail\n", path.c_str());
+        return;
+    }
+    Bench_Checksum(name + " decode", rgb, (size_t) w * h * 3);
+    if (Bench_HasExt(name, ".jpg")) {
+        Bench_ParallelJpeg(dither, name, rgb, w, h);
+    }
+    Bench_Free(dither, path, rgb);
+
+    Bench_Run(name + " decode", (uint64_t) w * h * 3, [&](int) {
+        int      dw, dh;
+        uint8_t *buf = Bench_Decode(dither, path, &dw, &dh);
+        Bench_Free(dither, path, buf);
+    });
+
+    /*与 EPD_SDcardScaleIMGShakingColor 相同的方向选择*/
+    bool portrait = (w < h);
+    int  ow       = portrait ? Panel::Height : Panel::Width;
+    int  oh       = portrait ? Panel::Width : Panel::Height;
+    size_t frameRgb = (size_t) ow * oh * 3;
+    uint8_t *src    = Bench_Decode(dither, path, &w, &h);
+    uint8_t *scaled = (uint8_t *) malloc(frameRgb);
+    uint8_t *dith   = (uint8_t *) malloc(frameRgb);
+
+    Bench_Run(name + " scale", frameRgb, [&](int) {
+        dither.ImgDecode_ScaleRgb888(src, w, h, scaled, ow, oh);
+    });
+    Bench_Checksum(name + " scale", scaled, frameRgb);
+    Bench_Free(dither, path, src);
+
+    Bench_Run(name + " dither", frameRgb, [&](int) {
+        dither.ImgDecode_DitherRgb888(scaled, dith, ow, oh);
+    });
+    Bench_Checksum(name + " dither", dith, frameRgb);
+
+    Bench_Run(name + " bmp_encode", frameRgb, [&](int) {
+        dither.ImgDecode_EncodingBmpToSdcard("/sdcard/06_user_foundation_img/bench_encode.bmp", dith, ow, oh);
+    });
+    free(scaled);
+    free(dith);
+
+    /*两种流程的校验和相同只有在流水线确实执行过时才有意义*/
+    uint32_t runs  = dither.ImgDecode_GetPipelineRuns();
+    bool     drawn = true;
+    Bench_Run(name + " pipeline", Panel::FrameBytes, [&](int i) {
+        drawn = epd.EPD_SDcardScaleIMGShakingColor(path.c_str(), 0, 0) && drawn;
+        if (i == 0) {
+            Bench_Checksum(name + " frame", epd.EPD_GetIMGBuffer(), Panel::FrameBytes);
+        }
+        epd.EPD_Display();
+    });
+    if (dither.ImgDecode_GetPipelineRuns() != runs + (uint32_t) iterations) {
+        printf("FAIL     %s pipeline ran %u/%d times\n", name.c_str(), (unsigned) (dither.ImgDecode_GetPipelineRuns() - runs), iterations);
+        failures++;
+    }
+    /*关闭双核流水线再跑一次完整流程,两种流程的输出必须一致*/
+    dither.ImgDecode_SetPipelined(false);
+    Bench_Run(name + " pipeline_seq", Panel::FrameBytes, [&](int i) {
+        drawn = epd.EPD_SDcardScaleIMGShakingColor(path.c_str(), 0, 0) && drawn;
+        if (i == 0) {
+            Bench_Checksum(name + " frame_seq", epd.EPD_GetIMGBuffer(), Panel::FrameBytes);
+        }
+        epd.EPD_Display();
+    });
+    dither.ImgDecode_SetPipelined(true);
+    if (!drawn) {
+        printf("FAIL     %s render returned false\n", name.c_str());
+        failures++;
+    }
+}
+
+static void Bench_Rotate() {
+    uint8_t *src = (uint8_t *) malloc(Panel::FrameBytes);
+    uint8_t *dst = (uint8_t *) malloc(Panel::FrameBytes);
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < Panel::FrameBytes; i++) {
+        seed   = seed * 1103515245 + 12345;
+        src[i] = (uint8_t) (seed >> 16);
+    }
+    Bench_Run("rotate180", Panel::FrameBytes, [&](int) { EpdPanel::Rotate180<Panel>(src, dst); });
+    Bench_Checksum("rotate180", dst, Panel::FrameBytes);
+    Bench_Run("rotate90ccw", Panel::FrameBytes, [&](int) { EpdPanel::Rotate90CCW<Panel>(src, dst); });
+    Bench_Checksum("rotate90ccw", dst, Panel::FrameBytes);
+    Bench_Run("rotate90cw", Panel::FrameBytes, [&](int) { EpdPanel::Rotate90CW<Panel>(src, dst); });
+    Bench_Checksum("rotate90cw", dst, Panel::FrameBytes);
+    free(src);
+    free(dst);
+}
+
+/*贪心的 LZ4 块压缩,遵守块格式的结尾规则(最后5字节为字面量,最后12字节内不开始匹配),out 至少 n + n / 255 + 16*/
+static size_t Bench_Lz4Compress(const uint8_t *src, size_t n, uint8_t *out) {
+    std::vector<int64_t> table(1 << 12, -1);
+    size_t               anchor = 0, ip = 0, op = 0;
+    auto                 putLen = [&](size_t len) {
+        for (; len >= 255; len -= 255) {
+            out[op++] = 255;
+        }
+        out[op++] = (uint8_t) len;
+    };
+    while (ip + 12 <= n) {
+        uint32_t seq;
+        memcpy(&seq, src + ip, 4);
+        uint32_t h   = (seq * 2654435761u) >> 20;
+        int64_t  ref = table[h];
+        table[h]     = ip;
+        if (ref < 0 || ip - ref > 65535 || memcmp(src + ref, src + ip, 4)) {
+            ip++;
+            continue;
+        }
+        size_t len = 4;
+        while (ip + len < n - 5 && src[ref + len] == src[ip + len]) {
+            len++;
+        }
+        size_t   lit   = ip - anchor;
+        size_t   ml    = len - 4;
+        uint8_t *token = &out[op++];
+        *token         = (uint8_t) (((lit >= 15 ? 15 : lit) << 4) | (ml >= 15 ? 15 : ml));
+        if (lit >= 15) {
+            putLen(lit - 15);
+        }
+        memcpy(out + op, src + anchor, lit);
+        op        += lit;
+        out[op++]  = (uint8_t) (ip - ref);
+        out[op++]  = (uint8_t) ((ip - ref) >> 8);
+        if (ml >= 15) {
+            putLen(ml - 15);
+        }
+        ip     += len;
+        anchor  = ip;
+    }
+    size_t lit = n - anchor;
+    out[op++]  = (uint8_t) ((lit >= 15 ? 15 : lit) << 4);
+    if (lit >= 15) {
+        putLen(lit - 15);
+    }
+    memcpy(out + op, src + anchor, lit);
+    return op + lit;
+}
+
+/*按 chunk 字节一段段送入解包器,全部送完且结果与原数据相同时返回true*/
+static bool Bench_Unpack(const uint8_t *packed, size_t plen, const uint8_t *expect, size_t len, FrameUpFormat format, size_t chunk,
+                         uint8_t *dst) {
+    memset(dst, 0xAA, len);
+    FrameUnpacker unpack(dst, len, format);
+    for (size_t off = 0; off < plen; off += chunk) {
+        if (!unpack.FrameUnpacker_Feed(packed + off, std::min(chunk, plen - off))) {
+            return false;
+        }
+    }
+    return unpack.FrameUnpacker_Done() && !memcmp(dst, expect, len);
+}
+
+static void Bench_UnpackFail(const char *what, size_t chunk) {
+    printf("FAIL     frame_unpack %s chunk %u\n", what, (unsigned) chunk);
+    failures++;
+}
+
+/*
+ * 小样本覆盖 1 到整个压缩流长度的每一种分段:长字面量(>15+255)、偏移1和3的重叠匹配、长匹配、远距离匹配
+ * 再用整帧测一次解压速度,raw 格式另外检查 Commit(数据已收在目标缓冲区里)
+ */
+static void Bench_FrameUnpack() {
+    std::vector<uint8_t> small;
+    uint32_t             seed = 0x9E3779B9;
+    auto                 rnd  = [&]() {
+        seed = seed * 1103515245 + 12345;
+        return (uint8_t) (seed >> 16);
+    };
+    for (int i = 0; i < 300; i++) {
+        small.push_back(rnd());
+    }
+    small.insert(small.end(), 600, 0x11);
+    for (int i = 0; i < 500; i++) {
+        small.push_back("\x12\x34\x56"[i % 3]);
+    }
+    small.insert(small.end(), small.begin(), small.begin() + 300);
+    for (int i = 0; i < 40; i++) {
+        small.push_back(rnd());
+    }
+    std::vector<uint8_t> packed(small.size() + small.size() / 255 + 16);
+    std::vector<uint8_t> dst(small.size());
+    size_t               plen = Bench_Lz4Compress(small.data(), small.size(), packed.data());
+    for (size_t chunk = 1; chunk <= plen; chunk++) {
+        if (!Bench_Unpack(packed.data(), plen, small.data(), small.size(), FrameUpLz4, chunk, dst.data())) {
+            Bench_UnpackFail("lz4", chunk);
+            break;
+        }
+    }
+    for (size_t chunk = 1; chunk <= small.size(); chunk++) {
+        if (!Bench_Unpack(small.data(), small.size(), small.data(), small.size(), FrameUpRaw, chunk, dst.data())) {
+            Bench_UnpackFail("raw", chunk);
+            break;
+        }
+        /*raw 直接收进目标缓冲区:只提交长度*/
+        memset(dst.data(), 0xAA, dst.size());
+        FrameUnpacker unpack(dst.data(), dst.size(), FrameUpRaw);
+        bool          ok = true;
+        for (size_t off = 0; off < small.size() && ok; off += chunk) {
+            size_t n = std::min(chunk, small.size() - off);
+            memcpy(dst.data() + unpack.FrameUnpacker_Out(), small.data() + off, n);
+            ok = unpack.FrameUnpacker_Commit(n);
+        }
+        if (!ok || !unpack.FrameUnpacker_Done() || memcmp(dst.data(), small.data(), small.size())) {
+            Bench_UnpackFail("raw commit", chunk);
+            break;
+        }
+    }
+
+    /*损坏的数据必须被拒绝:偏移0、偏移超出已输出数据、超出目标长度、流被截断、LZ4 上的 Commit*/
+    static const uint8_t zero_offset[] = {0x00, 0x00, 0x00};
+    static const uint8_t far_offset[]  = {0x10, 'a', 0x05, 0x00};
+    uint8_t              tiny[16];
+    FrameUnpacker        bad0(tiny, sizeof(tiny), FrameUpLz4);
+    FrameUnpacker        bad1(tiny, sizeof(tiny), FrameUpLz4);
+    FrameUnpacker        bad2(dst.data(), small.size() - 1, FrameUpLz4);
+    FrameUnpacker        bad3(dst.data(), small.size(), FrameUpLz4);
+    FrameUnpacker        bad4(tiny, sizeof(tiny), FrameUpRaw);
+    if (bad0.FrameUnpacker_Feed(zero_offset, sizeof(zero_offset))) {
+        Bench_UnpackFail("accepted offset 0", sizeof(zero_offset));
+    }
+    if (bad1.FrameUnpacker_Feed(far_offset, sizeof(far_offset))) {
+        Bench_UnpackFail("accepted offset past output", sizeof(far_offset));
+    }
+    if (bad2.FrameUnpacker_Feed(packed.data(), plen)) {
+        Bench_UnpackFail("accepted overrun", plen);
+    }
+    if (!bad3.FrameUnpacker_Feed(packed.data(), plen - 1) || bad3.FrameUnpacker_Done()) {
+        Bench_UnpackFail("truncated stream", plen - 1);
+    }
+    if (bad4.FrameUnpacker_Commit(sizeof(tiny) + 1) || bad3.FrameUnpacker_Commit(1)) {
+        Bench_UnpackFail("accepted commit", 1);
+    }
+
+    /*整帧:色块加一条噪声带,按一个 TCP 段左右的大小分段*/
+    std::vector<uint8_t> frame(Panel::FrameBytes);
+    for (size_t i = 0; i < frame.size(); i++) {
+        size_t x = i % Panel::BytesPerRow, y = i / Panel::BytesPerRow;
+        frame[i] = (y > 200 && y < 240) ? rnd() : (uint8_t) (((x / 37 + y / 23) % 6) * 0x11);
+    }
+    packed.resize(frame.size() + frame.size() / 255 + 16);
+    dst.resize(frame.size());
+    plen   = Bench_Lz4Compress(frame.data(), frame.size(), packed.data());
+    bool ok = true;
+    Bench_Run("unpack lz4", frame.size(), [&](int) {
+        ok = Bench_Unpack(packed.data(), plen, frame.data(), frame.size(), FrameUpLz4, 1436, dst.data()) && ok;
+    });
+    if (!ok) {
+        Bench_UnpackFail("lz4 frame", 1436);
+    }
+}
+
+/*网络/SD卡来的BMP文件头不可信:宽高异常、像素数据越界时必须在占用显示缓冲区之前拒绝*/
+static void Bench_HostileBmp(ePaperPort &epd) {
+    struct {
+        const char *what;
+        int32_t     width, height;
+        uint32_t    offset, len;
+    } cases[] = {
+        {"valid 4x2", 4, 2, 54, 54 + 12 * 2},
+        {"valid top-down", 4, -2, 54, 54 + 12 * 2},
+        {"zero width", 0, 2, 54, 54 + 64},
+        {"negative width", -4, 2, 54, 54 + 64},
+        {"INT32_MIN height", 4, INT32_MIN, 54, 54 + 64},
+        {"stride overflow", 0x55555556, 1, 54, 54 + 64},
+        {"height overflow", 4, 0x7FFFFFFF, 54, 54 + 64},
+        {"short data", 4, 2, 54, 54 + 12 * 2 - 1},
+        {"offset past end", 4, 2, 54 + 64, 54 + 64},
+        {"offset in header", 4, 2, 10, 54 + 64},
+    };
+    for (auto &c : cases) {
+        std::vector<uint8_t> bmp(c.len, 0xFF);
+        BMPFILEHEADER        fh = {};
+        BMPINFOHEADER        ih = {};
+        fh.bOffset              = c.offset;
+        ih.biInfoSize           = sizeof(ih);
+        ih.biWidth              = (uint32_t) c.width;
+        ih.biHeight             = (uint32_t) c.height;
+        ih.biPlanes             = 1;
+        ih.biBitCount           = 24;
+        memcpy(bmp.data(), &fh, sizeof(fh));
+        memcpy(bmp.data() + sizeof(fh), &ih, sizeof(ih));
+        bool expect = !strncmp(c.what, "valid", 5);
+        if (epd.EPD_MemoryBmpShakingColor(bmp.data(), bmp.size(), 0, 0) != expect) {
+            printf("FAIL     bmp header %s\n", c.what);
+            failures++;
+        }
+        epd.EPD_FrameDiscard();
+    }
+}
+
+static void Bench_LibraryFail(const char *what, uint32_t n) {
+    printf("FAIL     library %s %u\n", what, (unsigned) n);
+    failures++;
+}
+
+/*
+ * 置换:各种大小(含 1、2 的幂附近和超过 4096)下每轮恰好覆盖每个下标一次
+ * 图库:根目录图片在前,相册连续且按路径排序,非图片和隐藏目录不收录,保存的索引能原样读回,数量异常的索引被拒绝
+ * 播放列表:顺序播放按下标依次输出,shuffle 限定相册时每轮只出该相册且不重复
+ */
+static void Bench_Library() {
+    static const uint32_t sizes[] = {1, 2, 3, 5, 1000, 4097};
+    for (uint32_t n : sizes) {
+        for (uint32_t seed : {0u, 1u, 0x9E3779B9u, 0xFFFFFFFFu}) {
+            std::vector<uint8_t> hit(n, 0);
+            bool                 ok = true;
+            for (uint32_t i = 0; i < n && ok; i++) {
+                uint32_t p = SDPlaylist::SDPlaylist_Permute(i, n, seed);
+                ok         = p < n && hit[p]++ == 0;
+            }
+            if (!ok) {
+                Bench_LibraryFail("permute", n);
+                break;
+            }
+        }
+    }
+
+    static const char *files[] = {"b/2.jpg", "z.jpg", "b/sub/0.jpg", "a/x.jpg", "a.png", "b/1.bmp", "a/readme.txt", ".hidden/h.jpg"};
+    static const char *sorted[] = {"a.png", "z.jpg", "a/x.jpg", "b/1.bmp", "b/2.jpg", "b/sub/0.jpg"};
+    static const struct {
+        const char *name;
+        uint32_t    first, count;
+    } albums[] = {{"", 0, 2}, {"a", 2, 1}, {"b", 3, 3}};
+    const char *dir = "/sdcard/bench_library";
+    for (const char *f : files) {
+        FILE *fp = fopen((std::string(dir) + "/" + f).c_str(), "wb");
+        if (fp == NULL) {
+            Bench_LibraryFail("create", 0);
+            return;
+        }
+        fputs(f, fp);
+        fclose(fp);
+    }
+    SDLibrary lib(dir);
+    if (!lib.SDLibrary_Open(true) || lib.SDLibrary_Count() != 6 || lib.SDLibrary_AlbumCount() != 3) {
+        Bench_LibraryFail("open count", lib.SDLibrary_Count());
+        return;
+    }
+    for (uint32_t i = 0; i < 6; i++) {
+        if (strcmp(lib.SDLibrary_Name(i), sorted[i])) {
+            Bench_LibraryFail("sort", i);
+        }
+    }
+    for (uint32_t a = 0; a < 3; a++) {
+        const SDLibraryAlbum_t *al = lib.SDLibrary_Album(a);
+        if (strcmp(lib.SDLibrary_AlbumName(a), albums[a].name) || al->first != albums[a].first || al->count != albums[a].count ||
+            lib.SDLibrary_FindAlbum(albums[a].name) != (int) a) {
+            Bench_LibraryFail("album range", a);
+        }
+        for (uint32_t i = al->first; i < al->first + al->count; i++) {
+            if (lib.SDLibrary_At(i)->album != a) {
+                Bench_LibraryFail("entry album", i);
+            }
+        }
+    }
+    SDLibrary saved(dir);
+    if (!saved.SDLibrary_Open(false) || saved.SDLibrary_Count() != 6 || saved.SDLibrary_Signature() != lib.SDLibrary_Signature() ||
+        strcmp(saved.SDLibrary_Name(5), sorted[5])) {
+        Bench_LibraryFail("reload", saved.SDLibrary_Count());
+    }
+    /*文件头中的数量不可信:count*sizeof 在32位上回绕成小值时也必须按文件长度拒绝,然后重建*/
+    FILE *fp = fopen((std::string(dir) + "/" + SD_LIBRARY_INDEX_NAME).c_str(), "wb");
+    if (fp != NULL) {
+        SDLibraryHeader_t bad = {SD_LIBRARY_MAGIC, SD_LIBRARY_VERSION, sizeof(SDLibraryEntry_t), 0x0AAAAAAB, 1, 0, 1};
+        uint8_t           pad[64] = {};
+        fwrite(&bad, 1, sizeof(bad), fp);
+        fwrite(pad, 1, sizeof(pad), fp);
+        fclose(fp);
+    }
+    SDLibrary hostile(dir);
+    if (!hostile.SDLibrary_Open(false) || hostile.SDLibrary_Count() != 6) {
+        Bench_LibraryFail("hostile index", hostile.SDLibrary_Count());
+    }
+
+    const char *config = "/sdcard/bench_playlist.txt";
+    char        path[SD_LIBRARY_PATH_MAX];
+    for (const char *json : {"{}", "{\"playlist\": {\"order\": \"shuffle\", \"album\": \"b\"}}"}) {
+        FILE *fp = fopen(config, "wb");
+        if (fp == NULL) {
+            Bench_LibraryFail("config", 0);
+            return;
+        }
+        fputs(json, fp);
+        fclose(fp);
+        SDPlaylistState_t state = {};
+        SDPlaylist        list(&lib, &state);
+        list.SDPlaylist_LoadConfig(config);
+        bool     shuffle = strcmp(json, "{}") != 0;
+        uint32_t first   = shuffle ? 3 : 0;
+        uint32_t count   = shuffle ? 3 : 6;
+        for (int round = 0; round < 2; round++) {
+            std::vector<uint8_t> hit(count, 0);
+            for (uint32_t i = 0; i < count; i++) {
+                int idx = list.SDPlaylist_Next(path, sizeof(path));
+                if (idx < (int) first || idx >= (int) (first + count) || hit[idx - first]++ || (!shuffle && idx != (int) i)) {
+                    Bench_LibraryFail(shuffle ? "shuffle cycle" : "sequential", i);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/*把字库里的全部汉字依次排版绘制*/
+static void Bench_Font(ePaperPort &epd, cFONT *font, const char *name) {
+    std::string text;
+    for (int i = 0; i < font->size; i++) {
+        text.append(font->table[i].index, 3);
+    }
+    text += " 0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz";
+    epd.Set_Rotation(2);
+    Bench_Run(std::string("font ") + name, text.size(), [&](int i) {
+        epd.EPD_DispClear(ColorWhite);
+        epd.EPD_DrawStringCN(0, 0, text.c_str(), font, ColorBlack, ColorWhite);
+        if (i == 0) {
+            Bench_Checksum(std::string("font ") + name, epd.EPD_GetIMGBuffer(), Panel::FrameBytes);
+        }
+        epd.EPD_Display();
+    });
+}
+
+static std::map<std::string, std::string> Bench_LoadGolden(const char *path) {
+    std::map<std::string, std::string> golden;
+    FILE                              *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return golden;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char *sep = strrchr(line, ' ');
+        if (line[0] == '#' || sep == NULL) {
+            continue;
+        }
+        *sep = 0;
+        std::string value = sep + 1;
+        value.erase(value.find_last_not_of("\r\n") + 1);
+        golden[line] = value;
+    }
+    fclose(fp);
+    return golden;
+}
+
+static bool Bench_SaveGolden(const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        return false;
+    }
+    fprintf(fp, "# render_bench golden checksums (FNV-1a 64), regenerate with --update-golden\n");
+    for (auto &kv : checksums) {
+        fprintf(fp, "%s %s\n", kv.first.c_str(), kv.second.c_str());
+    }
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string sdcard = HOST_SDCARD_DIR;
+    std::string subdir = "05_user_ai_img";
+    std::string golden = HOST_GOLDEN_FILE;
+    bool        update = false;
+    host_log_level     = ESP_LOG_ERROR;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sdcard") && i + 1 < argc) {
+            sdcard = argv[++i];
+        } else if (!strcmp(argv[i], "--images") && i + 1 < argc) {
+            subdir = argv[++i];
+        } else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--golden") && i + 1 < argc) {
+            golden = argv[++i];
+        } else if (!strcmp(argv[i], "--update-golden")) {
+            update = true;
+        } else if (!strcmp(argv[i], "--verbose")) {
+            host_log_level = ESP_LOG_INFO;
+        } else {
+            fprintf(stderr, "usage: %s [--sdcard DIR] [--images SUBDIR] [--iterations N] [--golden FILE] [--update-golden] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /*写入的文件放到临时目录,不修改仓库里的 02_SDCARD*/
+    char overlay[] = "/tmp/render_bench_XXXXXX";
+    if (mkdtemp(overlay) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    host_vfs_set_root(sdcard.c_str(), overlay);
+    host_time_set_simulated(1);         /*vTaskDelay 不真正等待,面板刷新时间不计入*/
+
+    static RenderArena     arena(ePaperPort::ArenaSize);
+    static ImgDecodeDither dither(&arena);
+    static ePaperPort      epd(dither, arena, BENCH_EPD_MOSI, BENCH_EPD_SCL, BENCH_EPD_DC, BENCH_EPD_CS, BENCH_EPD_RST, BENCH_EPD_BUSY,
+                               BENCH_SCALE_MAX, BENCH_SCALE_MAX);
+    renderProfiler.RenderProfiler_SetArena(&arena);
+    epd.EPD_Init();
+
+    std::vector<std::string> images = Bench_ListImages(sdcard + "/" + subdir);
+    if (images.empty()) {
+        fprintf(stderr, "no images in %s/%s\n", sdcard.c_str(), subdir.c_str());
+        return 1;
+    }
+    for (auto &name : images) {
+        Bench_Image(dither, epd, subdir, name);
+    }
+    Bench_Rotate();
+    Bench_FrameUnpack();
+    Bench_HostileBmp(epd);
+    Bench_Library();
+    Bench_Font(epd, &Font14CN, "14CN");
+    Bench_Font(epd, &Font22CN, "22CN");
+
+    printf("%-28s %10s %10s %10s\n", "stage", "best ms", "avg ms", "MB/s");
+    for (auto &st : stages) {
+        double avg = st.total_ms / st.runs;
+        printf("%-28s %10.2f %10.2f %10.1f\n", st.name.c_str(), st.best_ms, avg, st.best_ms > 0 ? st.bytes / 1e3 / st.best_ms : 0.0);
+    }
+    printf("arena highwater: %u / %u bytes\n", (unsigned) arena.RenderArena_GetHighWater(), (unsigned) arena.RenderArena_GetCapacity());
+    printf("sdcard output: %s\n", overlay);
+
+    if (update) {
+        if (!Bench_SaveGolden(golden.c_str())) {
+            fprintf(stderr, "write %s fail\n", golden.c_str());
+            return 1;
+        }
+        printf("golden checksums written: %s (%u entries)\n", golden.c_str(), (unsigned) checksums.size());
+        return 0;
+    }
+    std::map<std::string, std::string> expect = Bench_LoadGolden(golden.c_str());
+    if (expect.empty()) {
+        printf("no golden checksums (%s), run with --update-golden\n", golden.c_str());
+        return 0;
+    }
+    int mismatch = 0;
+    for (auto &kv : checksums) {
+        auto it = expect.find(kv.first);
+        if (it == expect.end()) {
+            printf("NEW      %s %s\n", kv.first.c_str(), kv.second.c_str());
+        } else if (it->second != kv.second) {
+            printf("MISMATCH %s expect %s got %s\n", kv.first.c_str(), it->second.c_str(), kv.second.c_str());
+            mismatch++;
+        }
+    }
+    printf("checksums: %u checked, %d mismatch\n", (unsigned) checksums.size(), mismatch);
+    return (mismatch || failures) ? 1 : 0;
+}
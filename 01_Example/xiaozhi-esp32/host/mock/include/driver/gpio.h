@@ -0,0 +1,24 @@
+#pragma once
+/* host build: GPIO API subset, see mock_driver.c */
+#include <stdint.h>
+#include "esp_err.h"
+typedef int gpio_num_t;
+typedef enum { GPIO_INTR_DISABLE = 0 } gpio_int_type_t;
+typedef enum { GPIO_MODE_INPUT = 1, GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+typedef enum { GPIO_PULLDOWN_DISABLE = 0, GPIO_PULLDOWN_ENABLE } gpio_pulldown_t;
+typedef enum { GPIO_PULLUP_DISABLE = 0, GPIO_PULLUP_ENABLE } gpio_pullup_t;
+typedef struct { uint64_t pin_bit_mask; gpio_mode_t mode; gpio_pullup_t pull_up_en; gpio_pulldown_t pull_down_en; gpio_int_type_t intr_type; } gpio_config_t;
+#define GPIO_NUM_0  0
+#define GPIO_NUM_4  4
+#define GPIO_NUM_5  5
+#define GPIO_NUM_21 21
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t gpio_config(const gpio_config_t *c);
+esp_err_t gpio_set_level(gpio_num_t n, uint32_t l);
+int gpio_get_level(gpio_num_t n);
+esp_err_t gpio_reset_pin(gpio_num_t n);
+#ifdef __cplusplus
+}
+#endif
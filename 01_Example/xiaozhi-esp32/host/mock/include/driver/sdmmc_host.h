@@ -0,0 +1,35 @@
+#pragma once
+/* host build: driver/sdmmc_host.h subset */
+#include <stdint.h>
+#include "driver/gpio.h"
+
+#define SDMMC_FREQ_DEFAULT   20000
+#define SDMMC_FREQ_HIGHSPEED 40000
+#define SDMMC_FREQ_DDR50     50000
+
+#define SDMMC_HOST_FLAG_1BIT (1 << 0)
+#define SDMMC_HOST_FLAG_4BIT (1 << 1)
+#define SDMMC_HOST_FLAG_8BIT (1 << 2)
+#define SDMMC_HOST_FLAG_DDR  (1 << 4)
+
+typedef struct {
+    uint32_t flags;
+    int      slot;
+    int      max_freq_khz;
+} sdmmc_host_t;
+
+typedef struct {
+    gpio_num_t clk;
+    gpio_num_t cmd;
+    gpio_num_t d0;
+    gpio_num_t d1;
+    gpio_num_t d2;
+    gpio_num_t d3;
+    gpio_num_t cd;
+    gpio_num_t wp;
+    uint8_t    width;
+    uint32_t   flags;
+} sdmmc_slot_config_t;
+
+#define SDMMC_HOST_DEFAULT() {SDMMC_HOST_FLAG_8BIT | SDMMC_HOST_FLAG_4BIT | SDMMC_HOST_FLAG_1BIT | SDMMC_HOST_FLAG_DDR, 1, SDMMC_FREQ_DEFAULT}
+#define SDMMC_SLOT_CONFIG_DEFAULT() {-1, -1, -1, -1, -1, -1, -1, -1, 4, 0}
@@ -0,0 +1,21 @@
+#pragma once
+/* host build: SPI master API subset, see mock_driver.c */
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+typedef enum { SPI1_HOST = 0, SPI2_HOST, SPI3_HOST } spi_host_device_t;
+typedef struct spi_device_t *spi_device_handle_t;
+typedef struct { int mosi_io_num, miso_io_num, sclk_io_num, quadwp_io_num, quadhd_io_num; int max_transfer_sz; uint32_t flags; } spi_bus_config_t;
+typedef struct { uint8_t mode; int clock_speed_hz; int spics_io_num; uint32_t flags; int queue_size; } spi_device_interface_config_t;
+typedef struct { uint32_t flags; size_t length; size_t rxlength; void *user; const void *tx_buffer; void *rx_buffer; } spi_transaction_t;
+#define SPI_DEVICE_HALFDUPLEX (1 << 4)
+#define SPI_DMA_CH_AUTO 3
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t spi_bus_initialize(spi_host_device_t h, const spi_bus_config_t *c, int dma);
+esp_err_t spi_bus_add_device(spi_host_device_t h, const spi_device_interface_config_t *c, spi_device_handle_t *d);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t d, spi_transaction_t *t);
+#ifdef __cplusplus
+}
+#endif
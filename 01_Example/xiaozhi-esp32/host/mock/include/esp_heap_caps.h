@@ -0,0 +1,27 @@
+#pragma once
+/* host build: heap_caps_* on top of libc, PSRAM size is only reported */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#define HOST_PSRAM_SIZE (8u << 20)
+
+static inline void *heap_caps_malloc(size_t s, uint32_t c) { (void) c; return malloc(s); }
+static inline void *heap_caps_calloc(size_t n, size_t s, uint32_t c) { (void) c; return calloc(n, s); }
+static inline void *heap_caps_realloc(void *p, size_t s, uint32_t c) { (void) c; return realloc(p, s); }
+static inline void *heap_caps_aligned_alloc(size_t a, size_t s, uint32_t c) {
+    (void) c;
+    void *p = NULL;
+    if (posix_memalign(&p, a < sizeof(void *) ? sizeof(void *) : a, s)) return NULL;
+    return p;
+}
+static inline void   heap_caps_free(void *p) { free(p); }
+static inline size_t heap_caps_get_free_size(uint32_t c) { (void) c; return HOST_PSRAM_SIZE; }
+static inline size_t heap_caps_get_largest_free_block(uint32_t c) { (void) c; return HOST_PSRAM_SIZE; }
+static inline size_t heap_caps_get_total_size(uint32_t c) { (void) c; return HOST_PSRAM_SIZE; }
+static inline size_t heap_caps_get_minimum_free_size(uint32_t c) { (void) c; return HOST_PSRAM_SIZE; }
@@ -0,0 +1,40 @@
+#pragma once
+/* host build: subset of esp_new_jpeg esp_jpeg_common.h, implemented on libjpeg in mock_jpeg_dec.c */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef enum {
+    JPEG_ERR_OK            = 0,
+    JPEG_ERR_FAIL          = -1,
+    JPEG_ERR_NO_MEM        = -2,
+    JPEG_ERR_NO_MORE_DATA  = -3,
+    JPEG_ERR_INVALID_PARAM = -4,
+    JPEG_ERR_BAD_DATA      = -5,
+    JPEG_ERR_UNSUPPORT_FMT = -6,
+    JPEG_ERR_UNSUPPORT_STD = -7,
+} jpeg_error_t;
+
+typedef enum {
+    JPEG_PIXEL_FORMAT_GRAY      = 0,
+    JPEG_PIXEL_FORMAT_RGB888    = 1,
+    JPEG_PIXEL_FORMAT_RGB565_LE = 2,
+    JPEG_PIXEL_FORMAT_RGB565_BE = 3,
+    JPEG_PIXEL_FORMAT_CbYCrY    = 4,
+} jpeg_pixel_format_t;
+
+typedef enum {
+    JPEG_ROTATE_0D = 0,
+    JPEG_ROTATE_90D,
+    JPEG_ROTATE_180D,
+    JPEG_ROTATE_270D,
+} jpeg_rotate_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void *jpeg_calloc_align(size_t size, int aligned);
+void  jpeg_free_align(void *data);
+#ifdef __cplusplus
+}
+#endif
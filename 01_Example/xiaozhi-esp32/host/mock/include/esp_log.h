@@ -0,0 +1,24 @@
+#pragma once
+/* host build: ESP_LOGx -> stdout, level from host_log_level */
+#include <stdio.h>
+#include "esp_err.h"
+
+#define ESP_LOG_NONE    0
+#define ESP_LOG_ERROR   1
+#define ESP_LOG_WARN    2
+#define ESP_LOG_INFO    3
+#define ESP_LOG_DEBUG   4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int host_log_level;
+#ifdef __cplusplus
+}
+#endif
+
+#define HOST_LOG(lvl, c, tag, fmt, ...) do { if (host_log_level >= (lvl)) printf(c " %s: " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(ESP_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
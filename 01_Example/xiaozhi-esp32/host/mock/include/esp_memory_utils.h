@@ -0,0 +1,8 @@
+#pragma once
+/* host build: there is no DMA restriction, every buffer can be handed to the driver */
+#include <stdbool.h>
+
+static inline bool esp_ptr_dma_capable(const void *p) {
+    (void) p;
+    return true;
+}
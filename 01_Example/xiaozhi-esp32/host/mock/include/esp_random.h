@@ -0,0 +1,14 @@
+#pragma once
+/* host build: esp_random() from the C library generator, seeded once from the host clock */
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline uint32_t esp_random(void) {
+    static int seeded = 0;
+    if (!seeded) {
+        srand((unsigned) time(NULL));
+        seeded = 1;
+    }
+    return ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+}
@@ -0,0 +1,11 @@
+#pragma once
+/* host build: esp_timer_get_time() follows the host clock (see mock_freertos.c) */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int64_t esp_timer_get_time(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+/* host build: esp_vfs_fat / sdmmc mount subset, the card is always present (see mock_sdmmc.c) */
+#include <stdio.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdmmc_cmd.h"
+#include "driver/sdmmc_host.h"
+
+typedef struct {
+    bool     format_if_mount_failed;
+    int      max_files;
+    size_t   allocation_unit_size;
+    bool     disk_status_check_enable;
+} esp_vfs_fat_sdmmc_mount_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t esp_vfs_fat_sdmmc_mount(const char *base_path, const sdmmc_host_t *host, const void *slot_config,
+                                  const esp_vfs_fat_sdmmc_mount_config_t *mount_config, sdmmc_card_t **out_card);
+esp_err_t esp_vfs_fat_sdcard_unmount(const char *base_path, sdmmc_card_t *card);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+/* host build: FreeRTOS API subset, implemented on pthreads in mock_freertos.c */
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t EventBits_t;
+typedef void    *EventGroupHandle_t;
+typedef void    *SemaphoreHandle_t;
+typedef void    *QueueHandle_t;
+typedef void    *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdTRUE             1
+#define pdFALSE            0
+#define pdPASS             1
+#define pdFAIL             0
+#define portMAX_DELAY      0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(x)   ((TickType_t) (x))
+#define tskNO_AFFINITY     0x7fffffff
+#define BIT0               0x00000001
+#define BIT1               0x00000002
+#define BIT2               0x00000004
+#define BIT3               0x00000008
+
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void host_critical_enter(portMUX_TYPE *mux);
+void host_critical_exit(portMUX_TYPE *mux);
+#ifdef __cplusplus
+}
+#endif
+#define taskENTER_CRITICAL(m) host_critical_enter(m)
+#define taskEXIT_CRITICAL(m)  host_critical_exit(m)
+
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
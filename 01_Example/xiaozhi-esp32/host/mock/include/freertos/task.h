@@ -0,0 +1,15 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void       vTaskDelay(TickType_t ticks);
+void       vTaskDelete(TaskHandle_t task);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core);
+BaseType_t xPortGetCoreID(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+/*
+ * host build: control interface of the mock ESP-IDF layer
+ * (log level, simulated time, SD card path mapping, GPIO/SPI taps)
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int host_log_level;
+
+/*vTaskDelay 不真正休眠,只推进虚拟时间;esp_timer_get_time = 主机单调时钟 + 虚拟时间*/
+void    host_time_set_simulated(int enable);
+void    host_time_advance_us(int64_t us);
+int64_t host_time_get_real_us(void);      /*不含虚拟时间,用于性能测试*/
+
+/*
+ * "/sdcard/..." 路径映射:
+ * 读: 先找 overlay 目录,不存在再找 base 目录(通常是仓库里的 02_SDCARD,只读)
+ * 写: 一律写到 overlay 目录,自动创建上级目录
+ */
+void        host_vfs_set_root(const char *base_dir, const char *overlay_dir);
+const char *host_vfs_map(const char *path, int for_write, char *out, size_t out_len);
+
+/*GPIO:输出电平可读回,输入电平可由仿真器设置;level_hook 在每次 gpio_set_level 时调用*/
+typedef void (*host_gpio_hook_t)(int pin, int level, void *ctx);
+typedef int (*host_gpio_input_t)(int pin, void *ctx);
+void host_gpio_set_hook(host_gpio_hook_t hook, void *ctx);
+void host_gpio_set_input_source(host_gpio_input_t source, void *ctx);
+void host_gpio_set_input(int pin, int level);
+int  host_gpio_get_output(int pin);
+
+/*SPI:每次发送的数据都交给 tx_hook*/
+typedef void (*host_spi_hook_t)(const uint8_t *data, size_t len, void *ctx);
+void     host_spi_set_tx_hook(host_spi_hook_t hook, void *ctx);
+uint64_t host_spi_get_tx_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+/* host build: stand-in for components/pmicpower/power_bsp.h */
+#include <stdint.h>
+#include <stdbool.h>
+
+#define XPOWERS_ALDO4 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool enablePowerOutput(uint8_t channel);
+bool disablePowerOutput(uint8_t channel);
+#ifdef __cplusplus
+}
+#endif
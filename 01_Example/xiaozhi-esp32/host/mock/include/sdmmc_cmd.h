@@ -0,0 +1,22 @@
+#pragma once
+/* host build: sdmmc_cmd.h subset */
+#include <stdio.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct {
+    uint32_t max_freq_khz;
+    uint32_t capacity_sectors;
+    uint32_t sector_size;
+    uint32_t is_ddr;
+} sdmmc_card_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void      sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card);
+esp_err_t sdmmc_get_status(sdmmc_card_t *card);
+esp_err_t sdmmc_read_sectors(sdmmc_card_t *card, void *dst, size_t start_sector, size_t sector_count);
+#ifdef __cplusplus
+}
+#endif
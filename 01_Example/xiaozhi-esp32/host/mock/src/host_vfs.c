@@ -0,0 +1,205 @@
+/*
+ * host build: "/sdcard" mount point emulation
+ * 链接时用 -Wl,--wrap=... 截获文件接口,把 /sdcard 开头的路径映射到主机目录
+ */
+#include <stdio.h>
+#include <strings.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "host_mock.h"
+
+#define HOST_VFS_MOUNT "/sdcard"
+#define HOST_VFS_PATH_MAX 512
+
+FILE *__real_fopen(const char *path, const char *mode);
+DIR  *__real_opendir(const char *path);
+struct dirent *__real_readdir(DIR *dir);
+int   __real_closedir(DIR *dir);
+int   __real_stat(const char *path, struct stat *st);
+int   __real_mkdir(const char *path, mode_t mode);
+int   __real_rename(const char *from, const char *to);
+int   __real_remove(const char *path);
+int   __real_unlink(const char *path);
+int   __real_access(const char *path, int mode);
+
+static char s_base[HOST_VFS_PATH_MAX];
+static char s_overlay[HOST_VFS_PATH_MAX];
+
+/*同一目录在输出目录和SD卡目录中都存在时合并列出:先列输出目录,再列SD卡目录中输出目录没有的文件*/
+#define HOST_VFS_MERGED_MAX 8
+typedef struct {
+    DIR *primary;
+    DIR *secondary;
+    char overlay[HOST_VFS_PATH_MAX];
+} host_merged_dir_t;
+
+static host_merged_dir_t s_merged[HOST_VFS_MERGED_MAX];
+
+void host_vfs_set_root(const char *base_dir, const char *overlay_dir) {
+    snprintf(s_base, sizeof(s_base), "%s", base_dir ? base_dir : "");
+    snprintf(s_overlay, sizeof(s_overlay), "%s", overlay_dir ? overlay_dir : "");
+}
+
+static void make_parents(char *path) {
+    for (char *p = path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = 0;
+            __real_mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+}
+
+/*FAT 不区分大小写:逐级按忽略大小写的方式查找已存在的路径,找不到时保持原样*/
+static void resolve_nocase(char *path) {
+    struct stat st;
+    if (__real_stat(path, &st) == 0) {
+        return;
+    }
+    char *slash = strrchr(path, '/');
+    if (slash == NULL || slash == path) {
+        return;
+    }
+    *slash = 0;
+    resolve_nocase(path);
+    DIR *d = __real_opendir(path);
+    *slash = '/';
+    if (d == NULL) {
+        return;
+    }
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strcasecmp(e->d_name, slash + 1) == 0) {
+            memcpy(slash + 1, e->d_name, strlen(e->d_name));
+            break;
+        }
+    }
+    closedir(d);
+}
+
+const char *host_vfs_map(const char *path, int for_write, char *out, size_t out_len) {
+    size_t n = strlen(HOST_VFS_MOUNT);
+    if (path == NULL || strncmp(path, HOST_VFS_MOUNT, n) != 0 || (path[n] != '/' && path[n] != 0) || s_overlay[0] == 0) {
+        return path;
+    }
+    const char *rel = path + n;
+    snprintf(out, out_len, "%s%s", s_overlay, rel);
+    resolve_nocase(out);
+    if (for_write) {
+        make_parents(out);
+        return out;
+    }
+    struct stat st;
+    if (__real_stat(out, &st) == 0 || s_base[0] == 0) {
+        return out;
+    }
+    snprintf(out, out_len, "%s%s", s_base, rel);
+    resolve_nocase(out);
+    return out;
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode) {
+    char buf[HOST_VFS_PATH_MAX];
+    int  wr = strpbrk(mode, "wa+") != NULL;
+    return __real_fopen(host_vfs_map(path, wr, buf, sizeof(buf)), mode);
+}
+
+DIR *__wrap_opendir(const char *path) {
+    char        buf[HOST_VFS_PATH_MAX];
+    const char *mapped = host_vfs_map(path, 0, buf, sizeof(buf));
+    DIR        *dir    = __real_opendir(mapped);
+    size_t      n      = strlen(HOST_VFS_MOUNT);
+    if (dir == NULL || mapped == path || s_base[0] == 0 || strncmp(mapped, s_overlay, strlen(s_overlay)) != 0) {
+        return dir;
+    }
+    char base[HOST_VFS_PATH_MAX];
+    snprintf(base, sizeof(base), "%s%s", s_base, path + n);
+    resolve_nocase(base);
+    DIR *second = __real_opendir(base);
+    if (second == NULL) {
+        return dir;
+    }
+    for (int i = 0; i < HOST_VFS_MERGED_MAX; i++) {
+        if (s_merged[i].primary == NULL) {
+            s_merged[i].primary   = dir;
+            s_merged[i].secondary = second;
+            snprintf(s_merged[i].overlay, sizeof(s_merged[i].overlay), "%s", mapped);
+            return dir;
+        }
+    }
+    __real_closedir(second);
+    return dir;
+}
+
+static host_merged_dir_t *host_vfs_merged(DIR *dir) {
+    for (int i = 0; i < HOST_VFS_MERGED_MAX; i++) {
+        if (dir != NULL && s_merged[i].primary == dir) {
+            return &s_merged[i];
+        }
+    }
+    return NULL;
+}
+
+struct dirent *__wrap_readdir(DIR *dir) {
+    host_merged_dir_t *m = host_vfs_merged(dir);
+    if (m == NULL) {
+        return __real_readdir(dir);
+    }
+    struct dirent *e = __real_readdir(dir);
+    if (e != NULL) {
+        return e;
+    }
+    while ((e = __real_readdir(m->secondary)) != NULL) {
+        char        path[HOST_VFS_PATH_MAX * 2];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", m->overlay, e->d_name);
+        if (__real_stat(path, &st) != 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+int __wrap_closedir(DIR *dir) {
+    host_merged_dir_t *m = host_vfs_merged(dir);
+    if (m != NULL) {
+        __real_closedir(m->secondary);
+        m->primary   = NULL;
+        m->secondary = NULL;
+    }
+    return __real_closedir(dir);
+}
+
+int __wrap_stat(const char *path, struct stat *st) {
+    char buf[HOST_VFS_PATH_MAX];
+    return __real_stat(host_vfs_map(path, 0, buf, sizeof(buf)), st);
+}
+
+int __wrap_access(const char *path, int mode) {
+    char buf[HOST_VFS_PATH_MAX];
+    return __real_access(host_vfs_map(path, 0, buf, sizeof(buf)), mode);
+}
+
+int __wrap_mkdir(const char *path, mode_t mode) {
+    char buf[HOST_VFS_PATH_MAX];
+    return __real_mkdir(host_vfs_map(path, 1, buf, sizeof(buf)), mode);
+}
+
+int __wrap_rename(const char *from, const char *to) {
+    char a[HOST_VFS_PATH_MAX];
+    char b[HOST_VFS_PATH_MAX];
+    return __real_rename(host_vfs_map(from, 1, a, sizeof(a)), host_vfs_map(to, 1, b, sizeof(b)));
+}
+
+int __wrap_remove(const char *path) {
+    char buf[HOST_VFS_PATH_MAX];
+    return __real_remove(host_vfs_map(path, 1, buf, sizeof(buf)));
+}
+
+int __wrap_unlink(const char *path) {
+    char buf[HOST_VFS_PATH_MAX];
+    return __real_unlink(host_vfs_map(path, 1, buf, sizeof(buf)));
+}
@@ -0,0 +1,132 @@
+/* host build: GPIO / SPI master / PMIC stand-ins with taps for the panel simulator */
+#include <string.h>
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "power_bsp.h"
+#include "host_mock.h"
+
+#define HOST_GPIO_MAX 64
+
+int host_log_level = 2;
+
+static int               s_out[HOST_GPIO_MAX];
+static int               s_in[HOST_GPIO_MAX];
+static int               s_in_init     = 0;
+static host_gpio_hook_t  s_gpio_hook   = NULL;
+static void             *s_gpio_ctx    = NULL;
+static host_gpio_input_t s_input_src   = NULL;
+static void             *s_input_ctx   = NULL;
+static host_spi_hook_t   s_spi_hook    = NULL;
+static void             *s_spi_ctx     = NULL;
+static uint64_t          s_spi_bytes   = 0;
+
+struct spi_device_t {
+    int host;
+};
+static struct spi_device_t s_spi_dev;
+
+static void gpio_defaults(void) {
+    if (!s_in_init) {
+        for (int i = 0; i < HOST_GPIO_MAX; i++) {
+            s_in[i] = 1;        /*上拉,BUSY 空闲为高*/
+        }
+        s_in_init = 1;
+    }
+}
+
+void host_gpio_set_hook(host_gpio_hook_t hook, void *ctx) {
+    s_gpio_hook = hook;
+    s_gpio_ctx  = ctx;
+}
+
+void host_gpio_set_input_source(host_gpio_input_t source, void *ctx) {
+    s_input_src = source;
+    s_input_ctx = ctx;
+}
+
+void host_gpio_set_input(int pin, int level) {
+    gpio_defaults();
+    if (pin >= 0 && pin < HOST_GPIO_MAX) {
+        s_in[pin] = level;
+    }
+}
+
+int host_gpio_get_output(int pin) {
+    return (pin >= 0 && pin < HOST_GPIO_MAX) ? s_out[pin] : 0;
+}
+
+void host_spi_set_tx_hook(host_spi_hook_t hook, void *ctx) {
+    s_spi_hook = hook;
+    s_spi_ctx  = ctx;
+}
+
+uint64_t host_spi_get_tx_bytes(void) {
+    return s_spi_bytes;
+}
+
+esp_err_t gpio_config(const gpio_config_t *c) {
+    (void) c;
+    gpio_defaults();
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t n, uint32_t l) {
+    if (n < 0 || n >= HOST_GPIO_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_out[n] = l ? 1 : 0;
+    if (s_gpio_hook) {
+        s_gpio_hook(n, s_out[n], s_gpio_ctx);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t n) {
+    gpio_defaults();
+    if (n < 0 || n >= HOST_GPIO_MAX) {
+        return 0;
+    }
+    if (s_input_src) {
+        return s_input_src(n, s_input_ctx);
+    }
+    return s_in[n];
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t n) {
+    (void) n;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t h, const spi_bus_config_t *c, int dma) {
+    (void) h;
+    (void) c;
+    (void) dma;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t h, const spi_device_interface_config_t *c, spi_device_handle_t *d) {
+    (void) c;
+    s_spi_dev.host = h;
+    *d             = &s_spi_dev;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t d, spi_transaction_t *t) {
+    (void) d;
+    size_t len = t->length / 8;
+    s_spi_bytes += len;
+    if (s_spi_hook && len) {
+        s_spi_hook((const uint8_t *) t->tx_buffer, len, s_spi_ctx);
+    }
+    return ESP_OK;
+}
+
+bool enablePowerOutput(uint8_t channel) {
+    (void) channel;
+    return true;
+}
+
+bool disablePowerOutput(uint8_t channel) {
+    (void) channel;
+    return true;
+}
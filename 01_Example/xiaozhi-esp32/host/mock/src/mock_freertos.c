@@ -0,0 +1,315 @@
+/* host build: FreeRTOS / esp_timer subset on pthreads */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "host_mock.h"
+
+static int             s_sim_time   = 0;
+static int64_t         s_virtual_us = 0;
+static pthread_mutex_t s_crit       = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void host_time_set_simulated(int enable) {
+    s_sim_time = enable;
+}
+
+void host_time_advance_us(int64_t us) {
+    __atomic_add_fetch(&s_virtual_us, us, __ATOMIC_RELAXED);
+}
+
+int64_t host_time_get_real_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t) t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+int64_t esp_timer_get_time(void) {
+    return host_time_get_real_us() + __atomic_load_n(&s_virtual_us, __ATOMIC_RELAXED);
+}
+
+void host_critical_enter(portMUX_TYPE *mux) {
+    (void) mux;
+    pthread_mutex_lock(&s_crit);
+}
+
+void host_critical_exit(portMUX_TYPE *mux) {
+    (void) mux;
+    pthread_mutex_unlock(&s_crit);
+}
+
+/* ---------------- task ---------------- */
+
+typedef struct {
+    TaskFunction_t fn;
+    void          *arg;
+} host_task_t;
+
+static __thread int s_core_id = 0;
+
+static void *task_entry(void *p) {
+    host_task_t t = *(host_task_t *) p;
+    free(p);
+    t.fn(t.arg);
+    return NULL;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (s_sim_time) {
+        host_time_advance_us((int64_t) ticks * 1000);
+        sched_yield();
+    } else {
+        usleep((useconds_t) ticks * 1000);
+    }
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t) (esp_timer_get_time() / 1000);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core) {
+    (void) name;
+    (void) stack;
+    (void) prio;
+    (void) core;
+    pthread_t    th;
+    host_task_t *t = (host_task_t *) malloc(sizeof(host_task_t));
+    t->fn          = fn;
+    t->arg         = arg;
+    if (pthread_create(&th, NULL, task_entry, t) != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(th);
+    if (handle) {
+        *handle = (TaskHandle_t) (uintptr_t) th;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, tskNO_AFFINITY);
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return s_core_id;
+}
+
+/* ---------------- wait helper ---------------- */
+
+static int wait_cond(pthread_cond_t *cond, pthread_mutex_t *mtx, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return pthread_cond_wait(cond, mtx);
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long) (ticks % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(cond, mtx, &ts);
+}
+
+/* ---------------- semaphore ---------------- */
+
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+    UBaseType_t     count;
+    UBaseType_t     max;
+} host_sem_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init) {
+    host_sem_t *s = (host_sem_t *) calloc(1, sizeof(host_sem_t));
+    pthread_mutex_init(&s->mtx, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->count = init;
+    s->max   = max;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    host_sem_t *s = (host_sem_t *) sem;
+    pthread_mutex_lock(&s->mtx);
+    while (s->count == 0) {
+        if (ticks == 0 || wait_cond(&s->cond, &s->mtx, ticks) == ETIMEDOUT) {
+            if (s->count == 0) {
+                pthread_mutex_unlock(&s->mtx);
+                return pdFALSE;
+            }
+        }
+    }
+    s->count--;
+    pthread_mutex_unlock(&s->mtx);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    host_sem_t *s = (host_sem_t *) sem;
+    BaseType_t  r = pdFALSE;
+    pthread_mutex_lock(&s->mtx);
+    if (s->count < s->max) {
+        s->count++;
+        r = pdTRUE;
+        pthread_cond_signal(&s->cond);
+    }
+    pthread_mutex_unlock(&s->mtx);
+    return r;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    host_sem_t *s = (host_sem_t *) sem;
+    pthread_mutex_destroy(&s->mtx);
+    pthread_cond_destroy(&s->cond);
+    free(s);
+}
+
+/* ---------------- queue ---------------- */
+
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+    uint8_t        *data;
+    UBaseType_t     len;
+    UBaseType_t     item;
+    UBaseType_t     head;
+    UBaseType_t     count;
+} host_queue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    host_queue_t *q = (host_queue_t *) calloc(1, sizeof(host_queue_t));
+    pthread_mutex_init(&q->mtx, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->data = (uint8_t *) malloc((size_t) length * item_size);
+    q->len  = length;
+    q->item = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    host_queue_t *q = (host_queue_t *) queue;
+    pthread_mutex_lock(&q->mtx);
+    while (q->count == q->len) {
+        if (ticks == 0 || wait_cond(&q->cond, &q->mtx, ticks) == ETIMEDOUT) {
+            if (q->count == q->len) {
+                pthread_mutex_unlock(&q->mtx);
+                return pdFALSE;
+            }
+        }
+    }
+    memcpy(q->data + ((q->head + q->count) % q->len) * q->item, item, q->item);
+    q->count++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mtx);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    host_queue_t *q = (host_queue_t *) queue;
+    pthread_mutex_lock(&q->mtx);
+    while (q->count == 0) {
+        if (ticks == 0 || wait_cond(&q->cond, &q->mtx, ticks) == ETIMEDOUT) {
+            if (q->count == 0) {
+                pthread_mutex_unlock(&q->mtx);
+                return pdFALSE;
+            }
+        }
+    }
+    memcpy(item, q->data + q->head * q->item, q->item);
+    q->head = (q->head + 1) % q->len;
+    q->count--;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mtx);
+    return pdTRUE;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    host_queue_t *q = (host_queue_t *) queue;
+    pthread_mutex_destroy(&q->mtx);
+    pthread_cond_destroy(&q->cond);
+    free(q->data);
+    free(q);
+}
+
+/* ---------------- event group ---------------- */
+
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+    EventBits_t     bits;
+} host_group_t;
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    host_group_t *g = (host_group_t *) calloc(1, sizeof(host_group_t));
+    pthread_mutex_init(&g->mtx, NULL);
+    pthread_cond_init(&g->cond, NULL);
+    return g;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    host_group_t *g = (host_group_t *) group;
+    pthread_mutex_lock(&g->mtx);
+    g->bits |= bits;
+    EventBits_t r = g->bits;
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->mtx);
+    return r;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    host_group_t *g = (host_group_t *) group;
+    pthread_mutex_lock(&g->mtx);
+    EventBits_t r = g->bits;
+    g->bits &= ~bits;
+    pthread_mutex_unlock(&g->mtx);
+    return r;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    host_group_t *g = (host_group_t *) group;
+    pthread_mutex_lock(&g->mtx);
+    EventBits_t r = g->bits;
+    pthread_mutex_unlock(&g->mtx);
+    return r;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t ticks) {
+    host_group_t *g = (host_group_t *) group;
+    pthread_mutex_lock(&g->mtx);
+    for (;;) {
+        EventBits_t hit = g->bits & bits;
+        if ((all && hit == bits) || (!all && hit)) {
+            break;
+        }
+        if (ticks == 0 || wait_cond(&g->cond, &g->mtx, ticks) == ETIMEDOUT) {
+            break;
+        }
+    }
+    EventBits_t r = g->bits;
+    if (clear && (((r & bits) == bits) || (!all && (r & bits)))) {
+        g->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&g->mtx);
+    return r;
+}
@@ -0,0 +1,177 @@
+/* host build: esp_new_jpeg decoder API on top of libjpeg (RGB888 / RGB565, 0 degree only) */
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include "esp_jpeg_dec.h"
+
+typedef struct {
+    struct jpeg_error_mgr pub;
+    jmp_buf               jmp;
+} host_jpeg_err_t;
+
+typedef struct {
+    jpeg_dec_config_t             cfg;
+    struct jpeg_decompress_struct cinfo;
+    host_jpeg_err_t               jerr;
+    int                           started;
+    int                           block_rows;
+} host_jpeg_t;
+
+static void host_jpeg_error_exit(j_common_ptr cinfo) {
+    host_jpeg_err_t *err = (host_jpeg_err_t *) cinfo->err;
+    longjmp(err->jmp, 1);
+}
+
+static int bytes_per_pixel(jpeg_pixel_format_t fmt) {
+    switch (fmt) {
+        case JPEG_PIXEL_FORMAT_GRAY:
+            return 1;
+        case JPEG_PIXEL_FORMAT_RGB888:
+            return 3;
+        case JPEG_PIXEL_FORMAT_RGB565_LE:
+        case JPEG_PIXEL_FORMAT_RGB565_BE:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+void *jpeg_calloc_align(size_t size, int aligned) {
+    void *p = NULL;
+    if (posix_memalign(&p, aligned < (int) sizeof(void *) ? sizeof(void *) : (size_t) aligned, size) != 0) {
+        return NULL;
+    }
+    memset(p, 0, size);
+    return p;
+}
+
+void jpeg_free_align(void *data) {
+    free(data);
+}
+
+jpeg_error_t jpeg_dec_open(jpeg_dec_config_t *config, jpeg_dec_handle_t *jpeg_dec) {
+    if (config == NULL || jpeg_dec == NULL) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    if (bytes_per_pixel(config->output_type) == 0 || config->rotate != JPEG_ROTATE_0D) {
+        return JPEG_ERR_UNSUPPORT_FMT;
+    }
+    host_jpeg_t *h = (host_jpeg_t *) calloc(1, sizeof(host_jpeg_t));
+    if (h == NULL) {
+        return JPEG_ERR_NO_MEM;
+    }
+    h->cfg              = *config;
+    h->cinfo.err        = jpeg_std_error(&h->jerr.pub);
+    h->jerr.pub.error_exit = host_jpeg_error_exit;
+    jpeg_create_decompress(&h->cinfo);
+    *jpeg_dec = h;
+    return JPEG_ERR_OK;
+}
+
+jpeg_error_t jpeg_dec_parse_header(jpeg_dec_handle_t jpeg_dec, jpeg_dec_io_t *io, jpeg_dec_header_info_t *out_info) {
+    host_jpeg_t *h = (host_jpeg_t *) jpeg_dec;
+    if (h == NULL || io == NULL || io->inbuf == NULL) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    if (setjmp(h->jerr.jmp)) {
+        return JPEG_ERR_BAD_DATA;
+    }
+    jpeg_mem_src(&h->cinfo, io->inbuf, (unsigned long) io->inbuf_len);
+    if (jpeg_read_header(&h->cinfo, TRUE) != JPEG_HEADER_OK) {
+        return JPEG_ERR_BAD_DATA;
+    }
+    h->cinfo.out_color_space = (h->cfg.output_type == JPEG_PIXEL_FORMAT_GRAY) ? JCS_GRAYSCALE : JCS_RGB;
+    h->block_rows            = h->cinfo.max_v_samp_factor * 8;
+    io->inbuf_remain         = 0;
+    if (out_info) {
+        out_info->width  = (uint16_t) h->cinfo.image_width;
+        out_info->height = (uint16_t) h->cinfo.image_height;
+    }
+    return JPEG_ERR_OK;
+}
+
+jpeg_error_t jpeg_dec_get_outbuf_len(jpeg_dec_handle_t jpeg_dec, int *outbuf_len) {
+    host_jpeg_t *h = (host_jpeg_t *) jpeg_dec;
+    int          bpp = bytes_per_pixel(h->cfg.output_type);
+    int          rows = h->cfg.block_enable ? h->block_rows : (int) h->cinfo.image_height;
+    *outbuf_len      = (int) h->cinfo.image_width * rows * bpp;
+    return JPEG_ERR_OK;
+}
+
+jpeg_error_t jpeg_dec_get_process_count(jpeg_dec_handle_t jpeg_dec, int *count) {
+    host_jpeg_t *h = (host_jpeg_t *) jpeg_dec;
+    *count         = h->cfg.block_enable ? (int) ((h->cinfo.image_height + h->block_rows - 1) / h->block_rows) : 1;
+    return JPEG_ERR_OK;
+}
+
+static void convert_row(const host_jpeg_t *h, const uint8_t *rgb, uint8_t *dst) {
+    int w = (int) h->cinfo.output_width;
+    if (h->cfg.output_type == JPEG_PIXEL_FORMAT_RGB888 || h->cfg.output_type == JPEG_PIXEL_FORMAT_GRAY) {
+        memcpy(dst, rgb, (size_t) w * bytes_per_pixel(h->cfg.output_type));
+        return;
+    }
+    for (int x = 0; x < w; x++) {
+        uint16_t c = (uint16_t) (((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3));
+        if (h->cfg.output_type == JPEG_PIXEL_FORMAT_RGB565_LE) {
+            dst[0] = c & 0xFF;
+            dst[1] = c >> 8;
+        } else {
+            dst[0] = c >> 8;
+            dst[1] = c & 0xFF;
+        }
+        rgb += 3;
+        dst += 2;
+    }
+}
+
+jpeg_error_t jpeg_dec_process(jpeg_dec_handle_t jpeg_dec, jpeg_dec_io_t *io) {
+    host_jpeg_t *h = (host_jpeg_t *) jpeg_dec;
+    if (h == NULL || io == NULL || io->outbuf == NULL) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    uint8_t *row = NULL;
+    if (setjmp(h->jerr.jmp)) {
+        free(row);
+        return JPEG_ERR_BAD_DATA;
+    }
+    if (!h->started) {
+        jpeg_start_decompress(&h->cinfo);
+        h->started = 1;
+    }
+    int      bpp    = bytes_per_pixel(h->cfg.output_type);
+    int      stride = (int) h->cinfo.output_width * bpp;
+    int      rows   = h->cfg.block_enable ? h->block_rows : (int) h->cinfo.output_height;
+    uint8_t *dst    = io->outbuf;
+    row             = (uint8_t *) malloc((size_t) h->cinfo.output_width * h->cinfo.output_components);
+    if (row == NULL) {
+        return JPEG_ERR_NO_MEM;
+    }
+    int done = 0;
+    while (done < rows && h->cinfo.output_scanline < h->cinfo.output_height) {
+        JSAMPROW rp = row;
+        jpeg_read_scanlines(&h->cinfo, &rp, 1);
+        convert_row(h, row, dst);
+        dst += stride;
+        done++;
+    }
+    free(row);
+    io->out_size = done * stride;
+    if (h->cinfo.output_scanline >= h->cinfo.output_height) {
+        jpeg_finish_decompress(&h->cinfo);
+        h->started = 0;
+    }
+    return JPEG_ERR_OK;
+}
+
+jpeg_error_t jpeg_dec_close(jpeg_dec_handle_t jpeg_dec) {
+    host_jpeg_t *h = (host_jpeg_t *) jpeg_dec;
+    if (h == NULL) {
+        return JPEG_ERR_INVALID_PARAM;
+    }
+    if (!setjmp(h->jerr.jmp)) {
+        jpeg_destroy_decompress(&h->cinfo);
+    }
+    free(h);
+    return JPEG_ERR_OK;
+}
@@ -0,0 +1,38 @@
+/* host build: SD card mount stand-in, files are served by host_vfs.c */
+#include "esp_vfs_fat.h"
+
+static sdmmc_card_t s_card = {SDMMC_FREQ_HIGHSPEED, 32u * 1024 * 1024 * 2, 512, 0};
+
+esp_err_t esp_vfs_fat_sdmmc_mount(const char *base_path, const sdmmc_host_t *host, const void *slot_config,
+                                  const esp_vfs_fat_sdmmc_mount_config_t *mount_config, sdmmc_card_t **out_card) {
+    (void) base_path;
+    (void) slot_config;
+    (void) mount_config;
+    s_card.max_freq_khz = host ? host->max_freq_khz : SDMMC_FREQ_DEFAULT;
+    s_card.is_ddr       = host && (host->flags & SDMMC_HOST_FLAG_DDR) && host->max_freq_khz == SDMMC_FREQ_DDR50;
+    *out_card           = &s_card;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_sdcard_unmount(const char *base_path, sdmmc_card_t *card) {
+    (void) base_path;
+    (void) card;
+    return ESP_OK;
+}
+
+void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *card) {
+    (void) stream;
+    (void) card;
+}
+
+esp_err_t sdmmc_get_status(sdmmc_card_t *card) {
+    return card ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t sdmmc_read_sectors(sdmmc_card_t *card, void *dst, size_t start_sector, size_t sector_count) {
+    if (card == NULL || start_sector + sector_count > card->capacity_sectors) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(dst, 0, sector_count * card->sector_size);
+    return ESP_OK;
+}
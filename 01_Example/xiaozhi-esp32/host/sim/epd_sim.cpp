@@ -0,0 +1,202 @@
+#include <string.h>
+#include <png.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "epd_sim.h"
+#include "host_mock.h"
+
+/*面板颜色编号 -> 显示用RGB,4 不是有效颜色,用品红标出*/
+static const uint8_t EpdSimColorRGB[8][3] = {
+    {0x00, 0x00, 0x00},    /*Black*/
+    {0xFF, 0xFF, 0xFF},    /*White*/
+    {0xFF, 0xFF, 0x00},    /*Yellow*/
+    {0xFF, 0x00, 0x00},    /*Red*/
+    {0xFF, 0x00, 0xFF},    /*无效*/
+    {0x00, 0x00, 0xFF},    /*Blue*/
+    {0x00, 0xFF, 0x00},    /*Green*/
+    {0xFF, 0x00, 0xFF},    /*无效*/
+};
+
+EpdSimPanel::EpdSimPanel(int dc, int cs, int rst, int busy, const EpdSimTiming_t &timing) :
+dc_(dc),
+cs_(cs),
+rst_(rst),
+busy_(busy),
+timing_(timing) {
+    memset(ram_, 0x11, sizeof(ram_));
+    memset(glass_, 0x11, sizeof(glass_));
+}
+
+EpdSimPanel::~EpdSimPanel() {
+    EpdSim_Detach();
+}
+
+void EpdSimPanel::EpdSim_Attach() {
+    host_gpio_set_hook(EpdSim_GpioHook, this);
+    host_gpio_set_input_source(EpdSim_InputSource, this);
+    host_spi_set_tx_hook(EpdSim_SpiHook, this);
+}
+
+void EpdSimPanel::EpdSim_Detach() {
+    host_gpio_set_hook(NULL, NULL);
+    host_gpio_set_input_source(NULL, NULL);
+    host_spi_set_tx_hook(NULL, NULL);
+}
+
+bool EpdSimPanel::EpdSim_IsBusy() {
+    return esp_timer_get_time() < busyUntil_;
+}
+
+void EpdSimPanel::EpdSim_SetBusy(uint32_t ms) {
+    int64_t now  = esp_timer_get_time();
+    busyUntil_   = now + (int64_t) ms * 1000;
+    busyCommand_ = command_;
+    stats_.busy_us += (int64_t) ms * 1000;
+}
+
+void EpdSimPanel::EpdSim_GpioHook(int pin, int level, void *ctx) {
+    EpdSimPanel *self = (EpdSimPanel *) ctx;
+    if (pin == self->dc_) {
+        self->dcLevel_ = level;
+    } else if (pin == self->rst_) {
+        if (self->rstLevel_ == 0 && level == 1) {
+            /*复位:控制器回到上电状态,显存内容不定,这里保持不变*/
+            self->powered_ = false;
+            self->command_ = 0xFF;
+            self->EpdSim_SetBusy(self->timing_.reset_ms);
+        }
+        self->rstLevel_ = level;
+    }
+}
+
+int EpdSimPanel::EpdSim_InputSource(int pin, void *ctx) {
+    EpdSimPanel *self = (EpdSimPanel *) ctx;
+    if (pin == self->busy_) {
+        return self->EpdSim_IsBusy() ? 0 : 1;
+    }
+    return 1;
+}
+
+void EpdSimPanel::EpdSim_SpiHook(const uint8_t *data, size_t len, void *ctx) {
+    EpdSimPanel *self = (EpdSimPanel *) ctx;
+    int64_t      us   = (int64_t) len * 8 * 1000000 / self->timing_.spi_hz + self->timing_.spi_txn_us;
+    self->stats_.spi_us += us;
+    host_time_advance_us(us);
+    /*刷新/上电命令自带的参数字节在 BUSY 拉低后才发出,不算违规*/
+    if (self->EpdSim_IsBusy() && (self->dcLevel_ == 0 || self->command_ != self->busyCommand_)) {
+        self->stats_.busy_violations++;
+        ESP_LOGW(self->TAG, "write while busy, cmd:0x%02x len:%u", self->dcLevel_ ? self->command_ : data[0], (unsigned) len);
+    }
+    if (self->dcLevel_ == 0) {
+        for (size_t i = 0; i < len; i++) {
+            self->EpdSim_Command(data[i]);
+        }
+    } else {
+        self->EpdSim_Data(data, len);
+    }
+}
+
+void EpdSimPanel::EpdSim_Command(uint8_t cmd) {
+    command_   = cmd;
+    dataIndex_ = 0;
+    stats_.commands++;
+    switch (cmd) {
+        case 0x10:        /*DATA_START_TRANSMISSION*/
+            stats_.frame_bytes = 0;
+            break;
+        case 0x04:        /*POWER_ON*/
+            powered_ = true;
+            EpdSim_SetBusy(timing_.power_on_ms);
+            break;
+        case 0x12:        /*DISPLAY_REFRESH*/
+            if (!powered_) {
+                ESP_LOGE(TAG, "refresh without power on");
+            }
+            if (stats_.frame_bytes != Panel::FrameBytes) {
+                stats_.frame_size_errors++;
+                ESP_LOGE(TAG, "refresh with %u/%u frame bytes", (unsigned) stats_.frame_bytes, (unsigned) Panel::FrameBytes);
+            }
+            memcpy(glass_, ram_, sizeof(glass_));
+            stats_.refreshes++;
+            EpdSim_SetBusy(timing_.refresh_ms);
+            break;
+        case 0x02:        /*POWER_OFF*/
+            powered_ = false;
+            EpdSim_SetBusy(timing_.power_off_ms);
+            break;
+        default:
+            break;
+    }
+}
+
+void EpdSimPanel::EpdSim_Data(const uint8_t *data, size_t len) {
+    stats_.data_bytes += len;
+    if (command_ == 0x10) {
+        size_t room = sizeof(ram_) - stats_.frame_bytes;
+        size_t n    = (len < room) ? len : room;
+        memcpy(ram_ + stats_.frame_bytes, data, n);
+        stats_.frame_bytes += len;
+    } else if (command_ == 0x61) {   /*TRES*/
+        for (size_t i = 0; i < len; i++, dataIndex_++) {
+            switch (dataIndex_) {
+                case 0: resWidth_  = (uint16_t) (data[i] << 8); break;
+                case 1: resWidth_ |= data[i]; break;
+                case 2: resHeight_ = (uint16_t) (data[i] << 8); break;
+                case 3:
+                    resHeight_ |= data[i];
+                    if (resWidth_ != Panel::Width || resHeight_ != Panel::Height) {
+                        ESP_LOGE(TAG, "resolution %ux%u, panel is %ux%u", resWidth_, resHeight_, Panel::Width, Panel::Height);
+                    }
+                    break;
+                default: break;
+            }
+        }
+        return;
+    }
+    dataIndex_ += len;
+}
+
+const uint8_t *EpdSimPanel::EpdSim_GetGlass() {
+    return glass_;
+}
+
+const EpdSimStats_t &EpdSimPanel::EpdSim_GetStats() {
+    return stats_;
+}
+
+bool EpdSimPanel::EpdSim_SavePng(const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "open %s fail", path);
+        return false;
+    }
+    png_structp png  = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop   info = png ? png_create_info_struct(png) : NULL;
+    uint8_t     row[Panel::Width * 3];
+    if (info == NULL || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        fclose(fp);
+        return false;
+    }
+    png_init_io(png, fp);
+    png_set_IHDR(png, info, Panel::Width, Panel::Height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    for (int y = 0; y < Panel::Height; y++) {
+        for (int x = 0; x < Panel::Width; x++) {
+            uint8_t px = EpdPanel::GetPixel<Panel::Width>(glass_, x, y) & 0x07;
+            memcpy(row + x * 3, EpdSimColorRGB[px], 3);
+        }
+        png_write_row(png, row);
+    }
+    png_write_end(png, NULL);
+    png_destroy_write_struct(&png, &info);
+    fclose(fp);
+    return true;
+}
+
+void EpdSimPanel::EpdSim_PrintStats(FILE *fp) {
+    fprintf(fp, "panel: commands:%u data:%u bytes refreshes:%u busy:%.1f ms spi:%.1f ms busy_violations:%u frame_errors:%u\n",
+            (unsigned) stats_.commands, (unsigned) stats_.data_bytes, (unsigned) stats_.refreshes, stats_.busy_us / 1000.0,
+            stats_.spi_us / 1000.0, (unsigned) stats_.busy_violations, (unsigned) stats_.frame_size_errors);
+}
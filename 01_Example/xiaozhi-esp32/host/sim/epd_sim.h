@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "epd_panel_traits.h"
+
+/*BUSY 拉低时长和SPI速率,默认值按 7.3" Spectra 6 面板实测量级*/
+typedef struct {
+    uint32_t reset_ms     = 20;       /*RST 上升沿之后*/
+    uint32_t power_on_ms  = 150;      /*0x04 POWER_ON*/
+    uint32_t refresh_ms   = 19000;    /*0x12 DISPLAY_REFRESH*/
+    uint32_t power_off_ms = 50;       /*0x02 POWER_OFF*/
+    uint32_t spi_hz       = 40 * 1000 * 1000;
+    uint32_t spi_txn_us   = 4;        /*每次 polling_transmit 的固定开销*/
+} EpdSimTiming_t;
+
+typedef struct {
+    uint32_t commands;
+    uint32_t data_bytes;
+    uint32_t frame_bytes;             /*最近一次 0x10 写入的字节数*/
+    uint32_t refreshes;
+    uint32_t busy_violations;         /*BUSY 为低时仍在发送*/
+    uint32_t frame_size_errors;       /*0x12 时显存写入不完整*/
+    int64_t  busy_us;                 /*BUSY 为低的总时长*/
+    int64_t  spi_us;                  /*按 SPI 时钟折算的传输时间*/
+} EpdSimStats_t;
+
+/*
+ * 虚拟墨水屏:挂在 mock SPI/GPIO 上,解析 ePaperPort 发出的命令/数据流
+ * 0x10 写入显存,0x12 刷新时把显存拷到"屏幕",可导出PNG
+ * BUSY 引脚按 EpdSimTiming_t 在虚拟时钟上拉低,EPD_LoopBusy 的 vTaskDelay 会推进虚拟时间
+ */
+class EpdSimPanel
+{
+public:
+    typedef EpdActivePanel Panel;
+
+private:
+    const char    *TAG = "EpdSim";
+    int            dc_;
+    int            cs_;
+    int            rst_;
+    int            busy_;
+    EpdSimTiming_t timing_;
+    EpdSimStats_t  stats_      = {};
+    int            dcLevel_    = 1;
+    int            rstLevel_   = 1;
+    uint8_t        command_    = 0;
+    uint32_t       dataIndex_  = 0;      /*当前命令之后的第几个数据字节*/
+    int64_t        busyUntil_  = 0;
+    uint8_t        busyCommand_ = 0xFF;   /*使 BUSY 拉低的命令*/
+    bool           powered_    = false;
+    uint16_t       resWidth_   = Panel::Width;
+    uint16_t       resHeight_  = Panel::Height;
+    uint8_t        ram_[Panel::FrameBytes];
+    uint8_t        glass_[Panel::FrameBytes];
+
+    static void EpdSim_GpioHook(int pin, int level, void *ctx);
+    static int  EpdSim_InputSource(int pin, void *ctx);
+    static void EpdSim_SpiHook(const uint8_t *data, size_t len, void *ctx);
+    void        EpdSim_SetBusy(uint32_t ms);
+    void        EpdSim_Command(uint8_t cmd);
+    void        EpdSim_Data(const uint8_t *data, size_t len);
+
+public:
+    EpdSimPanel(int dc, int cs, int rst, int busy, const EpdSimTiming_t &timing = EpdSimTiming_t());
+    ~EpdSimPanel();
+
+    void                 EpdSim_Attach();                     /*接管 mock SPI/GPIO*/
+    void                 EpdSim_Detach();
+    bool                 EpdSim_IsBusy();
+    const uint8_t       *EpdSim_GetGlass();                   /*最近一次刷新后屏幕上的内容,800x480 4bpp*/
+    const EpdSimStats_t &EpdSim_GetStats();
+    bool                 EpdSim_SavePng(const char *path);
+    void                 EpdSim_PrintStats(FILE *fp);
+};
@@ -0,0 +1,197 @@
+/*
+ * 虚拟墨水屏运行模式流程,输出每次唤醒的各阶段耗时(虚拟设备时间)和屏幕截图
+ *
+ * epd_sim [--mode basic|photodaily] [--wakeups N] [--image PATH] [--out DIR] [--sdcard DIR]
+ *         [--refresh-ms N] [--net-kbps N] [--verbose]
+ *
+ * basic      : 与 Basic_mode 相同,每次唤醒 打开图库索引 -> EPD_Init -> 按 playlist 配置取 06_user_foundation_img 中的下一张图片缩放抖动 -> 刷新 -> 休眠
+ * photodaily : 与 Photo_Daily_mode 相同,每次唤醒"下载"一张图片到内存 -> EPD_Init -> EPD_MemoryBmpShakingColor(已抖动的BMP)
+ *              或 EPD_MemoryIMGShakingColor(jpg/png) -> 刷新 -> 等待5秒 -> 休眠
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "display_bsp.h"
+#include "sdcard_bsp.h"
+#include "sd_library.h"
+#include "sd_playlist.h"
+#include "render_profiler.h"
+#include "host_mock.h"
+#include "epd_sim.h"
+
+#define SIM_EPD_DC   8
+#define SIM_EPD_CS   9
+#define SIM_EPD_RST  12
+#define SIM_EPD_BUSY 13
+
+typedef struct {
+    int64_t init_us;
+    int64_t fetch_us;
+    int64_t render_us;
+    int64_t display_us;
+    int64_t total_us;
+} SimWakeTiming_t;
+
+static RenderArena     renderArena(ePaperPort::ArenaSize);
+static ImgDecodeDither decdither(&renderArena);
+static ePaperPort      ePaperDisplay(decdither, renderArena, 11, 10, SIM_EPD_DC, SIM_EPD_CS, SIM_EPD_RST, SIM_EPD_BUSY, 1350, 1350);
+
+static void Sim_PrintWake(const char *mode, int n, const char *image, const SimWakeTiming_t &t) {
+    printf("%-10s wake %-3d init %8.1f ms  fetch %8.1f ms  render %8.1f ms  display %9.1f ms  awake %9.1f ms  %s\n", mode, n,
+           t.init_us / 1000.0, t.fetch_us / 1000.0, t.render_us / 1000.0, t.display_us / 1000.0, t.total_us / 1000.0, image);
+}
+
+/*Basic_mode: boot_button_user_Task + default_sleep_user_Task*/
+static void Sim_BasicMode(EpdSimPanel &panel, int wakeups, const std::string &out) {
+    SDPlaylistState_t state = {};     /*RTC 内存*/
+    for (int n = 0; n < wakeups; n++) {
+        SimWakeTiming_t t  = {};
+        int64_t         t0 = esp_timer_get_time();
+        /*每次唤醒都是重新启动:第一次相当于上电(校验并建立索引),之后是深度睡眠唤醒,直接读索引*/
+        SDLibrary library("/sdcard/06_user_foundation_img");
+        library.SDLibrary_Open(n == 0);
+        SDPlaylist playlist(&library, &state);
+        playlist.SDPlaylist_LoadConfig();
+        if (library.SDLibrary_Count() == 0) {
+            fprintf(stderr, "no image in /sdcard/06_user_foundation_img\n");
+            return;
+        }
+        int64_t tl = esp_timer_get_time();
+        ePaperDisplay.EPD_Init();
+        int64_t t1 = esp_timer_get_time();
+
+        char name[SD_LIBRARY_PATH_MAX];
+        if (playlist.SDPlaylist_Next(name, sizeof(name)) < 0) {
+            fprintf(stderr, "no image in /sdcard/06_user_foundation_img\n");
+            return;
+        }
+        bool    drawn = ePaperDisplay.EPD_SDcardScaleIMGShakingColor(name, 0, 0);
+        int64_t t2    = esp_timer_get_time();
+        if (drawn) {
+            ePaperDisplay.EPD_Display();
+        }
+        int64_t t3 = esp_timer_get_time();
+        vTaskDelay(pdMS_TO_TICKS(500));        /*进入深度睡眠前的等待*/
+
+        t.fetch_us   = tl - t0;
+        t.init_us    = t1 - tl;
+        t.render_us  = t2 - t1;
+        t.display_us = t3 - t2;
+        t.total_us   = esp_timer_get_time() - t0;
+        Sim_PrintWake("basic", n, name, t);
+        panel.EpdSim_SavePng((out + "/basic_" + std::to_string(n) + ".png").c_str());
+    }
+}
+
+/*Photo_Daily_mode: fetch_and_display_image + 刷新后等待5秒*/
+static void Sim_PhotoDailyMode(EpdSimPanel &panel, int wakeups, const std::string &image, uint32_t net_kbps, const std::string &out) {
+    const size_t bufferSize = 1536 * 1024;
+    for (int n = 0; n < wakeups; n++) {
+        SimWakeTiming_t t  = {};
+        int64_t         t0 = esp_timer_get_time();
+
+        uint8_t *image_buffer = (uint8_t *) heap_caps_malloc(bufferSize, MALLOC_CAP_SPIRAM);
+        FILE    *fp           = fopen(image.c_str(), "rb");
+        if (fp == NULL || image_buffer == NULL) {
+            fprintf(stderr, "open %s fail\n", image.c_str());
+            if (fp) {
+                fclose(fp);
+            }
+            heap_caps_free(image_buffer);
+            return;
+        }
+        int total_len = (int) fread(image_buffer, 1, bufferSize, fp);
+        fclose(fp);
+        if (net_kbps) {
+            host_time_advance_us((int64_t) total_len * 8 * 1000 / net_kbps);
+        }
+        int64_t t1 = esp_timer_get_time();
+
+        ePaperDisplay.EPD_Init();
+        int64_t t2 = esp_timer_get_time();
+        bool drawn = true;
+        if (total_len >= 2 && image_buffer[0] == 'B' && image_buffer[1] == 'M') {
+            drawn = ePaperDisplay.EPD_MemoryBmpShakingColor(image_buffer, total_len, 0, 0);
+        } else {
+            drawn = ePaperDisplay.EPD_MemoryIMGShakingColor(image_buffer, total_len, image.c_str());
+        }
+        int64_t t3 = esp_timer_get_time();
+        if (drawn) {
+            ePaperDisplay.EPD_Display();
+        }
+        int64_t t4 = esp_timer_get_time();
+        heap_caps_free(image_buffer);
+        vTaskDelay(pdMS_TO_TICKS(5000));       /*给用户查看的时间,然后深度睡眠*/
+
+        t.fetch_us   = t1 - t0;
+        t.init_us    = t2 - t1;
+        t.render_us  = t3 - t2;
+        t.display_us = t4 - t3;
+        t.total_us   = esp_timer_get_time() - t0;
+        Sim_PrintWake("photodaily", n, image.c_str(), t);
+        panel.EpdSim_SavePng((out + "/photodaily_" + std::to_string(n) + ".png").c_str());
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string    mode    = "basic";
+    std::string    sdcard  = HOST_SDCARD_DIR;
+    std::string    image   = "/sdcard/01_sys_init_img/00_init.bmp";
+    std::string    out     = "sim_out";
+    int            wakeups = 3;
+    uint32_t       netKbps = 2000;
+    EpdSimTiming_t timing;
+    host_log_level = ESP_LOG_ERROR;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--mode") && i + 1 < argc) {
+            mode = argv[++i];
+        } else if (!strcmp(argv[i], "--wakeups") && i + 1 < argc) {
+            wakeups = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--image") && i + 1 < argc) {
+            image = argv[++i];
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            out = argv[++i];
+        } else if (!strcmp(argv[i], "--sdcard") && i + 1 < argc) {
+            sdcard = argv[++i];
+        } else if (!strcmp(argv[i], "--refresh-ms") && i + 1 < argc) {
+            timing.refresh_ms = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--net-kbps") && i + 1 < argc) {
+            netKbps = (uint32_t) atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--verbose")) {
+            host_log_level = ESP_LOG_INFO;
+        } else {
+            fprintf(stderr, "usage: %s [--mode basic|photodaily] [--wakeups N] [--image PATH] [--out DIR] [--sdcard DIR] "
+                            "[--refresh-ms N] [--net-kbps N] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+    mkdir(out.c_str(), 0755);
+    host_vfs_set_root(sdcard.c_str(), (out + "/sdcard").c_str());
+    host_time_set_simulated(1);
+
+    EpdSimPanel panel(SIM_EPD_DC, SIM_EPD_CS, SIM_EPD_RST, SIM_EPD_BUSY, timing);
+    panel.EpdSim_Attach();
+    renderProfiler.RenderProfiler_SetArena(&renderArena);
+
+    int64_t realStart = host_time_get_real_us();
+    int64_t simStart  = esp_timer_get_time();
+    if (mode == "basic") {
+        Sim_BasicMode(panel, wakeups, out);
+    } else if (mode == "photodaily") {
+        Sim_PhotoDailyMode(panel, wakeups, image, netKbps, out);
+    } else {
+        fprintf(stderr, "unknown mode %s\n", mode.c_str());
+        return 2;
+    }
+    renderProfiler.RenderProfiler_DumpToSdcard();     /*设备上默认不写,模拟器总是输出*/
+    printf("device time %.1f s, host time %.1f ms\n", (esp_timer_get_time() - simStart) / 1e6, (host_time_get_real_us() - realStart) / 1000.0);
+    panel.EpdSim_PrintStats(stdout);
+    printf("screenshots and render_profile.json: %s\n", out.c_str());
+    const EpdSimStats_t &st = panel.EpdSim_GetStats();
+    return (st.busy_violations || st.frame_size_errors) ? 1 : 0;
+}
@@ -56,6 +56,11 @@ extern "C" void app_main(void) {
     }
     nvs_close(my_handle);       //Close handle
     ESP_LOGI("Mode_value", "%d", Mode_value);
+    /*Basic 模式定时唤醒:下一张已在 flash 中时直接显示并睡眠,不初始化SD卡
+      上面固定为 0x05(每日一图)时不会走到这里,恢复模式选择并使用 16m_photopainter.csv 分区表后才生效*/
+    if (read_value == 0x01 && User_Basic_mode_flash_wake()) {
+        return;
+    }
     /*Button Press Task Creation*/
     if (User_Mode_init() == 0) {
         ESP_LOGE("init", "init Failure");